@@ -0,0 +1,525 @@
+/*
+ *  @file Bayesian.cpp
+ *  fit_my_ecp
+ *
+ *  Batches are built greedily by the "kriging believer" heuristic of Ginsbourger, Le Riche and Carraro,
+ *  "Kriging is well-suited to parallelize optimization" (2010): after each pick the model is told the
+ *  ECP sits at its predicted function, which lowers the expected improvement around it.
+ *
+ */
+
+#include <algorithm>
+#include "Bayesian.h"
+
+using namespace std;
+
+// Random ECPs scored across the whole box for each batch
+#define BAYES_CANDIDATES 1000
+// Best ECPs so far, and how many random ECPs are scored close to each of them
+#define BAYES_LOCAL_CENTRES 5
+#define BAYES_LOCAL_CANDIDATES 100
+// Distance from the best ECPs for the local candidates, as a fraction of the box
+#define BAYES_LOCAL_RADIUS 0.05
+// Highest scoring candidates kept while the batch is built up
+#define BAYES_SHORTLIST 200
+// Converged once no expected improvement is above this fraction of the range of functions seen
+#define BAYES_TOLERANCE 1e-5
+
+/*
+ Compare two (score, index) pairs, highest score first
+ */
+static bool compare_score(const pair<double,int> &a, const pair<double,int> &b)
+{
+	return a.first > b.first;
+}
+
+/*
+ Constructor
+
+ @param[in/out] seed Pointer to the seed
+ */
+Bayesian::Bayesian(int *seed) : Outputs(seed)
+{
+	// Search area confines
+	step_size_min.resize(2);
+	minimums.resize(2,0.0);
+	maximums.resize(2,0.0);
+
+	batch_size = 1;
+	iterations = 0;
+}
+
+/*
+ Set the initial parameters for the Bayesian optimisation
+
+ @param[in] ss The step size to be initially used for A and zeta (not used)
+ @param[in] sr Step reduction rate for A and zeta (not used)
+ @param[in] ssm Convergence criteria, defined as the closest two ECPs can be and still both be tested, for A and zeta
+ @param[in] min Minimum values for A and zeta
+ @param[in] max Maximum values for A and zeta
+ @param[in] msod Maximum steps in any one direction (not used)
+ */
+void Bayesian::set_parameters(vector< vector<double> > ss,
+			      vector< vector<double> > sr,
+			      vector< vector<double> > ssm,
+			      vector<double> min,
+			      vector<double> max,
+			      int msod)
+{
+	step_size_min = ssm;
+	minimums = min;
+	maximums = max;
+
+	// - step size minimum
+	if (step_size_min[0].size() == 0)
+	{
+		cout << "Using default step size minimum for convergence for A: 1.0" << endl;
+		step_size_min[0].push_back(1.0);
+	}
+	if (step_size_min[1].size() == 0)
+	{
+		cout << "Using default step size minimum for convergence for Z: 0.001" << endl;
+		step_size_min[1].push_back(0.001);
+	}
+
+	// - constraining values for A
+	if (minimums[0] == 0.0)
+	{
+		cout << "Using default constraint of minimum value for A: 0.0" << endl;
+		minimums[0] = 0.0;
+	}
+	if (maximums[0] == 0.0)
+	{
+		cout << "Using default constraint of maximum value for A: 1000" << endl;
+		maximums[0] = 1000.0;
+	}
+	// - constraining values for Z
+	if (minimums[1] == 0.0)
+	{
+		cout << "Using default constraint of minimum value for Z: 0.0" << endl;
+		minimums[1] = 0.0;
+	}
+	if (maximums[1] == 0.0)
+	{
+		cout << "Using default constraint of maximum value for Z: 1000" << endl;
+		maximums[1] = 1000.0;
+	}
+}
+
+/*
+ Set the number of ECPs proposed in each batch
+
+ @param[in] bs Number of ECPs to be tested at once
+ @param[in] ts Total number of ECPs to sample (not used)
+ */
+void Bayesian::set_sample_parameters(int bs, int ts)
+{
+	batch_size = bs > 0 ? bs : 1;
+}
+
+/*
+ Fit the model to the ECPs already in the history as well, if nothing has been tested yet
+
+ @param[in] v All ECPs in the history
+ */
+void Bayesian::set_ecps_history(vector<gaussian> v)
+{
+	if ((iterations > 0) || (lower.size() == 0))
+	{
+		return;
+	}
+
+	vector<gaussian>::size_type added = 0;
+
+	for (vector<gaussian>::size_type i = 0; i < v.size(); i++)
+	{
+		if (usable(v[i]))
+		{
+			evaluated.push_back(v[i]);
+			added++;
+		}
+	}
+
+	if (added > 0)
+	{
+		cout << "Starting the Bayesian optimisation with " << added << " ECPs from the history" << endl;
+		calculate_batch();
+	}
+}
+
+/*
+ Set up the box, then propose the first batch
+
+ No param.
+ */
+void Bayesian::calculate_ecps_to_test()
+{
+	const vector<double>::size_type n = starting_gaussians.values.size();
+
+	lower.resize(n);
+	upper.resize(n);
+
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		const int type = starting_gaussians.values[a].type;
+
+		lower[a] = minimums[type];
+		upper[a] = maximums[type];
+
+		if (upper[a] <= lower[a])
+		{
+			cout << "The maximum must be greater than the minimum for a Bayesian optimisation" << endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (step_size_min[0].size() != n)
+	{
+		step_size_min[0].resize(n,step_size_min[0][0]);
+	}
+	if (step_size_min[1].size() != n)
+	{
+		step_size_min[1].resize(n,step_size_min[1][0]);
+	}
+
+	iterations = 0;
+	evaluated.clear();
+
+	calculate_batch();
+}
+
+/*
+ Add the last batch to the ECPs the model is fitted to, and propose the next one
+
+ No param
+ */
+void Bayesian::check_converged()
+{
+	for (vector<gaussian>::size_type i = 0; i < ecps_tested.size(); i++)
+	{
+		if (usable(ecps_tested[i]))
+		{
+			evaluated.push_back(ecps_tested[i]);
+		}
+	}
+
+	iterations++;
+
+	calculate_batch();
+
+	if (converged)
+	{
+		cout << "Convergence obtained" << endl;
+	}
+}
+
+/*
+ Propose the next batch. Until enough is known about the function the box is filled
+ with a Latin hypercube, then ECPs are picked one at a time by expected improvement
+
+ No param
+ */
+void Bayesian::calculate_batch()
+{
+	Trace_Span span("bayes batch","search");
+
+	const vector<double>::size_type n = lower.size();
+	const vector<gaussian>::size_type design_size = std::max<vector<gaussian>::size_type>(2 * n + 2,10);
+
+	ecps_to_test.clear();
+
+	if (evaluated.size() == 0)
+	{
+		ecps_to_test.push_back(starting_gaussians);
+	}
+
+	if (evaluated.size() < design_size)
+	{
+		calculate_design(std::max<vector<gaussian>::size_type>(batch_size,design_size - evaluated.size()));
+		return;
+	}
+
+	model.fit(evaluated);
+
+	if (!model.get_fitted())
+	{
+		cout << "Too few of the ECPs tested have worked to fit a model. Sampling the box again" << endl;
+		calculate_design(batch_size);
+		return;
+	}
+
+	// Range of functions seen, for the convergence test
+	double function_min = model.get_best();
+	double function_max = function_min;
+
+	for (vector<gaussian>::size_type i = 0; i < evaluated.size(); i++)
+	{
+		if (!evaluated[i].failed && (evaluated[i].function != 888888))
+		{
+			function_max = std::max(function_max,evaluated[i].function);
+		}
+	}
+
+	// Candidates spread over the box, and close to the best ECPs so far
+	vector<gaussian> candidates;
+	vector<double> u(n);
+
+	for (int k = 0; k < BAYES_CANDIDATES; k++)
+	{
+		for (vector<double>::size_type a = 0; a < n; a++)
+		{
+			u[a] = randomNumber(idum);
+		}
+		candidates.push_back(make_gaussian(u));
+	}
+
+	vector< pair<double,int> > ranked;
+
+	for (vector<gaussian>::size_type i = 0; i < evaluated.size(); i++)
+	{
+		if (!evaluated[i].failed && (evaluated[i].function != 888888))
+		{
+			ranked.push_back(make_pair(-evaluated[i].function,i));
+		}
+	}
+
+	sort(ranked.begin(),ranked.end(),compare_score);
+
+	for (vector< pair<double,int> >::size_type c = 0; (c < ranked.size()) && (c < BAYES_LOCAL_CENTRES); c++)
+	{
+		const gaussian &centre = evaluated[ranked[c].second];
+
+		for (int k = 0; k < BAYES_LOCAL_CANDIDATES; k++)
+		{
+			for (vector<double>::size_type a = 0; a < n; a++)
+			{
+				u[a] = (centre.values[a].value - lower[a]) / (upper[a] - lower[a]);
+				u[a] += BAYES_LOCAL_RADIUS * (2.0 * randomNumber(idum) - 1.0);
+
+				// Reflect back in to the box
+				while ((u[a] < 0.0) || (u[a] > 1.0))
+				{
+					u[a] = (u[a] < 0.0) ? -u[a] : 2.0 - u[a];
+				}
+			}
+			candidates.push_back(make_gaussian(u));
+		}
+	}
+
+	// Score them all, and keep the best few for building the batch
+	const double best = model.get_best();
+	vector< pair<double,int> > shortlist;
+
+	for (vector<gaussian>::size_type i = 0; i < candidates.size(); i++)
+	{
+		if (!resolved(candidates[i]))
+		{
+			shortlist.push_back(make_pair(expected_improvement(candidates[i],best),i));
+		}
+	}
+
+	sort(shortlist.begin(),shortlist.end(),compare_score);
+
+	if (shortlist.size() > BAYES_SHORTLIST)
+	{
+		shortlist.resize(BAYES_SHORTLIST);
+	}
+
+	cout << "Bayesian optimisation iteration " << iterations << ": best function " << best;
+	cout << ", fitted to " << model.get_training_size() << " ECPs" << endl;
+
+	if ((shortlist.size() == 0) ||
+	    (shortlist[0].first < BAYES_TOLERANCE * (function_max - function_min)))
+	{
+		cout << "No ECP is expected to improve on the best found" << endl;
+		converged = true;
+		return;
+	}
+
+	cout << "Largest expected improvement: " << shortlist[0].first << endl;
+
+	// Pick one at a time, believing each pick sits at its predicted function
+	while ((ecps_to_test.size() < (vector<gaussian>::size_type) batch_size) && (shortlist.size() > 0))
+	{
+		vector< pair<double,int> >::size_type pick = 0;
+
+		for (vector< pair<double,int> >::size_type i = 0; i < shortlist.size(); i++)
+		{
+			if (ecps_to_test.size() > 0)
+			{
+				shortlist[i].first = expected_improvement(candidates[shortlist[i].second],best);
+			}
+			if (shortlist[i].first > shortlist[pick].first)
+			{
+				pick = i;
+			}
+		}
+
+		const gaussian &g = candidates[shortlist[pick].second];
+		shortlist.erase(shortlist.begin() + pick);
+
+		if (!resolved(g))
+		{
+			ecps_to_test.push_back(g);
+			model.condition(g);
+		}
+	}
+}
+
+/*
+ Fill the batch with a Latin hypercube over the box, jittered within each slice
+
+ @param[in] size Number of ECPs in the hypercube
+ */
+void Bayesian::calculate_design(unsigned int size)
+{
+	const vector<double>::size_type n = lower.size();
+	vector< vector<double> > hypercube(size);
+	vector<unsigned int> slices(size);
+
+	for (unsigned int i = 0; i < size; i++)
+	{
+		hypercube[i].assign(n,0.0);
+	}
+
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		for (unsigned int i = 0; i < size; i++)
+		{
+			slices[i] = i;
+		}
+
+		for (unsigned int i = size - 1; i > 0; i--)
+		{
+			unsigned int j = randomNumber(i + 1, idum);
+			swap(slices[i],slices[j]);
+		}
+
+		for (unsigned int i = 0; i < size; i++)
+		{
+			double r = randomNumber(idum);
+
+			// Keep away from the minimum, which can be an invalid number
+			while (r == 0.0)
+			{
+				r = randomNumber(idum);
+			}
+
+			hypercube[i][a] = (slices[i] + r) / size;
+		}
+	}
+
+	for (unsigned int i = 0; i < size; i++)
+	{
+		ecps_to_test.push_back(make_gaussian(hypercube[i]));
+	}
+
+	cout << "Sampling " << size << " ECPs across the box for the Bayesian optimisation" << endl;
+}
+
+/*
+ Check if an ECP can be added to the ECPs the model is fitted to:
+ the same shape as the starting gaussians, and inside the box.
+ Failed ECPs are kept, so they are not proposed again, but are not fitted
+
+ @param[in] g ECP to check
+ @return True if it belongs to this search
+ */
+bool Bayesian::usable(const gaussian &g)
+{
+	if (g.values.size() != lower.size())
+	{
+		return false;
+	}
+
+	for (vector<gaussian_info>::size_type a = 0; a < g.values.size(); a++)
+	{
+		if ((g.values[a].type != starting_gaussians.values[a].type) ||
+		    (g.values[a].value < lower[a]) ||
+		    (g.values[a].value > upper[a]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ Check if an ECP is within the step size minimum of one already tested,
+ or already in the batch, in every parameter
+
+ @param[in] g ECP to check
+ @return True if there is nothing to learn from testing it
+ */
+bool Bayesian::resolved(const gaussian &g)
+{
+	for (int list = 0; list < 2; list++)
+	{
+		const vector<gaussian> &v = (list == 0) ? evaluated : ecps_to_test;
+
+		for (vector<gaussian>::size_type i = 0; i < v.size(); i++)
+		{
+			bool close = true;
+
+			for (vector<gaussian_info>::size_type a = 0; close && (a < g.values.size()); a++)
+			{
+				close = fabs(g.values[a].value - v[i].values[a].value) < step_size_min[g.values[a].type][a];
+			}
+
+			if (close)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/*
+ Expected improvement on the best function, from the model's prediction
+
+ @param[in] g ECP to score
+ @param[in] best Lowest function seen
+ @return Expected amount by which the ECP betters the best
+ */
+double Bayesian::expected_improvement(const gaussian &g, double best)
+{
+	double mean = 0.0;
+	double deviation = 0.0;
+
+	if (!model.predict(g,&mean,&deviation))
+	{
+		return 0.0;
+	}
+
+	if (deviation <= 0.0)
+	{
+		return std::max(best - mean,0.0);
+	}
+
+	const double z = (best - mean) / deviation;
+	const double cdf = 0.5 * erfc(-z / sqrt(2.0));
+	const double pdf = exp(-0.5 * z * z) / sqrt(2.0 * M_PI);
+
+	return (best - mean) * cdf + deviation * pdf;
+}
+
+/*
+ Create an ECP from a point in the unit cube
+
+ @param[in] u Point in the unit cube
+ @return The starting gaussians with the values scaled into the box
+ */
+gaussian Bayesian::make_gaussian(const vector<double> &u)
+{
+	gaussian g = starting_gaussians;
+
+	for (vector<gaussian_info>::size_type a = 0; a < g.values.size(); a++)
+	{
+		g.values[a].value = lower[a] + u[a] * (upper[a] - lower[a]);
+	}
+
+	return g;
+}
@@ -0,0 +1,122 @@
+/*
+ *  @Bayesian.h
+ *  fit_my_ecp
+ *
+ *  @brief Implementation of a batch Bayesian optimisation. A Gaussian process is fitted
+ *  to every ECP tested so far, and each batch is picked by expected improvement,
+ *  with the ECPs already in the batch believed to sit at their predicted function.
+ *  Inherits some attributes from Outputs, which are rewritten here
+ *
+ */
+
+#ifndef BAYESIAN_H
+#define BAYESIAN_H
+
+#include "Utils.h"
+#include "Outputs.h"
+#include "Surrogate.h"
+
+class Bayesian : public Outputs {
+
+public:
+
+	/*
+	 Constructor
+
+	 No params
+	 */
+	Bayesian(){}
+
+	Bayesian(int *seed);
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Bayesian(){}
+
+	virtual void set_parameters(std::vector< std::vector<double> > ss,
+				    std::vector< std::vector<double> > sr,
+  				    std::vector< std::vector<double> > ssm,
+				    std::vector<double> min,
+				    std::vector<double> max,
+				    int msod);
+
+	virtual void set_sample_parameters(int bs, int ts);
+
+	virtual void set_ecps_history(std::vector<gaussian> v);
+
+	/*
+	 Defines initial ECPs, and sets up class
+
+	 @param[in] v Vector of initial gaussian(s) read in from ecp.template
+	 */
+	void set_starting_gaussians(gaussian v)
+	{
+		starting_gaussians = v;
+		calculate_ecps_to_test();
+	}
+
+	/*
+	 Takes in the details of the last search run, and saves data
+
+	 @param[in] v Vector of ECPs just tested
+	 @param[in] n Index of the highest ranked ECP
+	 */
+	void set_ecps_tested(std::vector<gaussian> v, int n)
+	{
+		ecps_tested = v;
+		check_converged();
+	}
+
+	/*
+	 Method to print the search type being conducted, common with all other search methods
+
+	 No Param
+	 */
+	virtual void print_type()
+	{
+		std::cout << "Performing a Bayesian optimisation" << std::endl;
+	}
+
+protected:
+
+	// Int
+	int batch_size;
+	int iterations;
+	// Vectors
+	std::vector<gaussian> ecps_tested;
+	// Every usable ECP tested so far, which the model is fitted to
+	std::vector<gaussian> evaluated;
+	// Floats
+	std::vector< std::vector<double> > step_size_min;
+	std::vector<double> maximums;
+	std::vector<double> minimums;
+	// Box for each parameter
+	std::vector<double> lower;
+	std::vector<double> upper;
+	// Others
+	Surrogate model;
+
+	virtual void calculate_ecps_to_test();
+
+	virtual void check_converged();
+
+private:
+
+	void calculate_batch();
+
+	void calculate_design(unsigned int size);
+
+	bool usable(const gaussian &g);
+
+	bool resolved(const gaussian &g);
+
+	double expected_improvement(const gaussian &g, double best);
+
+	gaussian make_gaussian(const std::vector<double> &u);
+};
+
+#endif
+
@@ -0,0 +1,822 @@
+/*
+ *  @file Benchmark.cpp
+ *  fit_my_ecp
+ *
+ *  @brief Runs each search in-process against analytic landscapes, to compare how
+ *  many function evaluations they need. Every evaluation stands for a ChemShell
+ *  calculation, so this is the cost that matters. The searches are driven just
+ *  as fit_my_ecp drives them, including the history, so an ECP tested twice is
+ *  only paid for once. Build with "make benchmark"
+ *
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+// Personal headers
+#include "Utils.h"
+#include "IO.h"
+#include "History.h"
+#include "Landscapes.h"
+#include "Outputs.h"
+#include "Bayesian.h"
+#include "Cma_Es.h"
+#include "Genetic.h"
+#include "Islands.h"
+#include "Lbfgs_B.h"
+#include "Linear.h"
+#include "Newton_Raphson.h"
+#include "Powells.h"
+#include "Quasi_Random.h"
+
+using namespace std;
+
+// The box of allowed values is this wide in the scaled distances the landscapes are given
+const double landscape_width = 4.0;
+
+/*
+ Settings shared by every run
+ */
+struct benchmark_settings
+{
+	std::vector< std::vector<double> > step_size;
+	std::vector< std::vector<double> > step_reduction;
+	std::vector< std::vector<double> > step_size_min;
+	std::vector<double> minimums;
+	std::vector<double> maximums;
+	// Number of ECP lines, each with an A and a Z
+	int lines;
+	// Most evaluations for each run, and how many are handed out at once
+	int budget;
+	int batch;
+	// Noise added to the function for the noisy landscapes
+	double noise;
+	// Function to reach, or zero for the default of each landscape
+	double target;
+};
+
+/*
+ What happened in one run
+ */
+struct benchmark_run
+{
+	int evaluations;
+	// Evaluations made when the target was first reached, or -1 if it never was
+	int evaluations_to_target;
+	// Lowest function found, without noise
+	double best;
+	double wall_seconds;
+	bool converged;
+};
+
+/*
+ Help function which prints to screen the options
+
+ No params
+ */
+void help()
+{
+	cout << "Usage: benchmark_searches [options]" << endl;
+	cout << endl;
+	cout << "-h,--help   : Display this message" << endl;
+	cout << endl;
+	cout << "*** Character Values ***" << endl;
+	cout << endl;
+	cout << "--modes=LIST          : Searches to run, as for -f. Also ga_async and ga_islands." << endl;
+	cout << "                        Default: linear,powells,newton,lbfgs,lbfgsb,cmaes,bayes,ga,ga_async,ga_islands,sobol,lhs" << endl;
+	cout << "--landscapes=LIST     : sphere, noisy_sphere, rosenbrock, rastrigin, noisy_rosenbrock, noisy_rastrigin." << endl;
+	cout << "                        Default: sphere,noisy_sphere,rosenbrock,rastrigin" << endl;
+	cout << "-o,--output=FILENAME  : Tab separated summary for each search and landscape. Default: benchmark.tsv" << endl;
+	cout << "--runs_output=FILENAME : Tab separated line for every run. Default: OFF" << endl;
+	cout << endl;
+	cout << "*** Numeric Values ***" << endl;
+	cout << endl;
+	cout << "--seeds=NUMBER        : Runs of each search on each landscape, each from its own random start. Default: 10" << endl;
+	cout << "--budget=NUMBER       : Most function evaluations in a run. Default: 200" << endl;
+	cout << "--sample_batch=NUMBER : ECPs handed out at once by sobol/lhs/powells/cmaes/bayes, or kept running by ga_async. Default: 4" << endl;
+	cout << "--lines=NUMBER        : ECP lines, each with an A and a Z to fit. Default: 2" << endl;
+	cout << "--noise=NUMBER        : Noise on noisy landscapes, spread evenly between -NUMBER and NUMBER. Default: 0.01" << endl;
+	cout << "--target=NUMBER       : Function (without noise) counted as success. Default: 0.001 sphere, 0.1 rosenbrock, 0.5 rastrigin, or the noise if larger" << endl;
+	cout << "--min(A/Z)=NUMBER     : Minimum value of A/Z. Default: 1 and 0.1" << endl;
+	cout << "--max(A/Z)=NUMBER     : Maximum value of A/Z. Default: 100 and 3" << endl;
+	cout << "--stepsize(A/Z)=LIST  : Intial step sizes for A/Z. Default: a tenth of the range" << endl;
+	cout << "--stepreduction(A/Z)=LIST : Step size reductions for A/Z. Default: as for fit_my_ecp" << endl;
+	cout << "--stepmin(A/Z)=LIST   : Step sizes for A/Z which end a search. Default: a thousandth of the range" << endl;
+}
+
+/*
+ Make the search for a mode, as fit_my_ecp would for -f
+
+ @param[in] mode Name of the search
+ @param[in/out] seed Pointer to random number seed
+ @return Outputs* New search, or NULL if the mode is not known
+ */
+Outputs* make_search(string mode, int *seed)
+{
+	if (cmpStr(mode,"linear"))
+	{
+		return new Linear(seed);
+	}
+	else if (cmpStr(mode,"powells"))
+	{
+		return new Powells(seed);
+	}
+	else if (cmpStr(mode,"newton"))
+	{
+		return new Newton_Raphson(seed);
+	}
+	else if (cmpStr(mode,"lbfgs"))
+	{
+		return new Newton_Raphson(seed,true);
+	}
+	else if (cmpStr(mode,"lbfgsb"))
+	{
+		return new Lbfgs_B(seed);
+	}
+	else if (cmpStr(mode,"cmaes"))
+	{
+		return new Cma_Es(seed);
+	}
+	else if (cmpStr(mode,"bayes"))
+	{
+		return new Bayesian(seed);
+	}
+	else if (cmpStr(mode,"ga") || cmpStr(mode,"ga_async"))
+	{
+		return new Genetic(seed);
+	}
+	else if (cmpStr(mode,"ga_islands"))
+	{
+		return new Islands(seed,2,0);
+	}
+	else if (cmpStr(mode,"sobol"))
+	{
+		return new Quasi_Random(seed);
+	}
+	else if (cmpStr(mode,"lhs"))
+	{
+		return new Quasi_Random(seed,true);
+	}
+
+	return NULL;
+}
+
+/*
+ Split a landscape name into the analytic function and whether it is noisy
+
+ @param[in] name Landscape, such as noisy_sphere
+ @param[out] noisy True if noise is added
+ @return string Analytic function
+ */
+string base_landscape(string name, bool *noisy)
+{
+	*noisy = (name.compare(0,6,"noisy_") == 0);
+
+	return (*noisy) ? name.substr(6) : name;
+}
+
+/*
+ Function counted as success on a landscape. With noise, nothing much
+ below the noise can be told apart, so the target is no smaller than it
+
+ @param[in] name Landscape, which may be noisy
+ @param[in] s Settings
+ @return double Target
+ */
+double get_target(string name, benchmark_settings s)
+{
+	bool noisy = false;
+	const string landscape = base_landscape(name,&noisy);
+	double target = 0.001;
+
+	if (s.target > 0.0)
+	{
+		return s.target;
+	}
+	else if (cmpStr(landscape,"rosenbrock"))
+	{
+		target = 0.1;
+	}
+	else if (cmpStr(landscape,"rastrigin"))
+	{
+		// Below every local minimum, which are one or more apart
+		target = 0.5;
+	}
+
+	if (noisy && (target < s.noise))
+	{
+		target = s.noise;
+	}
+
+	return target;
+}
+
+/*
+ Put the optimum somewhere inside the box, away from the middle and the edges,
+ with every line different
+
+ @param[in] start Gaussian with the values in the order they are fitted
+ @param[in] s Settings
+ @return vector<double> Optimum for each value
+ */
+vector<double> get_optimum(gaussian start, benchmark_settings s)
+{
+	vector<double> optimum(start.values.size());
+
+	for (vector<gaussian_info>::size_type i = 0; i < start.values.size(); i++)
+	{
+		int type = start.values[i].type;
+		double w = 0.6180339887498949 * (i + 1);
+		double fraction = 0.2 + 0.6 * (w - floor(w));
+		optimum[i] = s.minimums[type] + fraction * (s.maximums[type] - s.minimums[type]);
+	}
+
+	return optimum;
+}
+
+/*
+ Starting ECP, as calculate_starting_gaussian_ecps gives for a Gamess-UK template:
+ a coefficient then an exponent on each line. The values are anywhere in the box
+
+ @param[in] s Settings
+ @param[in/out] seed Pointer to random number seed
+ @return gaussian Starting ECP
+ */
+gaussian get_start(benchmark_settings s, int *seed)
+{
+	gaussian g;
+
+	for (int i = 0; i < s.lines; i++)
+	{
+		for (int type = 0; type < 2; type++)
+		{
+			gaussian_info v;
+			v.line_number = i + 1;
+			v.type = type;
+			v.value = s.minimums[type] + randomNumber(seed) * (s.maximums[type] - s.minimums[type]);
+			g.values.push_back(v);
+		}
+	}
+
+	g.function = 0.0;
+	g.rank = 0;
+	g.index = 0;
+	g.failed = false;
+
+	return g;
+}
+
+/*
+ Work out the landscape for an ECP, without noise
+
+ @param[in] landscape Analytic function
+ @param[in] g ECP
+ @param[in] optimum Values at the minimum
+ @param[in] s Settings
+ @return double Function
+ */
+double evaluate(string landscape, gaussian g, vector<double> optimum, benchmark_settings s)
+{
+	vector<double> d(g.values.size());
+
+	for (vector<gaussian_info>::size_type i = 0; i < g.values.size(); i++)
+	{
+		int type = g.values[i].type;
+		d[i] = landscape_width * (g.values[i].value - optimum[i]) / (s.maximums[type] - s.minimums[type]);
+	}
+
+	return calculate_landscape(landscape,d);
+}
+
+/*
+ Run one search on one landscape, until it converges or runs out of evaluations.
+ The search is set up and handed results in the same order as fit_my_ecp uses
+
+ @param[in] mode Name of the search
+ @param[in] name Landscape, which may be noisy
+ @param[in] seed Number of this run, which picks the start and every random choice
+ @param[in] s Settings
+ @return benchmark_run What happened
+ */
+benchmark_run run_search(string mode, string name, int seed, benchmark_settings s)
+{
+	bool noisy = false;
+	const string landscape = base_landscape(name,&noisy);
+	const double target = get_target(name,s);
+
+	// A negative seed starts the generator again, so each run can be repeated on its own
+	int random_seed = -seed;
+	gaussian start = get_start(s,&random_seed);
+	vector<double> optimum = get_optimum(start,s);
+
+	// The noise has a stream of its own, so it doesn't depend on how many random numbers the search draws
+	int noise_seed = -1 - randomNumber(100000000,&random_seed);
+	random_stream noise_stream = {0,0,{0},false};
+
+	Outputs *searcher = make_search(mode,&random_seed);
+	History history;
+
+	benchmark_run run;
+	run.evaluations = 0;
+	run.evaluations_to_target = -1;
+	run.best = HUGE_VAL;
+
+	// The searches report as they go, which would drown out the table
+	streambuf *screen = cout.rdbuf(NULL);
+	const double started = monotonic_seconds();
+
+	searcher->set_parameters(s.step_size,s.step_reduction,s.step_size_min,s.minimums,s.maximums,0);
+
+	if (cmpStr(mode,"ga") || cmpStr(mode,"ga_async") || cmpStr(mode,"ga_islands"))
+	{
+		searcher->set_ga_parameters(0,0,0,0,false,cmpStr(mode,"ga_async"));
+	}
+
+	if (cmpStr(mode,"lbfgsb"))
+	{
+		searcher->set_lbfgs_parameters(0,s.budget);
+	}
+
+	searcher->set_sample_parameters(s.batch,s.budget);
+	searcher->set_starting_gaussians(start);
+	searcher->set_ecps_history(history.get_history());
+
+	while (!searcher->get_converged() && (run.evaluations < s.budget))
+	{
+		vector<gaussian> v = searcher->get_ecps_to_test();
+
+		if (v.size() == 0)
+		{
+			break;
+		}
+
+		vector<int> from_history(v.size(),0);
+
+		for (vector<gaussian>::size_type a = 0; a < v.size(); a++)
+		{
+			int exists = history.check_history(v[a]);
+
+			if (exists != -1)
+			{
+				v[a] = history.get(exists);
+				from_history[a] = 1;
+				continue;
+			}
+
+			// A batch can be bigger than what is left, and the rest are never paid for
+			if (run.evaluations >= s.budget)
+			{
+				break;
+			}
+
+			double f = evaluate(landscape,v[a],optimum,s);
+			run.evaluations++;
+
+			if (f < run.best)
+			{
+				run.best = f;
+			}
+
+			if ((f <= target) && (run.evaluations_to_target < 0))
+			{
+				run.evaluations_to_target = run.evaluations;
+			}
+
+			v[a].function = noisy ? f + s.noise * (2.0*randomNumber(&noise_seed,&noise_stream) - 1.0) : f;
+			v[a].failed = false;
+			v[a].index = run.evaluations;
+		}
+
+		if (run.evaluations >= s.budget)
+		{
+			break;
+		}
+
+		// Rank and pick out the best, as is done after each batch of calculations
+		int number_one_ranked = 0;
+
+		for (vector<gaussian>::size_type i = 0; i < v.size(); i++)
+		{
+			v[i].rank = 1;
+
+			for (vector<gaussian>::size_type j = 0; j < v.size(); j++)
+			{
+				if ((v[i].function - v[j].function) > 0.000000001)
+				{
+					v[i].rank++;
+				}
+			}
+
+			if (v[i].function < v[number_one_ranked].function)
+			{
+				number_one_ranked = i;
+			}
+		}
+
+		history.append(v,from_history);
+		searcher->set_ecps_tested(v,number_one_ranked);
+	}
+
+	run.wall_seconds = monotonic_seconds() - started;
+	run.converged = searcher->get_converged();
+
+	cout.rdbuf(screen);
+	cout.clear();
+
+	delete searcher;
+
+	return run;
+}
+
+/*
+ Read a comma separated list of step sizes into a vector
+
+ @param[in] value Text of the list
+ @param[out] v Vector to add to
+ */
+void read_list(string value, vector<double> &v)
+{
+	vector<string> tokens;
+	Tokenize(value,tokens,", ");
+
+	for (vector<string>::size_type a = 0; a < tokens.size(); a++)
+	{
+		v.push_back(StringToNumber<double>(tokens[a]));
+	}
+}
+
+/*
+ Write a number into a table, or NA if there is nothing to report
+
+ @param[in] value Number
+ @param[in] valid False if there is nothing to report
+ @return string Table entry
+ */
+string table_entry(double value, bool valid = true)
+{
+	if (!valid)
+	{
+		return "NA";
+	}
+
+	string s = "";
+	NumberToString(value,s);
+	return s;
+}
+
+int main(int argc, char *argv[])
+{
+	benchmark_settings s;
+	s.step_size.resize(2);
+	s.step_reduction.resize(2);
+	s.step_size_min.resize(2);
+	s.minimums.assign(2,0.0);
+	s.maximums.assign(2,0.0);
+	s.lines = 0;
+	s.budget = 0;
+	s.batch = 0;
+	s.noise = -1;
+	s.target = 0.0;
+
+	string modes = "";
+	string landscapes = "";
+	string output_file = "";
+	string runs_output_file = "";
+	int seeds = 0;
+
+	for (int argc_counter = 1; argc_counter < argc; argc_counter++)
+	{
+		string argv_string = argv[argc_counter];
+		string argv_variable = "";
+		string argv_value = "";
+
+		// Remove leading hyphens, and separate value from parameter
+		while ((argv_string.size() > 0) && (argv_string[0] == '-'))
+		{
+			argv_string.erase(argv_string.begin());
+		}
+
+		size_t argv_splitter = argv_string.find_first_of('=');
+
+		if (argv_splitter != string::npos)
+		{
+			argv_variable = argv_string.substr(0,argv_splitter);
+			argv_value = argv_string.substr(argv_splitter+1);
+		}
+		else
+		{
+			argv_variable = argv_string;
+		}
+
+		if (cmpStr("help",argv_variable) || cmpStr("h",argv_variable))
+		{
+			help();
+			exit(EXIT_SUCCESS);
+		}
+		else if (cmpStr("modes",argv_variable))
+		{
+			modes = argv_value;
+		}
+		else if (cmpStr("landscapes",argv_variable))
+		{
+			landscapes = argv_value;
+		}
+		else if (cmpStr("output",argv_variable) || cmpStr("o",argv_variable))
+		{
+			output_file = argv_value;
+		}
+		else if (cmpStr("runs_output",argv_variable))
+		{
+			runs_output_file = argv_value;
+		}
+		else if (cmpStr("seeds",argv_variable))
+		{
+			StringToNumber(argv_value,seeds);
+		}
+		else if (cmpStr("budget",argv_variable))
+		{
+			StringToNumber(argv_value,s.budget);
+		}
+		else if (cmpStr("sample_batch",argv_variable))
+		{
+			StringToNumber(argv_value,s.batch);
+		}
+		else if (cmpStr("lines",argv_variable))
+		{
+			StringToNumber(argv_value,s.lines);
+		}
+		else if (cmpStr("noise",argv_variable))
+		{
+			StringToNumber(argv_value,s.noise);
+		}
+		else if (cmpStr("target",argv_variable))
+		{
+			StringToNumber(argv_value,s.target);
+		}
+		else if (cmpStr("minA",argv_variable))
+		{
+			StringToNumber(argv_value,s.minimums[0]);
+		}
+		else if (cmpStr("maxA",argv_variable))
+		{
+			StringToNumber(argv_value,s.maximums[0]);
+		}
+		else if (cmpStr("minZ",argv_variable))
+		{
+			StringToNumber(argv_value,s.minimums[1]);
+		}
+		else if (cmpStr("maxZ",argv_variable))
+		{
+			StringToNumber(argv_value,s.maximums[1]);
+		}
+		else if (cmpStr("stepsizeA",argv_variable))
+		{
+			read_list(argv_value,s.step_size[0]);
+		}
+		else if (cmpStr("stepsizeZ",argv_variable))
+		{
+			read_list(argv_value,s.step_size[1]);
+		}
+		else if (cmpStr("stepreductionA",argv_variable))
+		{
+			read_list(argv_value,s.step_reduction[0]);
+		}
+		else if (cmpStr("stepreductionZ",argv_variable))
+		{
+			read_list(argv_value,s.step_reduction[1]);
+		}
+		else if (cmpStr("stepminA",argv_variable))
+		{
+			read_list(argv_value,s.step_size_min[0]);
+		}
+		else if (cmpStr("stepminZ",argv_variable))
+		{
+			read_list(argv_value,s.step_size_min[1]);
+		}
+		else
+		{
+			cout << "Unrecognised input: " << argv[argc_counter] << endl;
+			help();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// Check defaults
+	if (modes.length() == 0)
+	{
+		modes = "linear,powells,newton,lbfgs,lbfgsb,cmaes,bayes,ga,ga_async,ga_islands,sobol,lhs";
+		cout << "Using default searches: " << modes << endl;
+	}
+
+	if (landscapes.length() == 0)
+	{
+		landscapes = "sphere,noisy_sphere,rosenbrock,rastrigin";
+		cout << "Using default landscapes: " << landscapes << endl;
+	}
+
+	if (output_file.length() == 0)
+	{
+		output_file = "benchmark.tsv";
+		cout << "Using default output file: " << output_file << endl;
+	}
+
+	if (seeds < 1)
+	{
+		seeds = 10;
+		cout << "Using default number of seeds: " << seeds << endl;
+	}
+
+	if (s.budget < 1)
+	{
+		s.budget = 200;
+		cout << "Using default budget of function evaluations: " << s.budget << endl;
+	}
+
+	if (s.batch < 1)
+	{
+		s.batch = 4;
+		cout << "Using default sample batch size: " << s.batch << endl;
+	}
+
+	if (s.lines < 1)
+	{
+		s.lines = 2;
+		cout << "Using default number of ECP lines: " << s.lines << endl;
+	}
+
+	if (s.noise < 0.0)
+	{
+		s.noise = 0.01;
+		cout << "Using default noise: " << s.noise << endl;
+	}
+
+	const char labels[2] = {'A','Z'};
+	const double default_minimums[2] = {1.0, 0.1};
+	const double default_maximums[2] = {100.0, 3.0};
+
+	for (int type = 0; type < 2; type++)
+	{
+		if (s.minimums[type] == 0.0)
+		{
+			s.minimums[type] = default_minimums[type];
+			cout << "Using default minimum value for " << labels[type] << ": " << s.minimums[type] << endl;
+		}
+
+		if (s.maximums[type] == 0.0)
+		{
+			s.maximums[type] = default_maximums[type];
+			cout << "Using default maximum value for " << labels[type] << ": " << s.maximums[type] << endl;
+		}
+
+		if (s.maximums[type] <= s.minimums[type])
+		{
+			cout << "The maximum value for " << labels[type] << " must be above the minimum" << endl;
+			cout << "Critical Error" << endl;
+			exit(EXIT_FAILURE);
+		}
+
+		// Steps scale with the box, so every search is given the same chance on any box
+		double range = s.maximums[type] - s.minimums[type];
+
+		if (s.step_size[type].size() == 0)
+		{
+			s.step_size[type].push_back(0.1 * range);
+			cout << "Using default starting step size for " << labels[type] << ": " << s.step_size[type][0] << endl;
+		}
+
+		if (s.step_size_min[type].size() == 0)
+		{
+			s.step_size_min[type].push_back(0.001 * range);
+			cout << "Using default step size minimum for convergence for " << labels[type] << ": " << s.step_size_min[type][0] << endl;
+		}
+	}
+
+	vector<string> mode_list;
+	vector<string> landscape_list;
+	Tokenize(modes,mode_list,", ");
+	Tokenize(landscapes,landscape_list,", ");
+
+	// Check everything asked for exists before spending any time
+	for (vector<string>::size_type m = 0; m < mode_list.size(); m++)
+	{
+		int seed = -1;
+		streambuf *screen = cout.rdbuf(NULL);
+		Outputs *searcher = make_search(mode_list[m],&seed);
+		cout.rdbuf(screen);
+		cout.clear();
+
+		if (searcher == NULL)
+		{
+			cout << "Search is not defined: " << mode_list[m] << endl;
+			cout << "Critical Error" << endl;
+			exit(EXIT_FAILURE);
+		}
+
+		delete searcher;
+	}
+
+	for (vector<string>::size_type l = 0; l < landscape_list.size(); l++)
+	{
+		bool noisy = false;
+
+		if (!landscape_exists(base_landscape(landscape_list[l],&noisy)))
+		{
+			cout << "Landscape is not defined: " << landscape_list[l] << endl;
+			cout << "Critical Error" << endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	cout << endl;
+
+	vector<string> outData;
+	vector<string> runsData;
+	outData.push_back("mode\tlandscape\tparameters\ttarget\tseeds\tsuccess_rate\tevaluations_to_target_median\t"
+			  "evaluations_to_target_mean\tevaluations_mean\tbest_mean\twall_ms_mean\tconverged_rate");
+	runsData.push_back("mode\tlandscape\tseed\tevaluations\tevaluations_to_target\tbest\twall_ms\tconverged");
+
+	for (vector<string>::size_type m = 0; m < mode_list.size(); m++)
+	{
+		for (vector<string>::size_type l = 0; l < landscape_list.size(); l++)
+		{
+			double target = get_target(landscape_list[l],s);
+			vector<int> to_target;
+			double evaluations = 0.0;
+			double best = 0.0;
+			double wall = 0.0;
+			int converged = 0;
+
+			for (int seed = 1; seed <= seeds; seed++)
+			{
+				benchmark_run run = run_search(mode_list[m],landscape_list[l],seed,s);
+
+				if (run.evaluations_to_target > 0)
+				{
+					to_target.push_back(run.evaluations_to_target);
+				}
+
+				evaluations += run.evaluations;
+				best += run.best;
+				wall += run.wall_seconds;
+
+				if (run.converged)
+				{
+					converged++;
+				}
+
+				ostringstream row;
+				row << mode_list[m] << "\t" << landscape_list[l] << "\t" << seed << "\t" << run.evaluations << "\t";
+				row << table_entry(run.evaluations_to_target,run.evaluations_to_target > 0) << "\t";
+				row << table_entry(run.best) << "\t" << table_entry(1000.0 * run.wall_seconds) << "\t" << run.converged;
+				runsData.push_back(row.str());
+			}
+
+			sort(to_target.begin(),to_target.end());
+			const bool reached = (to_target.size() > 0);
+			double median = 0.0;
+			double mean = 0.0;
+
+			if (reached)
+			{
+				const vector<int>::size_type n = to_target.size();
+				median = (n % 2 == 1) ? to_target[n/2] : 0.5 * (to_target[n/2-1] + to_target[n/2]);
+
+				for (vector<int>::size_type i = 0; i < n; i++)
+				{
+					mean += to_target[i];
+				}
+				mean /= n;
+			}
+
+			ostringstream row;
+			row << mode_list[m] << "\t" << landscape_list[l] << "\t" << 2 * s.lines << "\t" << target << "\t" << seeds << "\t";
+			row << table_entry((double) to_target.size() / seeds) << "\t" << table_entry(median,reached) << "\t";
+			row << table_entry(mean,reached) << "\t" << table_entry(evaluations / seeds) << "\t";
+			row << table_entry(best / seeds) << "\t" << table_entry(1000.0 * wall / seeds) << "\t";
+			row << table_entry((double) converged / seeds);
+			outData.push_back(row.str());
+
+			cout << mode_list[m] << " on " << landscape_list[l] << " : " << to_target.size() << " of " << seeds << " runs reached " << target;
+
+			if (reached)
+			{
+				cout << ", median " << median << " evaluations";
+			}
+
+			cout << endl;
+		}
+	}
+
+	write_out_lines(output_file,&outData);
+
+	if (runs_output_file.length() > 0)
+	{
+		write_out_lines(runs_output_file,&runsData);
+	}
+
+	cout << endl;
+	cout << "Benchmark written to " << output_file << endl;
+
+	return 0;
+}
@@ -0,0 +1,991 @@
+/*
+ *  @file Benchmark_Parsers.cpp
+ *  fit_my_ecp
+ *
+ *  @brief Measures what it costs to read the outputs of each calculation: the
+ *  Gamess-UK and NWChem outputs, the gradients, and the punch file. Synthetic
+ *  outputs are written for a range of sizes, and each is parsed in a process of
+ *  its own so the peak memory belongs to that parse alone. The conversions between
+ *  numbers and text in Utils.h are also set against the stringstream templates they
+ *  replaced. Build with "make benchmark"
+ *
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+// Personal headers
+#include "Utils.h"
+#include "IO.h"
+#include "Structures.h"
+#include "Gamess_UK.h"
+#include "Gradients.h"
+#include "Nwchem.h"
+#include "Punch.h"
+#include "Synthetic_Outputs.h"
+
+using namespace std;
+
+// Every allocation made through new, counted so a parse can be charged for its own
+static unsigned long long allocation_count = 0;
+static unsigned long long allocation_bytes = 0;
+
+void* operator new(size_t size)
+{
+	allocation_count++;
+	allocation_bytes += size;
+
+	void *p = malloc((size > 0) ? size : 1);
+
+	if (p == NULL)
+	{
+		throw bad_alloc();
+	}
+
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+// The conversions this benchmark can run, each with a stream version and one from Utils.h
+static const string number_modes = "number_parse_stream,number_parse,number_format_stream,number_format,"
+				   "number_round_trip_stream,number_round_trip";
+
+/*
+ StringToNumber as it was, through a stringstream, for comparison
+
+ @param[in] s Text
+ @return T Number
+ */
+template<class T>
+T stream_to_number(const string &s)
+{
+	T val;
+	stringstream os;
+
+	os << s;
+	os >> val;
+
+	return val;
+}
+
+/*
+ NumberToString as it was, through a stringstream, for comparison
+
+ @param[in] val Number
+ @param[in] precision Significant figures
+ @return string Text
+ */
+template<class T>
+string stream_to_string(const T &val, int precision = 6)
+{
+	string s;
+	stringstream os;
+
+	os << setprecision(precision) << val;
+	os >> s;
+
+	return s;
+}
+
+/*
+ Shape of a synthetic Gamess-UK or NWChem output
+ */
+struct electronic_case
+{
+	int mos;
+	bool unrestricted;
+	bool dma;
+	// Centres in region 1, each with a DMA site, alternating O and Mg
+	int sites;
+	// Doubly occupied MOs. An unrestricted output has one more alpha electron
+	int occupied;
+};
+
+/*
+ What a parse cost, as sent back from the process that did it
+ */
+struct parse_result
+{
+	double best_seconds;
+	double mean_seconds;
+	double allocations;
+	double allocated_bytes;
+	long baseline_rss_kb;
+	long peak_rss_kb;
+	int valid;
+};
+
+/*
+ Help function which prints to screen the options
+
+ No params
+ */
+void help()
+{
+	cout << "Usage: benchmark_parsers [options]" << endl;
+	cout << endl;
+	cout << "-h,--help   : Display this message" << endl;
+	cout << endl;
+	cout << "*** Character Values ***" << endl;
+	cout << endl;
+	cout << "--parsers=LIST        : gamess_uk, nwchem, gradients, punch (Punch::analyse), punch_compare," << endl;
+	cout << "                        numbers (StringToNumber/NumberToString against streams). Default: every one" << endl;
+	cout << "--centres=LIST        : Centres in the gradients and punch files. Default: 1000,10000,100000,1000000" << endl;
+	cout << "--numbers=LIST        : Numbers converted by each numbers case. Default: 100000,1000000" << endl;
+	cout << "--mos=LIST            : MOs in the Gamess-UK and NWChem outputs. Default: 100,1000,10000,50000" << endl;
+	cout << "--spins=LIST          : rhf and/or uhf outputs. Default: rhf,uhf" << endl;
+	cout << "--dma=LIST            : Outputs with (yes) and/or without (no) the DMA. Default: yes,no" << endl;
+	cout << "-o,--output=FILENAME  : Tab separated results. Default: benchmark_parsers.tsv" << endl;
+	cout << "--scratch=FILENAME    : Synthetic output, written and removed for each case. Default: benchmark_parsers.scratch" << endl;
+	cout << endl;
+	cout << "*** Numeric Values ***" << endl;
+	cout << endl;
+	cout << "--repeats=NUMBER      : Parses of each output, the fastest being reported as MB/s. Default: 3" << endl;
+}
+
+/*
+ Size of a file
+
+ @param[in] file Filename
+ @return double Bytes, or zero if it is missing
+ */
+double file_bytes(string file)
+{
+	struct stat st;
+
+	if (stat(file.c_str(),&st) != 0)
+	{
+		return 0.0;
+	}
+
+	return (double) st.st_size;
+}
+
+/*
+ Region of a centre. Region 1 is the first percent, at least two, and the rest
+ are shared evenly over regions 2 to 5
+
+ @param[in] i Centre
+ @param[in] centres Total centres
+ @return int Region
+ */
+int centre_region(int i, int centres)
+{
+	const int r1 = min(centres,max(2,centres/100));
+
+	if (i < r1)
+	{
+		return 1;
+	}
+
+	return 2 + min(3,(int) (4.0 * (i - r1) / max(1,centres - r1)));
+}
+
+/*
+ Label of a centre, alternating between anion and cation
+
+ @param[in] i Centre
+ @return string Label, without the region
+ */
+string centre_label(int i)
+{
+	return (i % 2 == 0) ? "O" : "Mg";
+}
+
+/*
+ Energy of an MO, rising through the occupied to the virtual
+
+ @param[in] i MO
+ @param[in] occupied Occupied MOs in this spin
+ @param[in] mos Total MOs
+ @return double Energy (a.u.)
+ */
+double mo_energy(int i, int occupied, int mos)
+{
+	return (i - occupied + 0.5) * 2.0 / mos;
+}
+
+/*
+ Put together a synthetic Gamess-UK or NWChem output of a given shape
+
+ @param[in] c Shape of the output
+ @return synthetic_output What to write
+ */
+synthetic_output describe_output(electronic_case c)
+{
+	synthetic_output o;
+
+	o.title = "synthetic output";
+	for (int i = 1; i <= 20; i++)
+	{
+		o.scf_energies.push_back(-75.0 * c.sites - 1.0 / i);
+	}
+	o.energy = o.scf_energies.back();
+	o.converged = true;
+	o.crash_cycle = 0;
+	o.cycle_seconds = 0.0;
+
+	for (int spin = 0; spin < (c.unrestricted ? 2 : 1); spin++)
+	{
+		// The extra electron is alpha, and each MO holds one electron when unrestricted
+		const int occupied = c.occupied + ((c.unrestricted && (spin == 0)) ? 1 : 0);
+		vector<double> e(c.mos);
+
+		for (int i = 0; i < c.mos; i++)
+		{
+			e[i] = mo_energy(i,occupied,c.mos);
+		}
+		o.mo_energies.push_back(e);
+		o.occupied.push_back(occupied);
+	}
+
+	// A region 2 site after region 1 ends the part of the DMA that is read
+	for (int i = 0; i <= c.sites; i++)
+	{
+		o.labels.push_back(centre_label(i));
+		o.regions.push_back((i < c.sites) ? 1 : 2);
+	}
+	o.dma = c.dma;
+	o.dma_spread = 0.2;
+
+	return o;
+}
+
+/*
+ Size of the gradient on each centre, varying so no two neighbours print alike
+
+ @param[in] centres Number of centres
+ @return vector<double> Gradient sizes
+ */
+vector<double> gradient_sizes(int centres)
+{
+	vector<double> sizes(centres);
+
+	for (int i = 0; i < centres; i++)
+	{
+		sizes[i] = 0.001 * (1 + i % 7);
+	}
+
+	return sizes;
+}
+
+/*
+ Write a punch file with the coordinates and charges of every centre
+
+ @param[in] file Filename
+ @param[in] centres Number of centres
+ */
+void write_punch(string file, int centres)
+{
+	ofstream out(file.c_str());
+
+	out << fixed << setprecision(8);
+	out << "block = fragment records = 0" << endl;
+	out << "block = coordinates records = " << centres << endl;
+
+	for (int i = 0; i < centres; i++)
+	{
+		out << centre_label(i) << centre_region(i,centres) << " " << 0.1 * (i % 1000);
+		out << " " << 0.1 * ((i / 1000) % 1000) << " " << 0.1 * (i / 1000000) << endl;
+	}
+
+	out << "block = atom_charges records = " << centres << endl;
+
+	for (int i = 0; i < centres; i++)
+	{
+		out << ((i % 2 == 0) ? -2.0 : 2.0) << endl;
+	}
+}
+
+/*
+ Write numbers one to a line, in the mix of layouts the parsers see:
+ fixed, scientific, integers and signs
+
+ @param[in] file Filename
+ @param[in] numbers Number of lines
+ */
+void write_numbers(string file, int numbers)
+{
+	ofstream out(file.c_str());
+	char buffer[64];
+
+	for (int i = 0; i < numbers; i++)
+	{
+		double value = (fmod(0.618034 * i,1.0) - 0.5) * pow(10.0,(i % 9) - 4);
+
+		switch (i % 4)
+		{
+			case 0:
+				snprintf(buffer,sizeof(buffer),"%14.8f",value);
+				break;
+			case 1:
+				snprintf(buffer,sizeof(buffer),"%.10E",value);
+				break;
+			case 2:
+				snprintf(buffer,sizeof(buffer),"%d",(i % 2001) - 1000);
+				break;
+			default:
+				snprintf(buffer,sizeof(buffer),"%.17g",value);
+				break;
+		}
+
+		out << buffer << endl;
+	}
+}
+
+/*
+ Run one of the number conversions over every line
+
+ @param[in] mode Which conversion
+ @param[in] lines Numbers as text
+ @param[in] values The same numbers, as read by a stream
+ @return size_t Characters made or read, so the work can't be optimised away
+ */
+size_t convert_numbers(string mode, const vector<string> &lines, const vector<double> &values)
+{
+	size_t total = 0;
+	string s;
+
+	if (cmpStr(mode,"number_parse_stream"))
+	{
+		for (vector<string>::size_type i = 0; i < lines.size(); i++)
+		{
+			total += (stream_to_number<double>(lines[i]) != 0.0);
+		}
+	}
+	else if (cmpStr(mode,"number_parse"))
+	{
+		for (vector<string>::size_type i = 0; i < lines.size(); i++)
+		{
+			total += (StringToNumber<double>(lines[i]) != 0.0);
+		}
+	}
+	else if (cmpStr(mode,"number_format_stream"))
+	{
+		for (vector<double>::size_type i = 0; i < values.size(); i++)
+		{
+			total += stream_to_string(values[i]).length();
+		}
+	}
+	else if (cmpStr(mode,"number_format"))
+	{
+		for (vector<double>::size_type i = 0; i < values.size(); i++)
+		{
+			NumberToString(values[i],s);
+			total += s.length();
+		}
+	}
+	else if (cmpStr(mode,"number_round_trip_stream"))
+	{
+		for (vector<double>::size_type i = 0; i < values.size(); i++)
+		{
+			total += (stream_to_number<double>(stream_to_string(values[i],17)) == values[i]);
+		}
+	}
+	else
+	{
+		for (vector<double>::size_type i = 0; i < values.size(); i++)
+		{
+			NumberToString(values[i],s,round_trip_precision);
+			total += (StringToNumber<double>(s) == values[i]);
+		}
+	}
+
+	return total;
+}
+
+/*
+ Check a number conversion gives what the streams did. Parsing and formatting
+ must match them exactly, and a round trip must give back the same double
+
+ @param[in] mode Which conversion
+ @param[in] lines Numbers as text
+ @param[in] values The same numbers, as read by a stream
+ @return bool True if every number matches
+ */
+bool check_numbers(string mode, const vector<string> &lines, const vector<double> &values)
+{
+	string s;
+
+	for (vector<double>::size_type i = 0; i < values.size(); i++)
+	{
+		if (cmpStr(mode,"number_parse") && (StringToNumber<double>(lines[i]) != values[i]))
+		{
+			return false;
+		}
+		else if (cmpStr(mode,"number_format"))
+		{
+			NumberToString(values[i],s);
+
+			if (!cmpStr(s,stream_to_string(values[i])))
+			{
+				return false;
+			}
+		}
+	}
+
+	// Round trips are counted as they go
+	if (cmpStr(mode,"number_round_trip_stream") || cmpStr(mode,"number_round_trip"))
+	{
+		return (convert_numbers(mode,lines,values) == values.size());
+	}
+
+	return true;
+}
+
+/*
+ Parse one output a number of times, keeping the timings and what each parse allocated.
+ The screen output of the parsers is dropped
+
+ @param[in] parser Which parser
+ @param[in] file Synthetic output
+ @param[in] size Centres, MOs or numbers in the output
+ @param[in] c Shape of the output, for Gamess-UK and NWChem
+ @param[in] repeats Number of parses
+ @return parse_result Cost of the parse, apart from the memory
+ */
+parse_result run_parser(string parser, string file, int size, electronic_case c, int repeats)
+{
+	parse_result r;
+	r.best_seconds = HUGE_VAL;
+	r.mean_seconds = 0.0;
+	r.allocations = 0.0;
+	r.allocated_bytes = 0.0;
+	r.valid = 1;
+
+	// Everything the parsers are given, made before any timing starts
+	vector<string> r1_species;
+	r1_species.push_back("O");
+	r1_species.push_back("MG");
+
+	vector<int> centre_regions;
+	vector<int> centre_regions_total(5,0);
+
+	if (cmpStr(parser,"gradients"))
+	{
+		centre_regions.resize(size);
+
+		for (int i = 0; i < size; i++)
+		{
+			centre_regions[i] = centre_region(i,size);
+			centre_regions_total[centre_regions[i]-1]++;
+		}
+	}
+
+	Punch template_punch;
+
+	if (cmpStr(parser,"punch_compare"))
+	{
+		template_punch.set_punch_template(read_in_lines(file),"O");
+	}
+
+	const bool numbers = (parser.compare(0,7,"number_") == 0);
+	vector<string> lines;
+	vector<double> values;
+
+	if (numbers)
+	{
+		lines = read_in_lines(file);
+		lines.resize(size);
+		values.resize(size);
+
+		for (int i = 0; i < size; i++)
+		{
+			values[i] = stream_to_number<double>(lines[i]);
+		}
+	}
+
+	streambuf *screen = cout.rdbuf(NULL);
+
+	for (int repeat = 0; repeat < repeats; repeat++)
+	{
+		const unsigned long long count = allocation_count;
+		const unsigned long long bytes = allocation_bytes;
+		const double started = monotonic_seconds();
+		bool valid = true;
+
+		if (numbers)
+		{
+			valid = (convert_numbers(parser,lines,values) > 0);
+		}
+		else if (cmpStr(parser,"gamess_uk") || cmpStr(parser,"nwchem"))
+		{
+			DFT_Program *qm_program = NULL;
+
+			if (cmpStr(parser,"gamess_uk"))
+			{
+				qm_program = new Gamess_UK();
+			}
+			else
+			{
+				qm_program = new Nwchem();
+			}
+
+			qm_program->set_anion_species("O");
+			qm_program->set_anion_offset(0);
+
+			gaussian g;
+			g.failed = false;
+			g = qm_program->digest_electronic(file,g,(c.sites+1)/2,r1_species,true);
+
+			valid = !g.failed && (!c.dma || (g.dma_spread[0].quantity == (c.sites+1)/2));
+			delete qm_program;
+		}
+		else if (cmpStr(parser,"gradients"))
+		{
+			vector<regions_data> regions = digest_gradients(file,size,centre_regions_total,centre_regions,false,true);
+			valid = (regions[0].gnorm > 0.0);
+		}
+		else if (cmpStr(parser,"punch"))
+		{
+			Punch p;
+			p.set_punch_template(read_in_lines(file),"O");
+			valid = (p.get_total_centres() == size);
+		}
+		else
+		{
+			template_punch.compare(file,true);
+			valid = (template_punch.get_total_centres() == size);
+		}
+
+		const double seconds = monotonic_seconds() - started;
+
+		r.allocations += allocation_count - count;
+		r.allocated_bytes += allocation_bytes - bytes;
+		r.mean_seconds += seconds;
+
+		if (seconds < r.best_seconds)
+		{
+			r.best_seconds = seconds;
+		}
+
+		if (!valid)
+		{
+			r.valid = 0;
+		}
+	}
+
+	cout.rdbuf(screen);
+	cout.clear();
+
+	if (numbers && !check_numbers(parser,lines,values))
+	{
+		r.valid = 0;
+	}
+
+	r.mean_seconds /= repeats;
+	r.allocations /= repeats;
+	r.allocated_bytes /= repeats;
+
+	return r;
+}
+
+/*
+ Run the parser in a process of its own, so its peak memory is not mixed up
+ with any other case, and pass the result back through a pipe
+
+ @param[in] parser Which parser
+ @param[in] file Synthetic output
+ @param[in] size Centres, MOs or numbers in the output
+ @param[in] c Shape of the output, for Gamess-UK and NWChem
+ @param[in] repeats Number of parses
+ @param[out] r Cost of the parse
+ @return bool True if the child reported back
+ */
+bool run_parser_process(string parser, string file, int size, electronic_case c, int repeats, parse_result *r)
+{
+	int fd[2];
+
+	if (pipe(fd) != 0)
+	{
+		return false;
+	}
+
+	cout.flush();
+	pid_t pid = fork();
+
+	if (pid < 0)
+	{
+		close(fd[0]);
+		close(fd[1]);
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		close(fd[0]);
+
+		struct rusage usage;
+		getrusage(RUSAGE_SELF,&usage);
+		const long baseline = usage.ru_maxrss;
+
+		parse_result result = run_parser(parser,file,size,c,repeats);
+
+		getrusage(RUSAGE_SELF,&usage);
+		result.baseline_rss_kb = baseline;
+		result.peak_rss_kb = usage.ru_maxrss;
+
+		const bool sent = (write(fd[1],&result,sizeof(result)) == (ssize_t) sizeof(result));
+		close(fd[1]);
+		_exit(sent ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	close(fd[1]);
+	const bool received = (read(fd[0],r,sizeof(*r)) == (ssize_t) sizeof(*r));
+	close(fd[0]);
+
+	int status = 0;
+	waitpid(pid,&status,0);
+
+	return received && WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS);
+}
+
+/*
+ Read a comma separated list of sizes
+
+ @param[in] value Text of the list
+ @return vector<int> Sizes
+ */
+vector<int> read_sizes(string value)
+{
+	vector<string> tokens;
+	vector<int> sizes;
+	Tokenize(value,tokens,", ");
+
+	for (vector<string>::size_type a = 0; a < tokens.size(); a++)
+	{
+		int n = 0;
+		StringToNumber(tokens[a],n);
+
+		if (n < 1)
+		{
+			cout << "Sizes must be positive: " << tokens[a] << endl;
+			cout << "Critical Error" << endl;
+			exit(EXIT_FAILURE);
+		}
+
+		sizes.push_back(n);
+	}
+
+	return sizes;
+}
+
+/*
+ Check a list only holds what is allowed
+
+ @param[in] list Items asked for
+ @param[in] allowed Comma separated items allowed
+ @param[in] what Name of the option, for the error
+ */
+void check_list(vector<string> list, string allowed, string what)
+{
+	vector<string> tokens;
+	Tokenize(allowed,tokens,", ");
+
+	for (vector<string>::size_type a = 0; a < list.size(); a++)
+	{
+		bool found = false;
+
+		for (vector<string>::size_type b = 0; b < tokens.size(); b++)
+		{
+			if (cmpStr(list[a],tokens[b]))
+			{
+				found = true;
+			}
+		}
+
+		if (!found)
+		{
+			cout << "Unrecognised " << what << ": " << list[a] << endl;
+			cout << "Critical Error" << endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	string parsers = "";
+	string centres = "";
+	string mos = "";
+	string numbers = "";
+	string spins = "";
+	string dma = "";
+	string output_file = "";
+	string scratch_file = "";
+	int repeats = 0;
+
+	for (int argc_counter = 1; argc_counter < argc; argc_counter++)
+	{
+		string argv_string = argv[argc_counter];
+		string argv_variable = "";
+		string argv_value = "";
+
+		// Remove leading hyphens, and separate value from parameter
+		while ((argv_string.size() > 0) && (argv_string[0] == '-'))
+		{
+			argv_string.erase(argv_string.begin());
+		}
+
+		size_t argv_splitter = argv_string.find_first_of('=');
+
+		if (argv_splitter != string::npos)
+		{
+			argv_variable = argv_string.substr(0,argv_splitter);
+			argv_value = argv_string.substr(argv_splitter+1);
+		}
+		else
+		{
+			argv_variable = argv_string;
+		}
+
+		if (cmpStr("help",argv_variable) || cmpStr("h",argv_variable))
+		{
+			help();
+			exit(EXIT_SUCCESS);
+		}
+		else if (cmpStr("parsers",argv_variable))
+		{
+			parsers = argv_value;
+		}
+		else if (cmpStr("centres",argv_variable))
+		{
+			centres = argv_value;
+		}
+		else if (cmpStr("mos",argv_variable))
+		{
+			mos = argv_value;
+		}
+		else if (cmpStr("numbers",argv_variable))
+		{
+			numbers = argv_value;
+		}
+		else if (cmpStr("spins",argv_variable))
+		{
+			spins = argv_value;
+		}
+		else if (cmpStr("dma",argv_variable))
+		{
+			dma = argv_value;
+		}
+		else if (cmpStr("output",argv_variable) || cmpStr("o",argv_variable))
+		{
+			output_file = argv_value;
+		}
+		else if (cmpStr("scratch",argv_variable))
+		{
+			scratch_file = argv_value;
+		}
+		else if (cmpStr("repeats",argv_variable))
+		{
+			StringToNumber(argv_value,repeats);
+		}
+		else
+		{
+			cout << "Unrecognised input: " << argv[argc_counter] << endl;
+			help();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	// Check defaults
+	if (parsers.length() == 0)
+	{
+		parsers = "gamess_uk,nwchem,gradients,punch,punch_compare,numbers";
+		cout << "Using default parsers: " << parsers << endl;
+	}
+
+	if (centres.length() == 0)
+	{
+		centres = "1000,10000,100000,1000000";
+		cout << "Using default centres: " << centres << endl;
+	}
+
+	if (mos.length() == 0)
+	{
+		mos = "100,1000,10000,50000";
+		cout << "Using default MOs: " << mos << endl;
+	}
+
+	if (numbers.length() == 0)
+	{
+		numbers = "100000,1000000";
+		cout << "Using default numbers: " << numbers << endl;
+	}
+
+	if (spins.length() == 0)
+	{
+		spins = "rhf,uhf";
+		cout << "Using default spins: " << spins << endl;
+	}
+
+	if (dma.length() == 0)
+	{
+		dma = "yes,no";
+		cout << "Using default DMA: " << dma << endl;
+	}
+
+	if (output_file.length() == 0)
+	{
+		output_file = "benchmark_parsers.tsv";
+		cout << "Using default output file: " << output_file << endl;
+	}
+
+	if (scratch_file.length() == 0)
+	{
+		scratch_file = "benchmark_parsers.scratch";
+		cout << "Using default scratch file: " << scratch_file << endl;
+	}
+
+	if (repeats < 1)
+	{
+		repeats = 3;
+		cout << "Using default repeats: " << repeats << endl;
+	}
+
+	vector<string> parser_list;
+	vector<string> spin_list;
+	vector<string> dma_list;
+	Tokenize(parsers,parser_list,", ");
+	Tokenize(spins,spin_list,", ");
+	Tokenize(dma,dma_list,", ");
+	check_list(parser_list,"gamess_uk,nwchem,gradients,punch,punch_compare,numbers," + number_modes,"parser");
+	check_list(spin_list,"rhf,uhf","spin");
+	check_list(dma_list,"yes,no","DMA option");
+
+	const vector<int> centre_list = read_sizes(centres);
+	const vector<int> mo_list = read_sizes(mos);
+	const vector<int> number_list = read_sizes(numbers);
+
+	// Numbers stands for every one of the conversions
+	for (vector<string>::size_type p = 0; p < parser_list.size(); p++)
+	{
+		if (cmpStr(parser_list[p],"numbers"))
+		{
+			vector<string> modes;
+			Tokenize(number_modes,modes,", ");
+			parser_list.erase(parser_list.begin()+p);
+			parser_list.insert(parser_list.begin()+p,modes.begin(),modes.end());
+			p += modes.size() - 1;
+		}
+	}
+
+	cout << endl;
+
+	vector<string> outData;
+	outData.push_back("parser\tcentres\tmos\tnumbers\tspin\tdma\tfile_mb\trepeats\tbest_ms\tmean_ms\tmb_per_s\t"
+			  "peak_rss_mb\tparse_rss_mb\tallocations\tallocated_kb\tvalid");
+
+	for (vector<string>::size_type p = 0; p < parser_list.size(); p++)
+	{
+		const string parser = parser_list[p];
+		const bool electronic = (cmpStr(parser,"gamess_uk") || cmpStr(parser,"nwchem"));
+		const bool conversion = (parser.compare(0,7,"number_") == 0);
+		const vector<int> &sizes = electronic ? mo_list : (conversion ? number_list : centre_list);
+
+		for (vector<int>::size_type s = 0; s < sizes.size(); s++)
+		{
+			for (vector<string>::size_type u = 0; u < (electronic ? spin_list.size() : 1); u++)
+			{
+				for (vector<string>::size_type d = 0; d < (electronic ? dma_list.size() : 1); d++)
+				{
+					electronic_case c;
+					c.mos = sizes[s];
+					c.unrestricted = electronic && cmpStr(spin_list[u],"uhf");
+					c.dma = electronic && cmpStr(dma_list[d],"yes");
+					// Roughly ten basis functions to a centre, and a fifth of the MOs occupied
+					c.sites = max(2,c.mos/10);
+					c.occupied = min(c.mos-2,max(c.sites,c.mos/5));
+
+					if (cmpStr(parser,"gamess_uk"))
+					{
+						write_gamess_uk(scratch_file,describe_output(c));
+					}
+					else if (cmpStr(parser,"nwchem"))
+					{
+						write_nwchem(scratch_file,describe_output(c));
+					}
+					else if (cmpStr(parser,"gradients"))
+					{
+						write_gradients(scratch_file,gradient_sizes(sizes[s]));
+					}
+					else if (conversion)
+					{
+						write_numbers(scratch_file,sizes[s]);
+					}
+					else
+					{
+						write_punch(scratch_file,sizes[s]);
+					}
+
+					const double mb = file_bytes(scratch_file) / 1.0e6;
+					parse_result r;
+
+					if (!run_parser_process(parser,scratch_file,sizes[s],c,repeats,&r))
+					{
+						cout << "The " << parser << " parse did not finish for size " << sizes[s] << endl;
+						cout << "Critical Error" << endl;
+						remove(scratch_file.c_str());
+						exit(EXIT_FAILURE);
+					}
+
+					remove(scratch_file.c_str());
+
+					const double peak_mb = r.peak_rss_kb / 1024.0;
+					const double parse_mb = (r.peak_rss_kb - r.baseline_rss_kb) / 1024.0;
+
+					ostringstream row;
+					row << parser << "\t";
+					row << ((electronic || conversion) ? "NA" : NumberToString(sizes[s])) << "\t";
+					row << (electronic ? NumberToString(c.mos) : "NA") << "\t";
+					row << (conversion ? NumberToString(sizes[s]) : "NA") << "\t";
+					row << (electronic ? spin_list[u] : "NA") << "\t";
+					row << (electronic ? dma_list[d] : "NA") << "\t";
+					row << fixed << setprecision(3);
+					row << mb << "\t" << repeats << "\t" << 1000.0 * r.best_seconds << "\t" << 1000.0 * r.mean_seconds << "\t";
+					row << mb / r.best_seconds << "\t" << peak_mb << "\t" << parse_mb << "\t";
+					row << setprecision(0) << r.allocations << "\t" << r.allocated_bytes / 1024.0 << "\t" << r.valid;
+					outData.push_back(row.str());
+
+					cout << setw(24) << left << parser << right;
+					cout << (electronic ? " MOs " : (conversion ? " numbers " : " centres ")) << setw(8) << sizes[s];
+
+					if (electronic)
+					{
+						cout << " " << spin_list[u] << " DMA " << dma_list[d];
+					}
+
+					cout << " : " << fixed << setprecision(1) << setw(8) << mb / r.best_seconds << " MB/s, peak RSS ";
+					cout << peak_mb << " MB, " << setprecision(0) << r.allocations << " allocations";
+					cout << ((r.valid != 0) ? "" : " (PARSE INVALID)") << endl;
+					cout.unsetf(ios_base::floatfield);
+					cout << setprecision(6);
+				}
+			}
+		}
+	}
+
+	write_out_lines(output_file,&outData);
+
+	cout << endl;
+	cout << "Benchmark written to " << output_file << endl;
+
+	return 0;
+}
@@ -0,0 +1,619 @@
+/*
+ *  @file Cma_Es.cpp
+ *  fit_my_ecp
+ *
+ *  Follows the (mu/mu_w, lambda) CMA-ES of Hansen, "The CMA Evolution Strategy: A Tutorial" (2016),
+ *  with the default strategy parameters given there.
+ *
+ */
+
+#include <algorithm>
+#include "Cma_Es.h"
+
+using namespace std;
+
+// Starting spread, as a fraction of the box
+#define CMA_ES_SIGMA 0.3
+// Largest spread allowed, as a fraction of the box
+#define CMA_ES_SIGMA_MAX 0.5
+
+/*
+ Compare two (function, index) pairs on function value, for ranking a generation
+ */
+static bool compare_function(const pair<double,int> &a, const pair<double,int> &b)
+{
+	return a.first < b.first;
+}
+
+/*
+ Constructor
+
+ @param[in/out] seed Pointer to the seed
+ */
+Cma_Es::Cma_Es(int *seed) : Outputs(seed)
+{
+	// Search area confines
+	step_size_min.resize(2);
+	minimums.resize(2,0.0);
+	maximums.resize(2,0.0);
+
+	population_size = 0;
+	parents_size = 0;
+	generation = 0;
+	sigma = CMA_ES_SIGMA;
+	mu_eff = 0.0;
+	c_c = 0.0;
+	c_sigma = 0.0;
+	c_1 = 0.0;
+	c_mu = 0.0;
+	damps = 0.0;
+	chi_n = 0.0;
+}
+
+/*
+ Set the initial parameters for the CMA-ES optimisation
+
+ @param[in] ss The step size to be initially used for A and zeta (not used)
+ @param[in] sr Step reduction rate for A and zeta (not used)
+ @param[in] ssm Convergence criteria, defined as the spread of the population to reach, for A and zeta
+ @param[in] min Minimum values for A and zeta
+ @param[in] max Maximum values for A and zeta
+ @param[in] msod Maximum steps in any one direction (not used)
+ */
+void Cma_Es::set_parameters(vector< vector<double> > ss,
+			    vector< vector<double> > sr,
+			    vector< vector<double> > ssm,
+			    vector<double> min,
+			    vector<double> max,
+			    int msod)
+{
+	step_size_min = ssm;
+	minimums = min;
+	maximums = max;
+
+	// - step size minimum
+	if (step_size_min[0].size() == 0)
+	{
+		cout << "Using default step size minimum for convergence for A: 1.0" << endl;
+		step_size_min[0].push_back(1.0);
+	}
+	if (step_size_min[1].size() == 0)
+	{
+		cout << "Using default step size minimum for convergence for Z: 0.001" << endl;
+		step_size_min[1].push_back(0.001);
+	}
+
+	// - constraining values for A
+	if (minimums[0] == 0.0)
+	{
+		cout << "Using default constraint of minimum value for A: 0.0" << endl;
+		minimums[0] = 0.0;
+	}
+	if (maximums[0] == 0.0)
+	{
+		cout << "Using default constraint of maximum value for A: 1000" << endl;
+		maximums[0] = 1000.0;
+	}
+	// - constraining values for Z
+	if (minimums[1] == 0.0)
+	{
+		cout << "Using default constraint of minimum value for Z: 0.0" << endl;
+		minimums[1] = 0.0;
+	}
+	if (maximums[1] == 0.0)
+	{
+		cout << "Using default constraint of maximum value for Z: 1000" << endl;
+		maximums[1] = 1000.0;
+	}
+}
+
+/*
+ Set the number of ECPs in each generation. The population is never
+ smaller than the default for the number of parameters, but grows to fill a batch
+
+ @param[in] bs Number of ECPs to be tested at once
+ @param[in] ts Total number of ECPs to sample (not used)
+ */
+void Cma_Es::set_sample_parameters(int bs, int ts)
+{
+	population_size = bs;
+}
+
+/*
+ Start the search from the best ECPs already in the history, if there are any,
+ and nothing has been tested yet
+
+ @param[in] v All ECPs in the history
+ */
+void Cma_Es::set_ecps_history(vector<gaussian> v)
+{
+	if ((generation > 0) || (mean.size() == 0))
+	{
+		return;
+	}
+
+	const vector<double>::size_type n = mean.size();
+
+	// Rank the usable entries: same shape as our ECP, inside the box, and not failed
+	vector< pair<double,int> > ranked;
+
+	for (vector<gaussian>::size_type i = 0; i < v.size(); i++)
+	{
+		bool usable = (v[i].values.size() == n) && !v[i].failed && (v[i].function != 888888);
+
+		for (vector<gaussian_info>::size_type a = 0; usable && a < n; a++)
+		{
+			usable = (v[i].values[a].type == starting_gaussians.values[a].type) &&
+				 (v[i].values[a].value >= lower[a]) &&
+				 (v[i].values[a].value <= upper[a]);
+		}
+
+		if (usable)
+		{
+			ranked.push_back(make_pair(v[i].function,i));
+		}
+	}
+
+	if (ranked.size() == 0)
+	{
+		return;
+	}
+
+	sort(ranked.begin(),ranked.end(),compare_function);
+
+	// Recombine the best of them into the starting mean, as for a generation
+	const vector<double>::size_type elite = min(ranked.size(),weights.size());
+	double weight_sum = 0.0;
+
+	for (vector<double>::size_type k = 0; k < elite; k++)
+	{
+		weight_sum += weights[k];
+	}
+
+	vector<double> seeded(n,0.0);
+
+	for (vector<double>::size_type k = 0; k < elite; k++)
+	{
+		const gaussian &e = v[ranked[k].second];
+
+		for (vector<double>::size_type a = 0; a < n; a++)
+		{
+			seeded[a] += (weights[k] / weight_sum) * (e.values[a].value - lower[a]) / (upper[a] - lower[a]);
+		}
+	}
+
+	// And let their spread set the starting step size
+	if (elite > 1)
+	{
+		double spread = 0.0;
+
+		for (vector<double>::size_type k = 0; k < elite; k++)
+		{
+			const gaussian &e = v[ranked[k].second];
+
+			for (vector<double>::size_type a = 0; a < n; a++)
+			{
+				const double u = (e.values[a].value - lower[a]) / (upper[a] - lower[a]);
+				spread += (weights[k] / weight_sum) * (u - seeded[a]) * (u - seeded[a]);
+			}
+		}
+
+		sigma = min(max(sqrt(spread / n),0.01),CMA_ES_SIGMA);
+	}
+
+	mean = seeded;
+
+	cout << "Seeding CMA-ES from the best " << elite << " of " << ranked.size() << " ECPs in the history. ";
+	cout << "Best function: " << ranked[0].first << endl;
+
+	calculate_generation();
+}
+
+/*
+ Set up the box, strategy parameters and distribution,
+ then sample the first generation around the starting gaussians
+
+ No param.
+ */
+void Cma_Es::calculate_ecps_to_test()
+{
+	set_strategy();
+	calculate_generation();
+}
+
+/*
+ Set up the box, the default strategy parameters for the number of parameters,
+ and a distribution centred on the starting gaussians
+
+ No param
+ */
+void Cma_Es::set_strategy()
+{
+	const vector<double>::size_type n = starting_gaussians.values.size();
+
+	lower.resize(n);
+	upper.resize(n);
+	mean.resize(n);
+
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		const int type = starting_gaussians.values[a].type;
+
+		lower[a] = minimums[type];
+		upper[a] = maximums[type];
+
+		if (upper[a] <= lower[a])
+		{
+			cout << "The maximum must be greater than the minimum for a CMA-ES search" << endl;
+			exit(EXIT_FAILURE);
+		}
+
+		mean[a] = min(max((starting_gaussians.values[a].value - lower[a]) / (upper[a] - lower[a]),0.0),1.0);
+	}
+
+	if (step_size_min[0].size() != n)
+	{
+		step_size_min[0].resize(n,step_size_min[0][0]);
+	}
+	if (step_size_min[1].size() != n)
+	{
+		step_size_min[1].resize(n,step_size_min[1][0]);
+	}
+
+	// Population and recombination weights
+	const int default_size = 4 + int(3 * log(double(n)));
+
+	if (population_size < default_size)
+	{
+		population_size = default_size;
+	}
+
+	parents_size = population_size / 2;
+	weights.resize(parents_size);
+
+	double weight_sum = 0.0;
+	double weight_squares = 0.0;
+
+	for (int k = 0; k < parents_size; k++)
+	{
+		weights[k] = log(parents_size + 0.5) - log(k + 1.0);
+		weight_sum += weights[k];
+	}
+	for (int k = 0; k < parents_size; k++)
+	{
+		weights[k] /= weight_sum;
+		weight_squares += weights[k] * weights[k];
+	}
+
+	mu_eff = 1.0 / weight_squares;
+
+	// Learning rates
+	c_c = (4.0 + mu_eff / n) / (n + 4.0 + 2.0 * mu_eff / n);
+	c_sigma = (mu_eff + 2.0) / (n + mu_eff + 5.0);
+	c_1 = 2.0 / ((n + 1.3) * (n + 1.3) + mu_eff);
+	c_mu = min(1.0 - c_1,2.0 * (mu_eff - 2.0 + 1.0 / mu_eff) / ((n + 2.0) * (n + 2.0) + mu_eff));
+	damps = 1.0 + 2.0 * max(0.0,sqrt((mu_eff - 1.0) / (n + 1.0)) - 1.0) + c_sigma;
+	chi_n = sqrt(double(n)) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+	// Distribution
+	sigma = CMA_ES_SIGMA;
+	C.assign(n,vector<double>(n,0.0));
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		C[a][a] = 1.0;
+	}
+	p_c.assign(n,0.0);
+	p_sigma.assign(n,0.0);
+	generation = 0;
+
+	cout << "======= CMA-ES Settings =======" << endl;
+	cout << "n: " << n << endl;
+	cout << "lambda: " << population_size << endl;
+	cout << "mu: " << parents_size << endl;
+	cout << "mueff: " << mu_eff << endl;
+}
+
+/*
+ Sample a generation from the current distribution. Samples leaving the box
+ are reflected back in at its walls, and the step actually taken is kept for the update
+
+ No param
+ */
+void Cma_Es::calculate_generation()
+{
+	const vector<double>::size_type n = mean.size();
+
+	decompose_covariance();
+
+	ecps_to_test.clear();
+	steps.assign(population_size,vector<double>(n,0.0));
+
+	vector<double> z(n);
+	vector<double> u(n);
+
+	for (int k = 0; k < population_size; k++)
+	{
+		for (vector<double>::size_type a = 0; a < n; a++)
+		{
+			z[a] = D[a] * gaussian_random();
+		}
+
+		for (vector<double>::size_type a = 0; a < n; a++)
+		{
+			double y = 0.0;
+
+			for (vector<double>::size_type b = 0; b < n; b++)
+			{
+				y += B[a][b] * z[b];
+			}
+
+			u[a] = mean[a] + sigma * y;
+
+			// Reflect back in to the box
+			while ((u[a] < 0.0) || (u[a] > 1.0))
+			{
+				u[a] = (u[a] < 0.0) ? -u[a] : 2.0 - u[a];
+			}
+
+			steps[k][a] = (u[a] - mean[a]) / sigma;
+		}
+
+		ecps_to_test.push_back(make_gaussian(u));
+	}
+}
+
+/*
+ Check if the CMA-ES has converged - if not update the distribution and form the next generation
+
+ No param
+ */
+void Cma_Es::check_converged()
+{
+	ecps_to_test.clear();
+
+	const vector<double>::size_type n = mean.size();
+
+	if (ecps_tested.size() != steps.size())
+	{
+		cout << "CMA-ES was given " << ecps_tested.size() << " ECPs back for a generation of " << steps.size() << ". Stopping" << endl;
+		converged = true;
+		return;
+	}
+
+	// Rank the generation
+	vector< pair<double,int> > ranked(ecps_tested.size());
+
+	for (vector<gaussian>::size_type k = 0; k < ecps_tested.size(); k++)
+	{
+		ranked[k] = make_pair(ecps_tested[k].function,k);
+	}
+
+	sort(ranked.begin(),ranked.end(),compare_function);
+
+	// Recombination of the best steps moves the mean
+	vector<double> y_w(n,0.0);
+
+	for (int k = 0; k < parents_size; k++)
+	{
+		for (vector<double>::size_type a = 0; a < n; a++)
+		{
+			y_w[a] += weights[k] * steps[ranked[k].second][a];
+		}
+	}
+
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		mean[a] += sigma * y_w[a];
+	}
+
+	// Conjugate evolution path, using C^-1/2 = B D^-1 B^T
+	vector<double> BTy(n,0.0);
+
+	for (vector<double>::size_type b = 0; b < n; b++)
+	{
+		for (vector<double>::size_type a = 0; a < n; a++)
+		{
+			BTy[b] += B[a][b] * y_w[a];
+		}
+		BTy[b] /= D[b];
+	}
+
+	double p_sigma_norm = 0.0;
+
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		double c_y = 0.0;
+
+		for (vector<double>::size_type b = 0; b < n; b++)
+		{
+			c_y += B[a][b] * BTy[b];
+		}
+
+		p_sigma[a] = (1.0 - c_sigma) * p_sigma[a] + sqrt(c_sigma * (2.0 - c_sigma) * mu_eff) * c_y;
+		p_sigma_norm += p_sigma[a] * p_sigma[a];
+	}
+
+	p_sigma_norm = sqrt(p_sigma_norm);
+
+	// Stall the covariance path if the step size path is too long
+	const double h_sigma = ((p_sigma_norm / sqrt(1.0 - pow(1.0 - c_sigma,2.0 * (generation + 1)))) <
+				((1.4 + 2.0 / (n + 1.0)) * chi_n)) ? 1.0 : 0.0;
+
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		p_c[a] = (1.0 - c_c) * p_c[a] + h_sigma * sqrt(c_c * (2.0 - c_c) * mu_eff) * y_w[a];
+	}
+
+	// Rank one and rank mu updates of the covariance
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		for (vector<double>::size_type b = 0; b < n; b++)
+		{
+			double rank_mu = 0.0;
+
+			for (int k = 0; k < parents_size; k++)
+			{
+				rank_mu += weights[k] * steps[ranked[k].second][a] * steps[ranked[k].second][b];
+			}
+
+			C[a][b] = (1.0 - c_1 - c_mu) * C[a][b] +
+				  c_1 * (p_c[a] * p_c[b] + (1.0 - h_sigma) * c_c * (2.0 - c_c) * C[a][b]) +
+				  c_mu * rank_mu;
+		}
+	}
+
+	// Step size, kept within the box
+	sigma *= exp((c_sigma / damps) * (p_sigma_norm / chi_n - 1.0));
+
+	double spread_max = 0.0;
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		spread_max = max(spread_max,sqrt(C[a][a]));
+	}
+
+	if (sigma * spread_max > CMA_ES_SIGMA_MAX)
+	{
+		sigma = CMA_ES_SIGMA_MAX / spread_max;
+	}
+
+	generation++;
+
+	cout << "CMA-ES generation " << generation << ": best function " << ranked[0].first << ", sigma " << sigma << endl;
+
+	// Converged once the population has shrunk below the step size minimum in every direction
+	converged = true;
+
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		const double spread = sigma * sqrt(C[a][a]) * (upper[a] - lower[a]);
+
+		cout << "Mean value: " << lower[a] + mean[a] * (upper[a] - lower[a]) << " Spread: " << spread << endl;
+
+		if (spread >= step_size_min[starting_gaussians.values[a].type][a])
+		{
+			converged = false;
+		}
+	}
+
+	if (converged)
+	{
+		cout << "Convergence obtained" << endl;
+	}
+	else
+	{
+		calculate_generation();
+	}
+}
+
+/*
+ Eigen-decomposition of the covariance, C = B D^2 B^T, by Jacobi rotations
+
+ No param
+ */
+void Cma_Es::decompose_covariance()
+{
+	Trace_Span span("cmaes covariance","search");
+
+	const vector<double>::size_type n = C.size();
+
+	vector< vector<double> > A = C;
+
+	B.assign(n,vector<double>(n,0.0));
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		B[a][a] = 1.0;
+	}
+
+	for (int sweep = 0; sweep < 100; sweep++)
+	{
+		double off = 0.0;
+
+		for (vector<double>::size_type p = 0; p < n; p++)
+		{
+			for (vector<double>::size_type q = p + 1; q < n; q++)
+			{
+				off += A[p][q] * A[p][q];
+			}
+		}
+
+		if (off < 1e-30)
+		{
+			break;
+		}
+
+		for (vector<double>::size_type p = 0; p < n; p++)
+		{
+			for (vector<double>::size_type q = p + 1; q < n; q++)
+			{
+				if (A[p][q] == 0.0)
+				{
+					continue;
+				}
+
+				const double theta = (A[q][q] - A[p][p]) / (2.0 * A[p][q]);
+				const double t = ((theta >= 0.0) ? 1.0 : -1.0) / (abs(theta) + sqrt(theta * theta + 1.0));
+				const double c = 1.0 / sqrt(t * t + 1.0);
+				const double s = t * c;
+
+				for (vector<double>::size_type k = 0; k < n; k++)
+				{
+					const double akp = A[k][p];
+					const double akq = A[k][q];
+					A[k][p] = c * akp - s * akq;
+					A[k][q] = s * akp + c * akq;
+				}
+				for (vector<double>::size_type k = 0; k < n; k++)
+				{
+					const double apk = A[p][k];
+					const double aqk = A[q][k];
+					A[p][k] = c * apk - s * aqk;
+					A[q][k] = s * apk + c * aqk;
+				}
+				for (vector<double>::size_type k = 0; k < n; k++)
+				{
+					const double bkp = B[k][p];
+					const double bkq = B[k][q];
+					B[k][p] = c * bkp - s * bkq;
+					B[k][q] = s * bkp + c * bkq;
+				}
+			}
+		}
+	}
+
+	D.resize(n);
+	for (vector<double>::size_type a = 0; a < n; a++)
+	{
+		D[a] = sqrt(max(A[a][a],1e-20));
+	}
+}
+
+/*
+ Normally distributed random number, by the Box-Muller transform
+
+ @return double Random number with zero mean and unit variance
+ */
+double Cma_Es::gaussian_random()
+{
+	const double u1 = 1.0 - randomNumber(idum);
+	const double u2 = randomNumber(idum);
+
+	return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/*
+ Scale a point in the unit cube into the box, as an ECP
+
+ @param[in] u Point in the unit cube
+ @return gaussian The ECP at that point
+ */
+gaussian Cma_Es::make_gaussian(const vector<double> &u)
+{
+	gaussian e = starting_gaussians;
+
+	for (vector<double>::size_type a = 0; a < u.size(); a++)
+	{
+		e.values[a].value = lower[a] + u[a] * (upper[a] - lower[a]);
+	}
+
+	return e;
+}
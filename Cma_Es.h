@@ -0,0 +1,135 @@
+/*
+ *  @Cma_Es.h
+ *  fit_my_ecp
+ *
+ *  @brief Implementation of the Covariance Matrix Adaptation Evolution Strategy.
+ *  Each generation is tested as one batch. Sampling is done in the box
+ *  between the mins and maxes, scaled to a unit cube, and reflected at its walls.
+ *  Inherits some attributes from Outputs, which are rewritten here
+ *
+ */
+
+#ifndef CMA_ES_H
+#define CMA_ES_H
+
+#include "Utils.h"
+#include "Outputs.h"
+
+class Cma_Es : public Outputs {
+
+public:
+
+	/*
+	 Constructor
+
+	 No params
+	 */
+	Cma_Es(){}
+
+	Cma_Es(int *seed);
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Cma_Es(){}
+
+	virtual void set_parameters(std::vector< std::vector<double> > ss,
+				    std::vector< std::vector<double> > sr,
+  				    std::vector< std::vector<double> > ssm,
+				    std::vector<double> min,
+				    std::vector<double> max,
+				    int msod);
+
+	virtual void set_sample_parameters(int bs, int ts);
+
+	virtual void set_ecps_history(std::vector<gaussian> v);
+
+	/*
+	 Defines initial ECPs, and sets up class
+
+	 @param[in] v Vector of initial gaussian(s) read in from ecp.template
+	 */
+	void set_starting_gaussians(gaussian v)
+	{
+		starting_gaussians = v;
+		calculate_ecps_to_test();
+	}
+
+	/*
+	 Takes in the details of the last search run, and saves data
+
+	 @param[in] v Vector of ECPs just tested
+	 @param[in] n Index of the highest ranked ECP
+	 */
+	void set_ecps_tested(std::vector<gaussian> v, int n)
+	{
+		ecps_tested = v;
+		check_converged();
+	}
+
+	/*
+	 Method to print the search type being conducted, common with all other search methods
+
+	 No Param
+	 */
+	virtual void print_type()
+	{
+		std::cout << "Performing a CMA-ES minimisation" << std::endl;
+	}
+
+protected:
+
+	// Int
+	int population_size;
+	int parents_size;
+	int generation;
+	// Vectors
+	std::vector<gaussian> ecps_tested;
+	// Floats
+	std::vector< std::vector<double> > step_size_min;
+	std::vector<double> maximums;
+	std::vector<double> minimums;
+	// Box for each parameter
+	std::vector<double> lower;
+	std::vector<double> upper;
+	// Distribution, in the unit cube
+	std::vector<double> mean;
+	double sigma;
+	std::vector< std::vector<double> > C;
+	std::vector< std::vector<double> > B;
+	std::vector<double> D;
+	std::vector<double> p_c;
+	std::vector<double> p_sigma;
+	// Recombination weights and learning rates
+	std::vector<double> weights;
+	double mu_eff;
+	double c_c;
+	double c_sigma;
+	double c_1;
+	double c_mu;
+	double damps;
+	double chi_n;
+	// Steps taken to reach this generation, in the unit cube before scaling by sigma
+	std::vector< std::vector<double> > steps;
+
+	virtual void calculate_ecps_to_test();
+
+	virtual void check_converged();
+
+private:
+
+	void set_strategy();
+
+	void calculate_generation();
+
+	void decompose_covariance();
+
+	double gaussian_random();
+
+	gaussian make_gaussian(const std::vector<double> &u);
+};
+
+#endif
+
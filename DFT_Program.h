@@ -17,6 +17,21 @@
 // Personal headers
 #include "Utils.h"
 #include "Structures.h"
+#include "Line_Reader.h"
+
+/*
+ What has been seen of the SCF so far in a running calculation's output
+ */
+struct scf_watch
+{
+	// Inside the table of SCF cycles, and how many have been read from it
+	bool in_table;
+	int cycles;
+	// Total energy at each cycle of the current SCF
+	std::vector<double> energies;
+	// Why the calculation is not going to finish well. Empty while all looks fine
+	std::string reason;
+};
 
 class DFT_Program {
 	
@@ -104,15 +119,24 @@ public:
 	}
 
         /*
-         Stub for analysing the contents of the QM output
+         Stub for analysing the contents of the QM output file
 
          To be over-written by inheriting class
          */
-        virtual gaussian digest_electronic(std::vector<std::string> qm_output, gaussian g, int r1_anion, std::vector<std::string> r1_species)
+        virtual gaussian digest_electronic(std::string qm_output, gaussian g, int r1_anion, std::vector<std::string> r1_species, bool critical)
         {
 		return g;
         }
 
+        /*
+         Stub for reading one line of the QM output while the calculation is still running.
+         SCF energies are added to the watch, and error banners give a reason to stop
+
+         To be over-written by inheriting class
+         */
+        virtual void watch_line(line_view line, std::vector<line_view> *tokens, scf_watch *w)
+        {;}
+
         virtual std::string type()
 	{
 		return "NULL";
@@ -130,7 +130,8 @@ vector<string> Gamess_UK::get_ecp_template(gaussian g)
 		Tokenize(outData[g.values[i].line_number],tokens,"! \n\t");
 		
 		// Replace the value as needed
-		NumberToString(g.values[i].value,tokens[g.values[i].type+1]);
+		// Written in full, so the calculation runs on exactly the ECP the search asked for
+		NumberToString(g.values[i].value,tokens[g.values[i].type+1],round_trip_precision);
 		// This is plus one to offset the r factor at the start of each line
 		
 		// Now reconstruct string and submit back to outData
@@ -148,21 +149,30 @@ vector<string> Gamess_UK::get_ecp_template(gaussian g)
 }
 
 /*
- Decodes the Gamess-UK output
+ Decodes the Gamess-UK output. The file is read through a line at a time, and
+ reading stops as soon as the MOs and the DMA have been taken in, so the rest
+ of the output is never touched.
  
- @param[in] gamess_uk_output Vector containing string output
+ @param[in] gamess_uk_output Filename of the Gamess-UK output
  @param[in] g Current gaussian being investigated
  @param[in] r1_anions Number of anions in R1 
  @param[in] r1_species Array of types for R1 species
+ @param[in] critical Catch for critical errors to terminate program if the output is missing
  @return gaussian Updated information on the ECP
  */
-gaussian Gamess_UK::digest_electronic(vector<string> gamess_uk_output, gaussian g, int r1_anions, vector<string> r1_species)
+gaussian Gamess_UK::digest_electronic(string gamess_uk_output, gaussian g, int r1_anions, vector<string> r1_species, bool critical)
 {
+	gamess_uk_state s;
 	// Zero all the counters we use
-	int MO_line_number = 0;
-        int DMA_line_number = 0;
-	int number_electrons = 0;
-	int spin_counter = 0;
+	s.line_number = 0;
+	s.number_electrons = 0;
+	s.spin_counter = 0;
+	s.MO_line_number = 0;
+	s.reading_MOs = false;
+	s.DMA_line_number = 0;
+	s.DMA_stage = DMA_NONE;
+	s.DMA_match = -1;
+	s.finished = false;
 	// Zero gaussian counters
 	//g.anion_max = -1000.0;
 	//g.anion_min = 1000.0;
@@ -193,72 +203,36 @@ gaussian Gamess_UK::digest_electronic(vector<string> gamess_uk_output, gaussian
 	
 	if (!g.failed)
 	{
-		for (vector<string>::size_type i = 0; i < gamess_uk_output.size(); i++)
+		Line_Reader reader(gamess_uk_output, critical);
+		line_view line;
+		// Reused for every line, so tokenising doesn't allocate
+		vector<line_view> tokens;
+
+		while (!s.finished && reader.next(&line))
 		{
-			vector<string> tokens;
-			Tokenize(gamess_uk_output[i],tokens,"= \n\t");
-			
-			if ((tokens.size() > 4) && MO_line_number == 0)
-			{
-				// We need to find this line and get the number of electrons
-				// Effective total no. of electrons =   98
-				// Or such like And it appears before the MOs
-				// We only need to do this if number of electrons isn't defined, as it shouldn't change
-				if (number_electrons == 0)
-				{
-					if (cmpStr(tokens[0],"Effective") &&
-						cmpStr(tokens[1],"total") &&
-						cmpStr(tokens[2],"no.") &&
-						cmpStr(tokens[3],"of") &&
-						cmpStr(tokens[4],"electrons"))
-					{
-						// Save number of electrons. This seems to work fine
-						StringToNumber(tokens[5],number_electrons);
-					}
-				}
-				else if (number_electrons%2 == 0)
-				{
-					// Setting i to gamess_uk_output gives us an exit route
-					// This is now disabled, and this process just returns i as is
-					i = digest_rhf(tokens, &gamess_uk_output, &MO_line_number, 
-								   &g, i, number_electrons);
-				}
-				else
-				{
-					// This is for unhestricted calculation
-					spin_counter = digest_uhf(tokens, &gamess_uk_output, &MO_line_number, 
-								   &g, i, number_electrons, spin_counter);
-
-					// cout << spin_counter << " " << MO_line_number << endl;
-					if (spin_counter == 1)
-					{
-						MO_line_number = 0;
-					}
-					// If DMA is not needed this can be used
-					//else if (spin_counter == 2)
-					//{
-					//	 i = gamess_uk_output.size();
-					//}
-				}
-			} 
-			// By checking the number of electrons we will only call this after
-			// we have made a decent way through the output
-			else if ((tokens.size() == 4 && number_electrons != 0))
-			{
-				// Now we are looking for distributed multipole analysis.
-                                i = digest_dma(tokens, &gamess_uk_output, &DMA_line_number, &g, i);
-			}
+			digest_line(line, &tokens, &s, &g);
+		}
+
+		// Anything still being read ran to the end of the file
+		if (s.reading_MOs)
+		{
+			finish_MOs(&s, &g);
+		}
+
+		if ((s.DMA_stage != DMA_NONE) && (s.DMA_stage != DMA_DONE))
+		{
+			finish_dma(&s, &g);
 		}
 		
 		// MOs were not found and read in
 		// We'll count this as failures
-		if (MO_line_number == 0)
+		if (s.MO_line_number == 0)
 		{
 			g.failed = true;
 			cout << "Critical Failure: Getting MOs" << endl;
 		}
 		
-		//if (DMA_line_number == 0)
+		//if (s.DMA_line_number == 0)
 		//{
 		//	cout << "Non-critical Failure: Getting DMA" << endl;	
 		//}
@@ -279,7 +253,7 @@ gaussian Gamess_UK::digest_electronic(vector<string> gamess_uk_output, gaussian
                 cout << g.orbital_spread[0].spread*hartree_to_eV << ")" << endl;
 		cout << endl;
 
-		if (DMA_line_number != 0)
+		if (s.DMA_line_number != 0)
 		{
 			cout << "**TESTING**" << endl;
 			for (vector<min_max_spread>::size_type i = 0; i < g.dma_spread.size(); i++)
@@ -310,421 +284,411 @@ gaussian Gamess_UK::digest_electronic(vector<string> gamess_uk_output, gaussian
 }
 
 /*
- Method designed to take aprt the restricted hartree-fock output from Gamess-UK
- 
- @param[in] tokens Current line contents
- @param[in/out] gamess_uk_output Vector of output content
- @param[in/out] MO_line_number The position in the file where the MOs start
- @param[in/out] g Updating gaussin ECP
- @param[in] i Current index in the gamesS_uk_output
- @param[in] en Number of electrons
+ Take in one line of the Gamess-UK output, and update what we know.
  
- @return int Index for continued search
+ @param[in] line Current line
+ @param[in/out] tokens Space to tokenise the line into
+ @param[in/out] s Where we are up to in the output
+ @param[in/out] g Updating gaussian ECP
  */
-int Gamess_UK::digest_rhf(vector<string> tokens, vector<string> *gamess_uk_output, int *MO_line_number, 
-						  gaussian *g, int i, int en)
+void Gamess_UK::digest_line(line_view line, vector<line_view> *tokens, gamess_uk_state *s, gaussian *g)
 {
-	/** This is the proceeding line from the outputs before we get the MOs
-	 ========================================================
-	 m.o. irrep        orbital         orbital       orbital
-	 energy (a.u.)   energy (e.v.)     occupancy
-	 ========================================================
-	 So we need to characterise this in the output **/
-	
-	// This will find the start of the MOs
-	if (cmpStr(tokens[0],"m.o.") &&
-		cmpStr(tokens[1],"irrep") &&
-		cmpStr(tokens[2],"orbital") &&
-		cmpStr(tokens[3],"orbital") &&
-		cmpStr(tokens[4],"orbital"))
-	{
-		tokens.clear();
-		*MO_line_number = i + 3; // Skip forward to where MOs start
-		double value = 0.0;
-		
-		// Firstly lets work out the spread of Anion Orbitals 
-		// Find Anion minimum
-		Tokenize(gamess_uk_output->at(*MO_line_number+region_1_anion_offset),tokens," \n\t");
-		StringToNumber(tokens[2],value);
-		g->orbital_spread[0].min = value;
-		
-		// Find Anion maximum
-		tokens.clear();
-		Tokenize(gamess_uk_output->at(*MO_line_number+region_1_anion_offset+(g->orbital_spread[0].quantity)-1),tokens," \n\t");
-		StringToNumber(tokens[2],value);
+	int i = s->line_number;
+	s->line_number++;
 
-                //cout << g->anion_min << " " << value << " " << region_1_anion_offset << endl;
-		
-		g->orbital_spread[0].max = value;
-		g->orbital_spread[0].spread = g->orbital_spread[0].max - g->orbital_spread[0].min;
-		
-		// Lets work out the average of the Anion Orbital 
-		for (int a = region_1_anion_offset; a < (g->orbital_spread[0].quantity)+region_1_anion_offset; a++)
-		{
-			// Clear tokens
-			tokens.clear();
-			// cout << gamess_uk_output[*MO_line_number+a] << endl;
-			Tokenize(gamess_uk_output->at(*MO_line_number+a),tokens," \n\t");
-			StringToNumber(tokens[2],value);
-			//cout << tokens[2] << " " << value << " " << r1_anions << endl;
-			g->orbital_spread[0].average += value;
-		}
-		g->orbital_spread[0].average /= g->orbital_spread[0].quantity;
-		
-		// Now lets set the HOMO and LUMO values
-		tokens.clear();
-		Tokenize(gamess_uk_output->at(*MO_line_number+(en/2)-1),tokens," \n\t");
-		StringToNumber(tokens[2],g->HOMO_value);
-		tokens.clear();
-		Tokenize(gamess_uk_output->at(*MO_line_number+(en/2)),tokens," \n\t");
-		StringToNumber(tokens[2],g->LUMO_value);
-		// And we're done! Now to print these an see if they are right....
-		// We'll do that outside the loop
-
-		// Prior to DMA this was used. The use of DMA doubles the output_read process. Hey ho.	
-		// This will break us out of the loop now we have the information we want
-		// return gamess_uk_output->size();
-
-		// Lets at least skip to the last read electrons
-		return i + (en/2);
-	}
-	
-	// No luck finding results, return i
-	return i;
-	
-}
+	split_view(line,*tokens,"=");
 
-/*
- Method designed to take apart the unrestricted hartree-fock output from Gamess-UK
- 
- @param[in] tokens Current line contents
- @param[in/out] gamess_uk_output Vector of output content
- @param[in/out] MO_line_number The position in the file where the MOs start
- @param[in/out] g Updating gaussin ECP
- @param[in] i Current index in the gamesS_uk_output
- @param[in] en Number of electrons
- @param[in] spin_counter Check if we are doing alpha or beta
- 
- @return int Index for continued search
- */
-int Gamess_UK::digest_uhf(vector<string> tokens, vector<string> *gamess_uk_output, int *MO_line_number, 
-						  gaussian *g, int i, int en, int spin_counter)
-{
-	// Now we need to extract the Anion 1s spread, the HOMO and LUMO values
-	// We should be able to recalculate this from the input files.
-	
 	/** This is the proceeding line from the outputs before we get the MOs
 	 ========================================================
 	 m.o. irrep        orbital         orbital       orbital
 	 energy (a.u.)   energy (e.v.)     occupancy
 	 ========================================================
-	 So we need to characterise this in the output **/
-	
-	// This will find the start of the MOs
-	if (cmpStr(tokens[0],"m.o.") &&
-		cmpStr(tokens[1],"irrep") &&
-		cmpStr(tokens[2],"orbital") &&
-		cmpStr(tokens[3],"orbital") &&
-		cmpStr(tokens[4],"orbital"))
-	{
-		tokens.clear();
-		*MO_line_number = i + 3; // Skip forward to where MOs start
-		double value = 0.0;
-
-		// cout << i << " " << *MO_line_number << endl;
-
-		// Firstly lets work out the spread of Anion Orbitals 
-		// tokens.clear();
-		Tokenize(gamess_uk_output->at(*MO_line_number+region_1_anion_offset),tokens," \n\t");
-		StringToNumber(tokens[2],value);
-
-		//cout << gamess_uk_output->at(*MO_line_number+region_1_anion_offset) << endl;
-		//cout << spin_counter << " " << g->anion_min << " " << value << " " << tokens[2] <<  endl;
-
-		// Getting minimum value of Anion Orbitals
-		// Check if this is the first or second loop through
-		// And get spread inclusive of alpha and beta values
-		if (spin_counter == 0)
+	 and the MOs then follow one per line until the table ends **/
+	if (s->reading_MOs)
+	{
+		if (i < s->MO_line_number)
 		{
-			g->orbital_spread[0].min = value;
+			return;
 		}
-		else
-		{
-			// Compare to previous value
-			if (g->orbital_spread[0].min > value)
-			{
-				// Save if lower
-				g->orbital_spread[0].min = value;
-			}
-		}
-		//cout << spin_counter << " " << g->anion_min << " " << value << endl;
 
-		tokens.clear();
-		Tokenize(gamess_uk_output->at(*MO_line_number+region_1_anion_offset+(g->orbital_spread[0].quantity)-1),tokens," \n\t");
-		StringToNumber(tokens[2],value);
-		
-		// Getting minimum value of Anion S Orbital 
-		// Check if this is the first or second loop through
-		// And get spread inclusive of alpha and beta values
-		if (spin_counter == 0)
+		if (tokens->size() > 4)
 		{
-			g->orbital_spread[0].max = value;
+			double value = 0.0;
+			ViewToNumber(tokens->at(2),value);
+			s->MO_energy.push_back(value);
+			// This should probably be a threshold, and not a fixed value
+			// but for now this will do the job we need
+			s->MO_single.push_back(cmpView(tokens->at(4),"1.0000"));
+			return;
 		}
-		else
+
+		// End of the table
+		finish_MOs(s,g);
+	}
+
+	if (s->MO_line_number == 0)
+	{
+		if (tokens->size() > 4)
 		{
-			// Compare to previous value
-			if (g->orbital_spread[0].max < value)
+			// We need to find this line and get the number of electrons
+			// Effective total no. of electrons =   98
+			// Or such like And it appears before the MOs
+			// We only need to do this if number of electrons isn't defined, as it shouldn't change
+			if (s->number_electrons == 0)
 			{
-				// Save if higher
-				g->orbital_spread[0].max = value;
+				if ((tokens->size() > 5) &&
+				    cmpView(tokens->at(0),"Effective") &&
+				    cmpView(tokens->at(1),"total") &&
+				    cmpView(tokens->at(2),"no.") &&
+				    cmpView(tokens->at(3),"of") &&
+				    cmpView(tokens->at(4),"electrons"))
+				{
+					// Save number of electrons. This seems to work fine
+					ViewToNumber(tokens->at(5),s->number_electrons);
+				}
+			}
+			else if (cmpView(tokens->at(0),"m.o.") &&
+				 cmpView(tokens->at(1),"irrep") &&
+				 cmpView(tokens->at(2),"orbital") &&
+				 cmpView(tokens->at(3),"orbital") &&
+				 cmpView(tokens->at(4),"orbital"))
+			{
+				s->MO_line_number = i + 3; // Skip forward to where MOs start
+				s->MO_energy.clear();
+				s->MO_single.clear();
+				s->reading_MOs = true;
 			}
 		}
-		//cout << g->anion_min << " " << g->anion_max << endl;
-		
-		// Calculate spread
-		g->orbital_spread[0].spread = g->orbital_spread[0].max - g->orbital_spread[0].min;
-	
-		// Lets work out the average of the anions, summing over all values
-		for (int a = region_1_anion_offset; a < g->orbital_spread[0].quantity; a++)
-		{
-			// cout << spin_counter << endl;
-			// Clear tokens
-			tokens.clear();
-			// cout << gamess_uk_output[*MO_line_number+a] << endl;
-			Tokenize(gamess_uk_output->at(*MO_line_number+a),tokens," \n\t");
-			StringToNumber(tokens[2],value);
-			// cout << tokens[2] << " " << value << endl;
-			g->orbital_spread[0].average += value;
-		}
-		
-		// Check spin_counter here to set anion_average
-		if (spin_counter == 1)
-		{
-			// cout << r1os << endl;
-			// Divide through by number of alpha and beta electrons
-			g->orbital_spread[0].average /= (g->orbital_spread[0].quantity*2);
-		}
-		
-		// Now lets set the HOMO and LUMO values
-		tokens.clear();
-		
-		// We don't know if the extra electron will be alpha or beta
-		// So will have to do a rough search
-		int j = *MO_line_number+(en/2)-1;
-		Tokenize(gamess_uk_output->at(j),tokens," \n\t");
-		
-		// This should probably be a threshold, and not a fixed value
-		// but for now this will do the job we need
-		while (cmpStr(tokens[4],"1.0000"))
-		{
-			j++;
-			tokens.clear();
-			Tokenize(gamess_uk_output->at(j),tokens," \n\t");
-                        // cout << spin_counter << " " << j << " " << tokens[4] << endl;
-		}
-		
-		Tokenize(gamess_uk_output->at(j+1),tokens," \n\t");
-		StringToNumber(tokens[2],value);
-		
-		// Getting LUMO value
-		// Check if this is the first or second loop through
-		// We want the lowest value we can find
-		if (spin_counter == 0)
-		{
-			g->LUMO_value = value;
-		}
-		else
+	}
+	// Once all the MOs are in we can look for the DMA
+	else if (!s->reading_MOs)
+	{
+		if (s->DMA_stage == DMA_NONE)
 		{
-			// Compare to previous value
-			if (g->LUMO_value > value)
+			// Now we are looking for distributed multipole analysis.
+			// Keyphrase: distributed multipole analysis module
+			if ((tokens->size() == 4) &&
+			    cmpView(tokens->at(0),"distributed") &&
+			    cmpView(tokens->at(1),"multipole") &&
+			    cmpView(tokens->at(2),"analysis") &&
+			    cmpView(tokens->at(3),"module"))
 			{
-				// Save if higher
-				g->LUMO_value = value;
+				s->DMA_line_number = i + 16; // Skip forward to where the sites start
+				s->DMA_stage = DMA_START;
 			}
 		}
-		
-		tokens.clear();
-		Tokenize(gamess_uk_output->at(j-1),tokens," \n\t");
-		StringToNumber(tokens[2],value);
-		
-		// Getting HOMO value
-		// Check if this is the first or second loop through
-		// We want the highest value we can find
-		if (spin_counter == 0)
+		else
 		{
-			g->HOMO_value = value;
+			// The DMA values are only separated by whitespace
+			split_view(line,*tokens);
+			digest_dma(tokens,s,g,i);
 		}
-		else
+	}
+
+	// The DMA comes after the MOs, so nothing more to be gained from the rest of the file
+	if (s->DMA_stage == DMA_DONE)
+	{
+		s->finished = true;
+	}
+}
+
+/*
+ Take in one line of the Gamess-UK output while the calculation is still running.
+ The SCF cycles are tabulated as
+ ==============================================================================
+ cycle           total       energy          electronic        energy   ...
+                 energy      change             energy                  ...
+ ==============================================================================
+     1     0   0    -75.58589812     -75.58589812     -84.56073040      ...
+ and the total energy is the first number with a decimal point.
+ Overflowed values are printed as stars, and are taken as infinite.
+ The table is closed by another rule
+ 
+ @param[in] line Current line
+ @param[in/out] tokens Space to tokenise the line into
+ @param[in/out] w What has been seen of the SCF so far
+ */
+void Gamess_UK::watch_line(line_view line, vector<line_view> *tokens, scf_watch *w)
+{
+	split_view(line,*tokens);
+
+	if (tokens->size() == 0)
+	{
+		return;
+	}
+
+	if (view_contains(line,"error detected") ||
+	    view_contains(line,"excessive number of iterations"))
+	{
+		line_view message;
+		message.start = tokens->front().start;
+		message.length = tokens->back().start + tokens->back().length - message.start;
+		w->reason = "GAMESS-UK reports: " + view_to_string(message);
+		return;
+	}
+
+	if ((tokens->size() > 2) &&
+	    cmpView(tokens->at(0),"cycle") &&
+	    cmpView(tokens->at(1),"total") &&
+	    cmpView(tokens->at(2),"energy"))
+	{
+		// A new SCF starts from scratch
+		w->in_table = true;
+		w->cycles = 0;
+		w->energies.clear();
+		return;
+	}
+
+	if (!w->in_table)
+	{
+		return;
+	}
+
+	int cycle = 0;
+
+	if ((tokens->size() > 3) && !view_contains(tokens->at(0),".") && ViewToNumber(tokens->at(0),cycle))
+	{
+		for (vector<line_view>::size_type j = 1; j < tokens->size(); j++)
 		{
-			// Compare to previous value
-			if (g->HOMO_value < value)
+			if (view_contains(tokens->at(j),"."))
+			{
+				double energy = 0.0;
+				ViewToNumber(tokens->at(j),energy);
+				w->energies.push_back(energy);
+				w->cycles++;
+				return;
+			}
+			else if (view_contains(tokens->at(j),"*"))
 			{
-				// Save if higher
-				g->HOMO_value = value;
+				w->energies.push_back(HUGE_VAL);
+				w->cycles++;
+				return;
 			}
 		}
-		
-		// And we're done! Now to print these an see if they are right....
-		// We'll do that outside the loop
-		
-		// We need this to check if we have been through twice
-		// And picked alpha and beta values
-		
-		// Increment spin_counter
-		spin_counter++;
 	}
-	
-	// Haven't found all the results, return spin_counter
-	return spin_counter;
+	// Messages can be printed between cycles, so only the closing rule, or the MOs, end the table
+	else if (((w->cycles > 0) && ((tokens->at(0).start[0] == '=') || (tokens->at(0).start[0] == '-'))) ||
+		 cmpView(tokens->at(0),"m.o."))
+	{
+		w->in_table = false;
+	}
 }
 
 /*
- Method designed to take aprt the DMA output from Gamess-UK
+ Work out the HOMO, LUMO and anion orbital spread once a table of MOs has been read.
+ An odd number of electrons means an unrestricted calculation, with a table for
+ Alpha and then Beta, and the spread is taken over both.
  
- @param[in] tokens Current line contents
- @param[in/out] gamess_uk_output Vector of output content
- @param[in/out] DMA_line_number The position in the file where the DMAs start
- @param[in/out] g Updating gaussin ECP
- @param[in] i Current index in the gamesS_uk_output
- 
- @return int Index for continued search
+ @param[in/out] s Where we are up to in the output, including the MO energies
+ @param[in/out] g Updating gaussian ECP
  */
-int Gamess_UK::digest_dma(vector<string> tokens, vector<string> *gamess_uk_output, int *DMA_line_number,
-                                                  gaussian *g, int i)
+void Gamess_UK::finish_MOs(gamess_uk_state *s, gaussian *g)
 {
-	// This needs testing for a UHF system
+	s->reading_MOs = false;
 
-	// Now we are looking for distributed multipole analysis.
-        // Keyphrase: distributed multipole analysis module
-        if (cmpStr(tokens[0],"distributed") &&
-            cmpStr(tokens[1],"multipole") &&
-            cmpStr(tokens[2],"analysis") &&
-            cmpStr(tokens[3],"module"))
-        {
+	vector<double> &MO_energy = s->MO_energy;
+	int quantity = g->orbital_spread[0].quantity;
+	int spin_counter = s->spin_counter;
+	int en = s->number_electrons;
+	bool unrestricted = (en%2 != 0);
+	int lumo = en/2;
 
-		// cout << "FOUND DMA" << endl;
- 
-                *DMA_line_number = i + 16; // Skip forward to where MOs start
-		int DMA_step = 0;
-		double value = 0.0;
+	if (unrestricted)
+	{
+		// We don't know if the extra electron will be alpha or beta
+		// So search on from the last orbital we know is filled
+		lumo = (en/2)-1;
 
-		tokens.clear();
-                Tokenize(gamess_uk_output->at(*DMA_line_number),tokens," \n\t");
+		while ((lumo >= 0) && (lumo < (int) MO_energy.size()) && s->MO_single[lumo])
+		{
+			lumo++;
+		}
+	}
 
-		// cout << gamess_uk_output->at(*DMA_line_number) << endl;
+	// Make sure we have found enough MOs to look at
+	int highest = max(lumo,region_1_anion_offset+max(quantity-1,0));
 
-		while ( cmpStr(tokens[4].substr(tokens[4].length()-1),"1") )
+	if ((lumo < 1) || (highest >= (int) MO_energy.size()))
+	{
+		s->MO_line_number = 0;
+		return;
+	}
+
+	// Firstly lets work out the spread of Anion Orbitals 
+	// Check if this is the first or second loop through
+	// And get spread inclusive of alpha and beta values
+	if ((spin_counter == 0) || (g->orbital_spread[0].min > MO_energy[region_1_anion_offset]))
+	{
+		g->orbital_spread[0].min = MO_energy[region_1_anion_offset];
+	}
+
+	// Find Anion maximum
+	if ((spin_counter == 0) || (g->orbital_spread[0].max < MO_energy[region_1_anion_offset+quantity-1]))
+	{
+		g->orbital_spread[0].max = MO_energy[region_1_anion_offset+quantity-1];
+	}
+
+	g->orbital_spread[0].spread = g->orbital_spread[0].max - g->orbital_spread[0].min;
+
+	// Lets work out the average of the Anion Orbital 
+	for (int a = region_1_anion_offset; a < quantity+region_1_anion_offset; a++)
+	{
+		g->orbital_spread[0].average += MO_energy[a];
+	}
+
+	if (!unrestricted)
+	{
+		g->orbital_spread[0].average /= quantity;
+	}
+	else if (spin_counter == 1)
+	{
+		// Divide through by number of alpha and beta electrons
+		g->orbital_spread[0].average /= (quantity*2);
+	}
+
+	// Now lets set the HOMO and LUMO values
+	// We want the highest HOMO and lowest LUMO we can find across both spins
+	if ((spin_counter == 0) || (g->HOMO_value < MO_energy[lumo-1]))
+	{
+		g->HOMO_value = MO_energy[lumo-1];
+	}
+
+	if ((spin_counter == 0) || (g->LUMO_value > MO_energy[lumo]))
+	{
+		g->LUMO_value = MO_energy[lumo];
+	}
+
+	if (unrestricted)
+	{
+		// We need this to check if we have been through twice
+		// And picked alpha and beta values
+		s->spin_counter++;
+
+		// Go back to looking for the Beta table
+		if (s->spin_counter == 1)
 		{
-			
-/**
-Here is the setup I used and the values we are trying to fill:
-        g.dma_spread.resize(r1_species.size());
-        for (vector<min_max_spread>::size_type i = 0; i < g.dma_spread.size(); i++)
-        {
-                g.dma_spread[i].max = -1000.0;
-                g.dma_spread[i].min =  1000.0;
-                g.dma_spread[i].average = 0.0;
-                g.dma_spread[i].spread  = 0.0;
-                g.dma_spread[i].quantity =  0;
-                g.dma_spread[i].label    = r1_species[i];
-        }
-**/			
-			int int_match = -1;
-
-			// Find the matching species
-			for (vector<min_max_spread>::size_type j = 0; j < g->dma_spread.size(); j++)
-			{
-				bool match = true;
-
-				if (tokens[4].length() == g->dma_spread[j].label.length()+1)
-                               	{
-                               		for (size_t ichar = 0; ichar < g->dma_spread[j].label.length(); ichar++ )
-                                       	{
-                                       		if ( toupper(tokens[4][ichar]) != g->dma_spread[j].label[ichar])
-                                               	{
-                                                       	match = false;
-                                               	}
-                                       	}
-
-                                       	if (match)
-                                       	{
-                                 	 	int_match = j;
-						g->dma_spread[j].quantity++;
-						// Quick exit?
-						j = g->dma_spread.size();
-                                        }
-                                }	
-			}
+			s->MO_line_number = 0;
+		}
+	}
+}
 
-			// cout << DMA_step << " " << int_match << " " << tokens[4];
-	
-			tokens.clear();
-			DMA_step++;
-			Tokenize(gamess_uk_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
-
-			// Find modulus of dipolar expansion
-                        while ( !cmpStr(tokens[0],"|q2|") )
-                        {
-                                tokens.clear();
-                                DMA_step++;
-                                Tokenize(gamess_uk_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
-
-				// Catch scenario where we have a blank line
-                                while ( tokens.size() == 0 )
-                                {
-                                        tokens.clear();
-                                        DMA_step++;
-                                        Tokenize(gamess_uk_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
-                                }
-                        }
-
-			// cout << " : " << tokens[0] << " " << tokens[1] << " " << " " << tokens[2] << endl;
+/*
+ Take apart the DMA output from Gamess-UK, one line at a time. Each site looks like
+
+ site     x    y    z    O1
+  ...
+ |q2|  =  value
+
+ and the sites carry on while their label ends in 1.
+ 
+ @param[in] tokens Current line contents, split on whitespace only
+ @param[in/out] s Where we are up to in the output
+ @param[in/out] g Updating gaussian ECP
+ @param[in] i Current line index in the output
+ */
+void Gamess_UK::digest_dma(vector<line_view> *tokens, gamess_uk_state *s, gaussian *g, int i)
+{
+	// This needs testing for a UHF system
 
+	if (s->DMA_stage == DMA_START)
+	{
+		if (i < s->DMA_line_number)
+		{
+			return;
+		}
+		s->DMA_stage = DMA_SITE;
+	}
+	else if (s->DMA_stage == DMA_FIND_SITE)
+	{
+		// Find next start point
+		if ((tokens->size() == 0) || !cmpView(tokens->at(0),"site"))
+		{
+			return;
+		}
+		s->DMA_stage = DMA_SITE;
+	}
+	else if (s->DMA_stage == DMA_FIND_Q2)
+	{
+		// Find modulus of dipolar expansion
+		if ((tokens->size() > 2) && cmpView(tokens->at(0),"|q2|"))
+		{
 			// Get DMA value, and store information for later analysis
-		        StringToNumber(tokens[2],value);
+			double value = 0.0;
+			ViewToNumber(tokens->at(2),value);
 
-			g->dma_spread[int_match].average += value;
-			
-			if ( value > g->dma_spread[int_match].max )	
+			if (s->DMA_match >= 0)
 			{
-				g->dma_spread[int_match].max = value;
-			}
+				min_max_spread &m = g->dma_spread[s->DMA_match];
+
+				m.average += value;
 			
-			if ( value < g->dma_spread[int_match].min )
-			{
-				g->dma_spread[int_match].min = value;
+				if ( value > m.max )	
+				{
+					m.max = value;
+				}
+			
+				if ( value < m.min )
+				{
+					m.min = value;
+				}
 			}
 
-			// Find next start point
-			while ( !cmpStr(tokens[0],"site") )
-                	{
-				tokens.clear();
-				DMA_step++;
-				Tokenize(gamess_uk_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
+			s->DMA_stage = DMA_FIND_SITE;
+		}
+		return;
+	}
+
+	// So this is a site. Carry on while the labels are those with a 1 on the end
+	if ((tokens->size() < 5) || !view_ends_with(tokens->at(4),'1'))
+	{
+		finish_dma(s,g);
+		return;
+	}
+
+	s->DMA_match = -1;
 
-				// Catch scenario where we have a blank line
-				while ( tokens.size() == 0 )
+	// Find the matching species
+	line_view label = tokens->at(4);
+
+	for (vector<min_max_spread>::size_type j = 0; j < g->dma_spread.size(); j++)
+	{
+		if (label.length == g->dma_spread[j].label.length()+1)
+		{
+			bool match = true;
+
+			for (size_t ichar = 0; ichar < g->dma_spread[j].label.length(); ichar++ )
+			{
+				if ( toupper(label.start[ichar]) != g->dma_spread[j].label[ichar])
 				{
-					tokens.clear();
-					DMA_step++;
-					Tokenize(gamess_uk_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
+					match = false;
 				}
-			}				
+			}
+
+			if (match)
+			{
+				s->DMA_match = j;
+				g->dma_spread[j].quantity++;
+				break;
+			}
 		}
+	}
+
+	s->DMA_stage = DMA_FIND_Q2;
+}
+
+/*
+ Work out the DMA spreads once all the sites have been read
+
+ @param[in/out] s Where we are up to in the output
+ @param[in/out] g Updating gaussian ECP
+ */
+void Gamess_UK::finish_dma(gamess_uk_state *s, gaussian *g)
+{
+	for (vector<min_max_spread>::size_type j = 0; j < g->dma_spread.size(); j++)
+	{
+		g->dma_spread[j].spread = g->dma_spread[j].max - g->dma_spread[j].min;
+		g->dma_spread[j].average /= g->dma_spread[j].quantity;
+	}
 
-		for (vector<min_max_spread>::size_type j = 0; j < g->dma_spread.size(); j++)
-                {
-			g->dma_spread[j].spread = g->dma_spread[j].max - g->dma_spread[j].min;
-			g->dma_spread[j].average /= g->dma_spread[j].quantity;
-                }
-                
-		// And we're done! Now to print these an see if they are right....
-                // We'll do that outside the loop
-
-                // This will break us out of the loop now we have the information we want
-                return gamess_uk_output->size();
-        }
-
-        // No luck finding results, return i
-        return i;
+	s->DMA_stage = DMA_DONE;
 }
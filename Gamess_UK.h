@@ -18,6 +18,7 @@
 #include "Utils.h"
 #include "Structures.h"
 #include "DFT_Program.h"
+#include "Line_Reader.h"
 
 class Gamess_UK : public DFT_Program {
 	
@@ -37,26 +38,56 @@ public:
 
         std::vector<std::string> get_ecp_template(gaussian g);
 
-	gaussian digest_electronic(std::vector<std::string> gamess_uk_output, gaussian g, int r1_anion, std::vector<std::string> r1_species);
+	gaussian digest_electronic(std::string gamess_uk_output, gaussian g, int r1_anion, std::vector<std::string> r1_species, bool critical);
+
+	void watch_line(line_view line, std::vector<line_view> *tokens, scf_watch *w);
 
         std::string type()
         { return "GAMESS-UK"; }
 	
 private:
+
+	/*
+	 Stages of reading the distributed multipole analysis
+	 */
+	enum dma_stage
+	{
+		DMA_NONE,
+		DMA_START,
+		DMA_SITE,
+		DMA_FIND_Q2,
+		DMA_FIND_SITE,
+		DMA_DONE
+	};
+
+	/*
+	 Everything we need to remember while reading through the output a line at a time
+	 */
+	struct gamess_uk_state
+	{
+		int line_number;
+		int number_electrons;
+		int spin_counter;
+		int MO_line_number;
+		bool reading_MOs;
+		std::vector<double> MO_energy;
+		// True where the orbital occupancy is exactly one, for unrestricted calculations
+		std::vector<bool> MO_single;
+		int DMA_line_number;
+		int DMA_stage;
+		int DMA_match;
+		bool finished;
+	};
 	
 	void calculate_starting_gaussian_ecps();
-	
-	int digest_rhf(std::vector<std::string> tokens, 
-				   std::vector<std::string> *gamess_uk_output, 
-				   int *MO_line_number, gaussian *g, int i, int en);
-	
-	int digest_uhf(std::vector<std::string> tokens, 
-				   std::vector<std::string> *gamess_uk_output, 
-				   int *MO_line_number, gaussian *g, int i, int en, int spin_counter);
 
-        int digest_dma(std::vector<std::string> tokens,
-                                   std::vector<std::string> *gamess_uk_output,
-                                   int *DMA_line_number, gaussian *g, int i);
+	void digest_line(line_view line, std::vector<line_view> *tokens, gamess_uk_state *s, gaussian *g);
+
+	void finish_MOs(gamess_uk_state *s, gaussian *g);
+
+	void digest_dma(std::vector<line_view> *tokens, gamess_uk_state *s, gaussian *g, int i);
+
+	void finish_dma(gamess_uk_state *s, gaussian *g);
 	
 };
 
@@ -25,6 +25,10 @@ Genetic::Genetic(int *seed) : Powells(seed)
 	offspring_size = 0;
 	convergence_criteria = 0;
 	mutation_dynamic = false;
+	asynchronous = false;
+	slots = 0;
+	births_without_change = 0;
+	stream = NULL;
 }
 
 /*
@@ -36,18 +40,21 @@ Genetic::Genetic(int *seed) : Powells(seed)
  @param[in] os The size of the offspring population
  @param[in] cc Convergence criteria to terminate a GA search
  @param[in] md Check for dynamic mutation
+ @param[in] as Replace population members as each ECP finishes, rather than by generation
  */
 void Genetic::set_ga_parameters(int ps,
 				int ms,
 				int os,
 				int cc,
-				bool md)
+				bool md,
+				bool as)
 {
 	population_size = ps;
 	mutations_size = ms;
 	offspring_size = os;
 	convergence_criteria = cc;
 	mutation_dynamic = md;
+	asynchronous = as;
 	
 	// - population size
 	if (population_size == 0)
@@ -78,6 +85,22 @@ void Genetic::set_ga_parameters(int ps,
 	{
 		cout << "Using default mutation type for GA : Static" << endl;
 	}
+	// - steady state
+	if (!asynchronous)
+	{
+		cout << "Using default population update for GA : Generational" << endl;
+	}
+}
+
+/*
+ Set the number of ECPs kept running at once by a steady-state search
+
+ @param[in] bs Number of ECPs to be tested at once
+ @param[in] ts Total number of ECPs to sample (not used)
+ */
+void Genetic::set_sample_parameters(int bs, int ts)
+{
+	slots = bs > 0 ? bs : 1;
 }
 
 /*
@@ -91,12 +114,15 @@ void Genetic::calculate_ecps_to_test()
 	// First off insert random numbers 
 	if (calculate_ecps_to_test_counter == 0)
 	{
-		cout << "Creating a random population of size " << population_size << endl;
+		// A steady-state search starts enough to keep every slot busy
+		const unsigned int initial_size = asynchronous ? max(population_size,slots) : population_size;
+
+		cout << "Creating a random population of size " << initial_size << endl;
 		// Fill the population with random values
-		while (ecps_to_test.size() < population_size)
+		while (ecps_to_test.size() < initial_size)
 		{
 			// Insert random value
-			while (ecps_to_test.size() < population_size)
+			while (ecps_to_test.size() < initial_size)
 			{
 				ecps_to_test.push_back(get_random());
 			}
@@ -174,7 +200,7 @@ void Genetic::calculate_ecps_to_test()
 			while (ecps_to_test.size() > population_size)
 			{
 				// Remove the worst option
-				int i = get_population_worst_option();
+				int i = get_population_worst_option(ecps_to_test);
 				// cout << "Removing member: " << i << endl;
 				ecps_to_test.erase(ecps_to_test.begin()+i);
 			} 
@@ -191,6 +217,13 @@ void Genetic::calculate_ecps_to_test()
  */
 void Genetic::check_converged()
 {
+	// A steady-state search takes each ECP as it finishes
+	if (asynchronous)
+	{
+		update_population();
+		return;
+	}
+
 	// Check if we are calculating mutants and offspring, or population
 	// Compare results to see if we've converged
 
@@ -231,6 +264,158 @@ void Genetic::check_converged()
 	}
 }	
 
+/*
+ Steady-state update. Each ECP that has finished replaces the worst member of the population
+ if it is better, and a new offspring or mutant is made to take its place in the queue.
+ Convergence is counted in generations' worth of ECPs without the best changing
+
+ No param
+ */
+void Genetic::update_population()
+{
+	Trace_Span span("ga population","search");
+
+	ecps_to_test.clear();
+
+	for (vector<gaussian>::size_type i = 0; i < ecps_tested.size(); i++)
+	{
+		births_without_change++;
+
+		// Duplicates add nothing to the population
+		bool duplicate = false;
+		for (vector<gaussian>::size_type j = 0; j < population.size(); j++)
+		{
+			if (compare_ecps(ecps_tested[i],population[j]))
+			{
+				duplicate = true;
+			}
+		}
+
+		if (duplicate)
+		{
+			continue;
+		}
+
+		if (population.size() < population_size)
+		{
+			population.push_back(ecps_tested[i]);
+		}
+		else
+		{
+			int worst = get_population_worst_option(population);
+
+			if (ecps_tested[i].function < population[worst].function)
+			{
+				population[worst] = ecps_tested[i];
+			}
+		}
+	}
+
+	// Find the best member, for selection and convergence
+	number_one_ranked = 0;
+	for (vector<gaussian>::size_type i = 1; i < population.size(); i++)
+	{
+		if (population[i].function < population[number_one_ranked].function)
+		{
+			number_one_ranked = i;
+		}
+	}
+
+	if (!compare_ecps(population[number_one_ranked],previous_minimum))
+	{
+		previous_minimum = population[number_one_ranked];
+		births_without_change = 0;
+	}
+
+	minimisation_count = births_without_change / (offspring_size + mutations_size);
+
+	cout << endl;
+	cout << "Population of " << population.size() << " updated with " << ecps_tested.size() << " ECPs. Best function : " << population[number_one_ranked].function << endl;
+	cout << "Current loops without change : " << minimisation_count << ", Convergence criteria : " << convergence_criteria << endl;
+	cout << endl;
+
+	if (minimisation_count >= convergence_criteria)
+	{
+		converged = true;
+		return;
+	}
+
+	// One new ECP for every one that has come back, so the same number are always running
+	int loop_counter = 0;
+	while (ecps_to_test.size() < ecps_tested.size())
+	{
+		while (ecps_to_test.size() < ecps_tested.size())
+		{
+			if (population.size() < 2)
+			{
+				ecps_to_test.push_back(get_random());
+			}
+			else if (randomNumber(idum,stream) * (offspring_size + mutations_size) < offspring_size)
+			{
+				ecps_to_test.push_back(get_offspring());
+			}
+			else
+			{
+				ecps_to_test.push_back(get_mutant());
+			}
+		}
+		// Give it ten attempts otherwise just accept that some might be the same as we've approached the minima.
+		if (loop_counter < 10)
+		{
+			check_boundaries_duplicates();
+		}
+		loop_counter++;
+	}
+}
+
+/*
+ Returns the best member of the population just formed, to be sent to another island
+
+ @return gaussian Best ECP waiting to be handed out
+ */
+gaussian Genetic::get_migrant()
+{
+	int best = 0;
+	for (vector<gaussian>::size_type i = 1; i < ecps_to_test.size(); i++)
+	{
+		if (ecps_to_test[i].function < ecps_to_test[best].function)
+		{
+			best = i;
+		}
+	}
+
+	return ecps_to_test[best];
+}
+
+/*
+ Takes in a migrant from another island, in place of the worst member of the population just formed.
+ Migrants already in the population, or no better than its worst member, are turned away
+
+ @param[in] g ECP from another island, which has been calculated
+ @return bool True if the migrant has joined the population
+ */
+bool Genetic::add_migrant(gaussian g)
+{
+	for (vector<gaussian>::size_type i = 0; i < ecps_to_test.size(); i++)
+	{
+		if (compare_ecps(g,ecps_to_test[i]))
+		{
+			return false;
+		}
+	}
+
+	int worst = get_population_worst_option(ecps_to_test);
+
+	if (g.function >= ecps_to_test[worst].function)
+	{
+		return false;
+	}
+
+	ecps_to_test[worst] = g;
+
+	return true;
+}
+
 /*
  Returns random ECP within search limits
  
@@ -244,7 +429,7 @@ gaussian Genetic::get_random()
 	// Dynamic initialisation
 	for (vector<gaussian_info>::size_type i = 0; i < g.values.size(); i++)
 	{
-		g.values[i].value = minimums[g.values[i].type] + randomNumberF((maximums[g.values[i].type]-minimums[g.values[i].type]), idum);
+		g.values[i].value = minimums[g.values[i].type] + randomNumberF((maximums[g.values[i].type]-minimums[g.values[i].type]), idum, stream);
 	}
 	
 	return g;
@@ -255,15 +440,16 @@ gaussian Genetic::get_random()
  We should couple this with finding the best in the long term
  As finding the best needs moving out of the Main.cpp
  
+ @param[in] v Population to search
  @param int Index of worst ranked option in population
  */
-int Genetic::get_population_worst_option()
+int Genetic::get_population_worst_option(const vector<gaussian> &v)
 {
 	int worst_option = 0;
 	/** LOOP OVER THE VECTOR AND RETURN WORST OPTIONS **/
-	for (vector<gaussian>::size_type i = 1; i < ecps_to_test.size(); i++)
+	for (vector<gaussian>::size_type i = 1; i < v.size(); i++)
 	{
-		if (ecps_to_test[i].function > ecps_to_test[worst_option].function)
+		if (v[i].function > v[worst_option].function)
 		{
 			worst_option = i;
 		}
@@ -282,17 +468,17 @@ gaussian Genetic::get_offspring()
 {
 	int i = 0;
 	// This is is essentially roulette selection
-	while (randomNumber(idum) > fitness(i))
+	while (randomNumber(idum,stream) > fitness(i))
 	{
-		i = randomNumber(population_size,idum);
+		i = randomNumber(population.size(),idum,stream);
 	}
 	
 	int j = 0;
 	// Select a second parent. Roulette selection
 	// Make sure it isn't the same as the other parent!
-	while ((randomNumber(idum) > fitness(j)) && (j != i))
+	while ((randomNumber(idum,stream) > fitness(j)) && (j != i))
 	{
-		j = randomNumber(population_size,idum);
+		j = randomNumber(population.size(),idum,stream);
 	}
 	
 	// We'll do uniform crossover
@@ -302,7 +488,7 @@ gaussian Genetic::get_offspring()
 	if (g.values.size() < 3)
 	{
 		// The number of values is small. We'll force a mutation
-                i = randomNumber(g.values.size(), idum);
+                i = randomNumber(g.values.size(), idum, stream);
                 // Picked a value, now copy in from second parent
                 g.values[i] = second.values[i];
 		// Set function to big value
@@ -316,7 +502,7 @@ gaussian Genetic::get_offspring()
 		for (vector<double>::size_type k = 0; k < g.values.size(); k++)
 		{
 			// If random number is greater than 0.5, copy in value from second
-			if (randomNumber(idum) > 0.5)
+			if (randomNumber(idum,stream) > 0.5)
 			{
 				g.values[k] = second.values[k];
 				// Set function to big value
@@ -352,9 +538,9 @@ gaussian Genetic::get_mutant()
 {
 	int i = 0;
 	// This is is essentially roulette selection
-	while (randomNumber(idum) > fitness(i))
+	while (randomNumber(idum,stream) > fitness(i))
 	{
-		i = randomNumber(population_size,idum);
+		i = randomNumber(population.size(),idum,stream);
 	}
 	
 	// Get some gaussian values
@@ -362,7 +548,7 @@ gaussian Genetic::get_mutant()
 	gaussian random = get_random();
 	
 	// We are going to mutate in just one direction
-	i = randomNumber(g.values.size(), idum);
+	i = randomNumber(g.values.size(), idum, stream);
 
 	// Dynamic mutation if we are not seeing much variation
 	if (mutation_dynamic)
@@ -396,7 +582,7 @@ double Genetic::fitness(const int pos)
 // Input: Current Selection of Points
 // Output : double of fitness value
 {
-	int worst = get_population_worst_option(); // MAX
+	int worst = get_population_worst_option(asynchronous ? population : ecps_to_test); // MAX
 	int best = number_one_ranked; // MIN
 	double p = ((population[pos].function - population[best].function)/(population[worst].function - population[best].function)); // Normalise
 	// EXPONENTIAL FACTOR //
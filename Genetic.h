@@ -26,7 +26,10 @@ public:
 	 
 	 No params
 	 */
-	Genetic(){}
+	Genetic()
+	{
+		stream = NULL;
+	}
 	
 	Genetic(int *seed);
 	
@@ -41,7 +44,58 @@ public:
 						   int ms,
 						   int os,
 						   int cc,
-						   bool md);
+						   bool md,
+						   bool as);
+
+	virtual void set_sample_parameters(int bs, int ts);
+	
+	/*
+	 Check if the population is updated as each ECP finishes
+	 
+	 @return bool True for a steady-state search
+	 */
+	bool get_asynchronous()
+	{
+		return asynchronous;
+	}
+	
+	/*
+	 Check if a new population has just been formed, and is waiting to be handed out.
+	 This is where migrants can be swapped in
+	 
+	 @return bool True if ecps_to_test holds a new population
+	 */
+	bool get_population_formed()
+	{
+		return (!converged && !asynchronous &&
+			(calculate_ecps_to_test_counter > 1) && (calculate_ecps_to_test_counter%2 == 1));
+	}
+	
+	/*
+	 Number of generations completed
+	 
+	 @return int Generations since the random population
+	 */
+	int get_generation()
+	{
+		return calculate_ecps_to_test_counter/2;
+	}
+	
+	/*
+	 Draw random numbers from a stream of this search's own, rather than the one shared by every search
+
+	 @param[in/out] seed Seed of the stream
+	 @param[in/out] s State of the stream
+	 */
+	void set_random_stream(int *seed, random_stream *s)
+	{
+		idum = seed;
+		stream = s;
+	}
+	
+	gaussian get_migrant();
+	
+	bool add_migrant(gaussian g);
 	
 	/*
 	 Method to print the search type being conducted, common with all other search methods
@@ -64,18 +118,26 @@ protected:
 	unsigned int offspring_size;
 	int convergence_criteria;
 	bool mutation_dynamic;
+	// Steady-state search, with the number of ECPs kept running and how many have come back since the best changed
+	bool asynchronous;
+	unsigned int slots;
+	unsigned int births_without_change;
+	// Stream the random numbers are drawn from, or NULL for the shared one
+	random_stream *stream;
 
 	void calculate_ecps_to_test();
 
 	void check_converged();	
 
+	void update_population();
+
 	gaussian get_random();
 
 	gaussian get_offspring();
 	
 	gaussian get_mutant();
 	
-	int get_population_worst_option();
+	int get_population_worst_option(const std::vector<gaussian> &v);
 	
 	double fitness(const int pos);
 };
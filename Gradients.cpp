@@ -11,112 +11,194 @@
 
 using namespace std;
 
+// Number of regions in the ChemShell model
+static const int number_of_regions = 5;
+
+/*
+ Work out the gradient norm of every centre
+ 
+ @param[in] gradx Gradients along x for each centre
+ @param[in] grady Gradients along y for each centre
+ @param[in] gradz Gradients along z for each centre
+ @param[out] gnorm Norm for each centre
+ @param[in] n Number of centres
+ @param[in] absolute_gradients Use the magnitude of each gradient, rather than the sum of its components
+ */
+static void calculate_gnorms(const double *gradx, const double *grady, const double *gradz,
+			     double *gnorm, int n, bool absolute_gradients)
+{
+	if (absolute_gradients) 
+	{
+		#pragma omp simd
+		for (int i = 0; i < n; i++)
+		{
+			gnorm[i] = sqrt((gradx[i]*gradx[i]) + (grady[i]*grady[i]) + (gradz[i]*gradz[i]));
+		}
+	}
+	else
+	{
+		#pragma omp simd
+		for (int i = 0; i < n; i++)
+		{
+			gnorm[i] = gradx[i] + grady[i] + gradz[i];
+		}
+	}
+}
+
+/*
+ Pick whichever of the largest and smallest values has the greater magnitude, keeping its sign
+ 
+ @param[in] largest Largest value found
+ @param[in] smallest Smallest value found
+ @return double Value furthest from zero
+ */
+static double furthest_from_zero(double largest, double smallest)
+{
+	return (smallest*smallest > largest*largest) ? smallest : largest;
+}
+
+/*
+ Total the gradient norms for every region, and find the largest gradients on each axis,
+ in a single pass over the arrays. Each centre only updates the totals of its own region,
+ which are kept in small arrays indexed by region.
+ 
+ @param[in] gradx Gradients along x for each centre
+ @param[in] grady Gradients along y for each centre
+ @param[in] gradz Gradients along z for each centre
+ @param[in] gnorm Norm for each centre
+ @param[in] centre_regions Region of each centre, counting from one
+ @param[in] n Number of centres
+ @param[out] regions Sum of the norms, and the signed values of the largest magnitude, for each region
+ */
+static void digest_regions(const double *gradx, const double *grady, const double *gradz,
+			   const double *gnorm, const int *centre_regions, int n, regions_data *regions)
+{
+	// Centres outside a region count as zero, so each range starts there
+	double sum[number_of_regions] = {0.0};
+	double x_hi[number_of_regions] = {0.0}, x_lo[number_of_regions] = {0.0};
+	double y_hi[number_of_regions] = {0.0}, y_lo[number_of_regions] = {0.0};
+	double z_hi[number_of_regions] = {0.0}, z_lo[number_of_regions] = {0.0};
+	double n_hi[number_of_regions] = {0.0}, n_lo[number_of_regions] = {0.0};
+	
+	for (int i = 0; i < n; i++)
+	{
+		const int r = centre_regions[i] - 1;
+		
+		if ((r < 0) || (r >= number_of_regions))
+		{
+			continue;
+		}
+		
+		const double x = gradx[i];
+		const double y = grady[i];
+		const double z = gradz[i];
+		const double g = gnorm[i];
+		
+		sum[r] += g;
+		x_hi[r] = (x > x_hi[r]) ? x : x_hi[r];
+		x_lo[r] = (x < x_lo[r]) ? x : x_lo[r];
+		y_hi[r] = (y > y_hi[r]) ? y : y_hi[r];
+		y_lo[r] = (y < y_lo[r]) ? y : y_lo[r];
+		z_hi[r] = (z > z_hi[r]) ? z : z_hi[r];
+		z_lo[r] = (z < z_lo[r]) ? z : z_lo[r];
+		n_hi[r] = (g > n_hi[r]) ? g : n_hi[r];
+		n_lo[r] = (g < n_lo[r]) ? g : n_lo[r];
+	}
+	
+	for (int r = 0; r < number_of_regions; r++)
+	{
+		regions[r].gnorm = sum[r];
+		// Keep a record of maxima for all regions
+		regions[r].gradx_max = furthest_from_zero(x_hi[r],x_lo[r]);
+		regions[r].grady_max = furthest_from_zero(y_hi[r],y_lo[r]);
+		regions[r].gradz_max = furthest_from_zero(z_hi[r],z_lo[r]);
+		regions[r].gnorm_max = furthest_from_zero(n_hi[r],n_lo[r]);
+	}
+}
+
 /*
  Method to take in the gradients, and separate out each region to find the details about each region
  such as min, max, average.
  
- @param[in] gradient_input Vector of lines n containing the gradients input data
+ @param[in] gradient_output Filename of the gradients punch file
  @param[in] total_centres Number of centres in the ChemShell model
  @param[in] centre_regions_total Array giving the total number of centres in each region
  @param[in] centre_regions Array of all centres, detailing their region.
+ @param[in] absolute_gradients Use the magnitude of each gradient, rather than the sum of its components
+ @param[in] critical Catch for critical errors to terminate program if the file is missing
  @return vector<regions_data> Vector of customised structure containing all the gradient information, by region
  */
-vector<regions_data> digest_gradients(vector<string> gradient_input, int total_centres, 
+vector<regions_data> digest_gradients(string gradient_output, int total_centres, 
 				      vector<int> centre_regions_total, vector<int> centre_regions,
-				      bool absolute_gradients)
+				      bool absolute_gradients, bool critical)
 {
-	// Number of regions
-	const int number_of_regions = 5;
-	
 	// Calculate useful information from output file, as used for convergence.
 	// This should be pumped into an output file in a comprehendable setup.
-	// First lets extract the gradients and calculate norms
-	// We need some variables to store the gradients as we go
-	double gradx = 0.0;
-	double grady = 0.0;
-	double gradz = 0.0;
-	double gnorm = 0.0;
+	// First lets extract the gradients into one array per axis,
+	// so the norms and region totals can be worked out in vectorised loops
+	vector<double> gradx;
+	vector<double> grady;
+	vector<double> gradz;
+	gradx.reserve(total_centres);
+	grady.reserve(total_centres);
+	gradz.reserve(total_centres);
 	//
 	// Boolean check
 	bool flag = false;
 	// Setup gnorm counters
 	vector<regions_data> regions(number_of_regions);
-	// Initialise all counters
-	for (int i = 0; i < number_of_regions; i++)
-	{
-		regions[i].gnorm = 0.0;
-		regions[i].gnorm_max = 0.0;
-		regions[i].gradx_max = 0.0;
-		regions[i].grady_max = 0.0;
-		regions[i].gradz_max = 0.0;
-	}
 	
-	// Counter for current centre
-	int centre_count = 0; // Actual centre minus one for array access
-	// Then lets run a for loop over the data
+	// Components of the current centre read so far
+	double grad[3];
+	int component = 0;
+	// Then lets run through the file, which is mapped rather than read in
+	Line_Reader reader(gradient_output, critical);
+	line_view line;
+	// Reused for every line, so tokenising doesn't allocate
+	vector<line_view> tokens;
 	
-	for (vector<string>:: size_type i = 0; i < gradient_input.size(); i++)
+	// Once every centre is read there is nothing left we need
+	while (((int) gradx.size() < total_centres) && reader.next(&line))
 	{
-		vector<string> tokens;
-		// gradient_input_string = gradient_input[i];
-		// string temp = gradient_input[i];
-		// cout << i << " " << gradient_input.size() << endl;
-		Tokenize(gradient_input[i],tokens,"= \n\t");
-		// cout << "out" << endl;
-		
-		if ((!flag) && (tokens.size() > 2))
+		if (!flag)
 		{
+			split_view(line,tokens,"=");
+			
 			// block = dense_real_matrix = <number of atoms> is the line in the punch file which marks the atomic coordinates
-			if (cmpStr(tokens[0],"block") && 
-				cmpStr(tokens[1],"dense_real_matrix"))
+			if ((tokens.size() > 2) &&
+				cmpView(tokens[0],"block") && 
+				cmpView(tokens[1],"dense_real_matrix"))
 			{
 				flag = true;
 			}
 		}
-		else if ((flag) && (centre_count < total_centres))
+		else
 		{
-			StringToNumber(gradient_input[i],gradx);
-			StringToNumber(gradient_input[i+1],grady);
-			StringToNumber(gradient_input[i+2],gradz);
+			// Each centre has x, y and z on consecutive lines, one number to a line,
+			// so there is no need to tokenise
+			grad[component] = 0.0;
+			ViewToNumber(line,grad[component]);
+			component++;
 			
-			if (absolute_gradients) 
+			if (component == 3)
 			{
-				gnorm = sqrt((gradx*gradx) + (grady*grady) + (gradz*gradz));
+				gradx.push_back(grad[0]);
+				grady.push_back(grad[1]);
+				gradz.push_back(grad[2]);
+				component = 0;
 			}
-			else
-			{
-				gnorm = gradx + grady + gradz;
-			}
-			// We need to increment the line number so we are at the next variable
-			// Just incremented by two as it'll be incremented again by the for loop
-			i += 2;
-			// We need to check what region the current atom is associated with
-			regions[centre_regions[centre_count]-1].gnorm +=  gnorm;
-			//cout << regions[centre_regions[centre_count]-1].gnorm << endl;
-			
-			// Keep a record of maxima for all regios
-			if (gradx*gradx > regions[centre_regions[centre_count]-1].gradx_max*regions[centre_regions[centre_count]-1].gradx_max)
-			{
-				regions[centre_regions[centre_count]-1].gradx_max = gradx;
-			}
-			if (grady*grady >regions[centre_regions[centre_count]-1].grady_max*regions[centre_regions[centre_count]-1].grady_max)
-			{
-				regions[centre_regions[centre_count]-1].grady_max = grady;
-			}
-			if (gradz*gradz > regions[centre_regions[centre_count]-1].gradz_max*regions[centre_regions[centre_count]-1].gradz_max)
-			{
-				regions[centre_regions[centre_count]-1].gradz_max = gradz;
-			} 
-			// We don't need to square this one as it'll always be positive
-			if (gnorm*gnorm > regions[centre_regions[centre_count]-1].gnorm_max*regions[centre_regions[centre_count]-1].gnorm_max)
-			{
-				regions[centre_regions[centre_count]-1].gnorm_max = gnorm;
-			}
-			// Increase centre count
-			centre_count++;
 		}
 	}
 	
+	int centre_count = gradx.size();
+	vector<double> gnorm(centre_count);
+	
+	calculate_gnorms(gradx.data(), grady.data(), gradz.data(), gnorm.data(), centre_count, absolute_gradients);
+	
+	// We need to check what region each atom is associated with
+	digest_regions(gradx.data(), grady.data(), gradz.data(), gnorm.data(), centre_regions.data(), centre_count,
+		       regions.data());
+	
 	// If flag isn't true then we failed to find the gradient information
 	// So this must be a system error. Mark as failed
 	if (!flag)
@@ -16,9 +16,10 @@
 // Personal headers
 #include "Utils.h"
 #include "Structures.h"
+#include "Line_Reader.h"
 
-std::vector<regions_data> digest_gradients(std::vector<std::string> gradient_input, int total_centres, 
+std::vector<regions_data> digest_gradients(std::string gradient_output, int total_centres, 
 					   std::vector<int> centre_regions_total, std::vector<int> centre_regions,
-					   bool absolute_gradients);
+					   bool absolute_gradients, bool critical = true);
 
 #endif
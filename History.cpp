@@ -339,54 +339,186 @@ void History::add_to_history(gaussian g)
 		}
 		// Push back on to file
 		ecp_history.push_back(g);
+		index_entry(ecp_history.size()-1);
+	}
+}
+
+/*
+ Weight given to each value when building the index key. These are spread
+ between 0.5 and 1 and never rational multiples of each other, so gaussians
+ that differ only by swapping values around still get different keys.
+ 
+ @param[in] j Position of the value
+ @return double Weight
+ */
+static double index_weight(vector<gaussian_info>::size_type j)
+{
+	double golden = 0.6180339887498949;
+	double w = (j+1)*golden;
+	
+	return 0.5 + 0.5*(w - floor(w));
+}
+
+/*
+ Key used to order gaussians in the index, a weighted sum of their values
+ 
+ @param[in] g Gaussian
+ @return double Key
+ */
+double History::index_key(const gaussian &g)
+{
+	double key = 0.0;
+	
+	for (vector<gaussian_info>::size_type j = 0; j < g.values.size(); j++)
+	{
+		key += index_weight(j)*g.values[j].value;
+	}
+	
+	return key;
+}
+
+/*
+ Add an entry of the history to the index
+ 
+ @param[in] i Position in ecp_history
+ */
+void History::index_entry(int i)
+{
+	double key = index_key(ecp_history[i]);
+
+	if (ecp_history[i].values.size() > longest_entry)
+	{
+		longest_entry = ecp_history[i].values.size();
+	}
+	
+	// A NaN can never match anything, and would upset the ordering
+	if (key == key)
+	{
+		history_index.insert(pair<double,int>(key,i));
+	}
+}
+
+/*
+ Build the index again from scratch, after entries have been removed
+ 
+ No params
+ */
+void History::rebuild_index()
+{
+	history_index.clear();
+	longest_entry = 0;
+	
+	for (vector<gaussian>::size_type i = 0; i < ecp_history.size(); i++)
+	{
+		index_entry(i);
 	}
 }
 
 #define DELTA (0.000001)
 /*
-  Compare current gaussian against those in history
+  Compare current gaussian against those in history.
+  Values match if every one is within DELTA of the history entry, and an entry
+  with more values matches if its first values do. If each value is within DELTA
+  then the keys are within the sum of the weights times DELTA, so only entries
+  with keys in that range are compared value by value. The key of a longer entry
+  also counts its extra values, so while the history holds any entry longer than
+  the gaussian, every entry is compared instead, as before the index.
  
  @param[in] g Gaussian to check through the history for
- @return int Index of the gaussian if found
+ @return int Index of the last matching gaussian if found
  */
 int History::check_history(gaussian g)
 {
 	int does_exist = -1;
+	int g_values_size = g.values.size();
 	
         //cout << size() << endl;
 
-	if (size() > 0)
+	if (size() == 0)
+	{
+		return does_exist;
+	}
+
+	// Nothing to compare, so everything matches
+	if (g_values_size == 0)
+	{
+		return size()-1;
+	}
+
+	// Entries longer than the gaussian can match on their first values alone,
+	// which their keys don't reflect
+	if (longest_entry > g.values.size())
 	{
-		// Loop through the history file. 
-		for (vector<gaussian>::size_type i = 0; i < ecp_history.size(); i++)
+		for (int i = 0; i < size(); i++)
 		{
 			int k = 0;
 
- 			//cout << i << " " << g.values.size() << " " << ecp_history.size() << endl;
-			
-			// Check if we are copying from history OK
-			for (vector<double>::size_type j = 0; j < g.values.size(); j++)
+			if ((int) ecp_history[i].values.size() < g_values_size)
+			{
+				continue;
+			}
+
+			for (int j = 0; j < g_values_size; j++)
 			{
-				//cout << g.values[j].value << endl;
-                                //cout << ecp_history.size() << i << endl;
-                                //cout << ecp_history[i].values.size() << endl;
-                                //cout << ecp_history[i].values[j].value << endl;
-                                //cout << abs(g.values[j].value-ecp_history[i].values[j].value) << endl;
-                                //cout << DELTA << endl;
 				if (abs(g.values[j].value-ecp_history[i].values[j].value) < DELTA)
 				{
-					//cout << "True" << endl;
 					k++;
 				}
 			}
-			
-			int g_values_size = g.values.size();
-			
+
+			// Keep the latest match
 			if (k == g_values_size)
 			{
 				does_exist = i;
 			}
 		}
+
+		return does_exist;
+	}
+
+	double key = index_key(g);
+	double range = 0.0;
+
+	// A NaN value never matches
+	if (key != key)
+	{
+		return does_exist;
+	}
+	
+	for (int j = 0; j < g_values_size; j++)
+	{
+		range += index_weight(j)*DELTA;
+	}
+	// Leave room for rounding in the sums
+	range += 1e-12*(1.0 + fabs(key));
+
+	multimap<double,int>::iterator it = history_index.lower_bound(key-range);
+	multimap<double,int>::iterator last = history_index.upper_bound(key+range);
+
+	for (; it != last; it++)
+	{
+		int i = it->second;
+		int k = 0;
+
+		if ((int) ecp_history[i].values.size() < g_values_size)
+		{
+			continue;
+		}
+			
+		// Check if we are copying from history OK
+		for (int j = 0; j < g_values_size; j++)
+		{
+			if (abs(g.values[j].value-ecp_history[i].values[j].value) < DELTA)
+			{
+				k++;
+			}
+		}
+			
+		// Keep the latest match, as the full search did
+		if ((k == g_values_size) && (i > does_exist))
+		{
+			does_exist = i;
+		}
 	}
 
         //cout << does_exist << endl;
@@ -12,6 +12,7 @@
 #ifndef HISTORY_H
 #define HISTORY_H
 
+#include <map>
 #include <vector>
 // Personal headers
 #include "Utils.h"
@@ -27,7 +28,7 @@ public:
 	 
 	 No params
 	 */
-	History() {;}
+	History() { number_of_entries_last_added = 0; longest_entry = 0; }
 	
 	/*
 	 Deconstructor
@@ -60,6 +61,16 @@ public:
 		return ecp_history;
 	}
 
+	/*
+	 Returns just the entries last added to the history, which are always at the end
+
+	 @return Vector of type gaussian with the new ECPs
+	 */
+	std::vector<gaussian> get_last_added()
+	{
+		return std::vector<gaussian>(ecp_history.end()-number_of_entries_last_added, ecp_history.end());
+	}
+
 	 /*
          Returns the numer of entries last added to the history
 
@@ -145,6 +156,9 @@ public:
 				i++;
 			}
 	        }
+
+		// Everything after a dud has moved, so start the index again
+		rebuild_index();
 	}
 	
 private:
@@ -156,9 +170,10 @@ private:
 	 */
 	void append(std::vector<gaussian> v)
         {
-              if (v.size() > 0)
+              for (std::vector<gaussian>::size_type i = 0; i < v.size(); i++)
               {
-                      ecp_history.insert(ecp_history.end(), v.begin(), v.end());
+                      ecp_history.push_back(v[i]);
+                      index_entry(ecp_history.size()-1);
               }
         }
 
@@ -167,8 +182,22 @@ private:
 	
 	std::vector< std::vector<gaussian_info> > decompose_regions(std::vector<std::string> regions_input);
 	
+	double index_key(const gaussian &g);
+
+	void index_entry(int i);
+
+	void rebuild_index();
+	
 	std::vector<gaussian> ecp_history;
 
+	// Positions in ecp_history, sorted by a weighted sum of their values.
+	// Gaussians that match within tolerance have keys close together, so
+	// check_history only has to compare against a narrow range of these.
+	std::multimap<double,int> history_index;
+	// Most values held by any entry. The keys only line up for entries no longer
+	// than the gaussian being checked, so past that check_history compares them all
+	std::vector<gaussian_info>::size_type longest_entry;
+
 	int number_of_entries_last_added;
 };
 
@@ -8,6 +8,16 @@
  */
 
 #include "IO.h"
+#include "Line_Reader.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <glob.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -163,7 +173,7 @@ void update_regions_file(string output, vector<gaussian> v, vector<int> v_histor
 		{
 			if (v_history[i] != 1)
 			{
-				o.precision(8);
+				// Values are written in full, so a restart from this file finds the same ECPs in history
 				// Loop over all values and print
 				for (vector<gaussian_info>::size_type j = 0; j < v[i].values.size(); j++)
 				{
@@ -176,7 +186,7 @@ void update_regions_file(string output, vector<gaussian> v, vector<int> v_histor
 						o << " ";
 					}
 
-					o << "\t|\t" << setw(10) << v[i].values[j].line_number << "\t\t" << v[i].values[j].type << "\t\t" << v[i].values[j].value << endl;
+					o << "\t|\t" << setw(10) << v[i].values[j].line_number << "\t\t" << v[i].values[j].type << "\t\t" << NumberToString(v[i].values[j].value,round_trip_precision) << endl;
 				}
 				// Separate from other values
 				o << spacer << endl;
@@ -206,37 +216,148 @@ void update_regions_file(string output, vector<gaussian> v, vector<int> v_histor
   */
 vector<string> read_in_lines(string input, bool critical)
 {
-	ifstream inData;
 	vector<string> outData;
-	// Open file
-	inData.open( input.c_str() );
-	if (inData) 
+	// The file is mapped, so each line is copied out only once
+	Line_Reader inData(input, critical);
+	line_view line;
+	// Get all lines
+	while (inData.next(&line))
 	{
-		string buffer = "";
-		// Get all lines
-		while (getline(inData,buffer))
-		{
-			outData.push_back(buffer);
-		}
+		outData.push_back(view_to_string(line));
 	}
-	else
-	{
-		// Else throw error
-		string error = "Could not find file: " + input;
-		cout << error << endl;
-		if (critical)
-		{
-			cout << "Critical Error" << endl;
-			exit(EXIT_FAILURE);
-		}
-	}
-	inData.close();	
 	
 	return outData;
 }
 
 /*
- Generic function to read in a BINARY file and return it in a vector<string>
+ Take the raw bytes of a value from a buffer, if there are enough left
+
+ @param[in/out] p Position in the buffer, moved on past the value
+ @param[in] end End of the buffer
+ @param[out] v Value
+ @return bool False if the buffer ran out
+ */
+template<class T>
+static bool unpack(const char *&p, const char *end, T &v)
+{
+	if ((size_t) (end-p) < sizeof(T))
+	{
+		return false;
+	}
+	memcpy(&v, p, sizeof(T));
+	p += sizeof(T);
+	return true;
+}
+
+/*
+ Read back the spreads of a gaussian. Labels are cut or padded to 10 characters,
+ as we cannot write a string directly to binary
+
+ @param[in/out] p Position in the buffer
+ @param[in] end End of the buffer
+ @param[out] v Spreads
+ @return bool False if the buffer ran out
+ */
+static bool unpack_spreads(const char *&p, const char *end, vector<min_max_spread> &v)
+{
+	const size_t entry_size = 4*sizeof(double) + sizeof(int) + 10;
+	size_t sz;
+
+	if (!unpack(p, end, sz) || (sz > (size_t) (end-p)/entry_size))
+	{
+		return false;
+	}
+
+	v.resize(sz);
+	for (vector<min_max_spread>::size_type sz_t = 0; sz_t < sz; sz_t++)
+	{
+		unpack(p, end, v[sz_t].max);
+		unpack(p, end, v[sz_t].min);
+		unpack(p, end, v[sz_t].average);
+		unpack(p, end, v[sz_t].spread);
+		unpack(p, end, v[sz_t].quantity);
+		// Labels are only null terminated if shorter than 10 characters
+		v[sz_t].label.assign(p, strnlen(p, 10));
+		p += 10;
+	}
+	return true;
+}
+
+/*
+ Read back a vector of plain structures written with their size in front
+
+ @param[in/out] p Position in the buffer
+ @param[in] end End of the buffer
+ @param[out] v Contents
+ @return bool False if the buffer ran out
+ */
+template<class T>
+static bool unpack_vector(const char *&p, const char *end, vector<T> &v)
+{
+	size_t sz;
+
+	if (!unpack(p, end, sz) || (sz > (size_t) (end-p)/sizeof(T)))
+	{
+		return false;
+	}
+
+	v.resize(sz);
+	if (sz > 0)
+	{
+		memcpy(&v[0], p, sz*sizeof(T));
+		p += sz*sizeof(T);
+	}
+	return true;
+}
+
+/*
+ Read one gaussian back from a buffer, in the layout of the old restart files
+
+ @param[in/out] p Position in the buffer
+ @param[in] end End of the buffer
+ @param[out] g Gaussian
+ @return bool False if the buffer ran out part way through
+ */
+static bool unpack_gaussian(const char *&p, const char *end, gaussian &g)
+{
+	return (unpack(p, end, g.index) &&
+		unpack(p, end, g.rank) &&
+		unpack(p, end, g.HOMO_value) &&
+		unpack(p, end, g.LUMO_value) &&
+		unpack(p, end, g.function) &&
+		unpack(p, end, g.failed) &&
+		unpack_vector(p, end, g.values) &&
+		unpack_vector(p, end, g.regions) &&
+		unpack_spreads(p, end, g.orbital_spread) &&
+		unpack_spreads(p, end, g.dma_spread));
+}
+
+/*
+ Read a whole file into memory
+
+ @param[in] input Filename
+ @param[out] content Contents of the file
+ @return bool False if the file could not be read
+ */
+static bool read_in_bytes(string input, string &content)
+{
+	ifstream inData(input.c_str(), ios::in | ios::binary);
+
+	if (!inData)
+	{
+		return false;
+	}
+
+	ostringstream os;
+	os << inData.rdbuf();
+	content = os.str();
+	return true;
+}
+
+/*
+ Generic function to read in a BINARY file and return it in a vector<string>.
+ This is the old restart format, with the gaussians one after another and
+ nothing to check them against, which is still read if there is no journal.
 
  @param[in] input Filename
  @param[in] critical Flag to terminate if there is a critical problem
@@ -244,127 +365,19 @@ vector<string> read_in_lines(string input, bool critical)
   */
 vector<gaussian> read_in_binary(string input, bool critical)
 {
-        ifstream inData;
-
-        // cout << "OPENING: " << input.c_str() << endl;
-
-	inData.open(input.c_str(), ios::in | ios::binary);
-
         vector<gaussian> outData;
+	string content;
 
-        if (inData)
+        if (read_in_bytes(input, content))
         {
-	        // Temp structure;
-	        gaussian g;
-                size_t sz;
+		const char *p = content.data();
+		const char *end = p + content.size();
+		gaussian g;
 
-                while (inData.good())
+		// Anything cut short at the end is left out
+		while ((p < end) && unpack_gaussian(p, end, g))
 		{
-                        inData.read(reinterpret_cast<char*>(&g.index), sizeof(int));
-	                inData.read(reinterpret_cast<char*>(&g.rank), sizeof(int));
-                        inData.read(reinterpret_cast<char*>(&g.HOMO_value), sizeof(double));
-                        inData.read(reinterpret_cast<char*>(&g.LUMO_value), sizeof(double));
-                        inData.read(reinterpret_cast<char*>(&g.function), sizeof(double));
-                        inData.read(reinterpret_cast<char*>(&g.failed), sizeof(bool));
-
-	                inData.read(reinterpret_cast<char*>(&sz), sizeof(sz));
-	                g.values.resize(sz);
-        	        for (vector<gaussian_info>::size_type sz_t = 0; sz_t < sz; sz_t++)
-                	{
-	                        inData.read(reinterpret_cast<char*>(&g.values[sz_t]), sizeof(gaussian_info));
-                	}
-
-	                inData.read(reinterpret_cast<char*>(&sz), sizeof(sz));
-        	        g.regions.resize(sz);
-                	for (vector<regions_data>::size_type sz_t = 0; sz_t < sz; sz_t++)
-	                {
-                	        inData.read(reinterpret_cast<char*>(&g.regions[sz_t]), sizeof(regions_data));
-	                }
-
-
-        	        inData.read(reinterpret_cast<char*>(&sz), sizeof(sz));
-                	g.orbital_spread.resize(sz);
-                        // Generate character buffer for reading string 
-                        char buffer [11];
-                        // This is necessary as we cannot write a string directly to binary
-	                for (vector<min_max_spread>::size_type sz_t = 0; sz_t < sz; sz_t++)
-        	        {
-//                                inData.read(reinterpret_cast<char*>(&g.orbital_spread[sz_t]), sizeof(min_max_spread));
-                                inData.read(reinterpret_cast<char*>(&g.orbital_spread[sz_t].max), sizeof(double));
-                                inData.read(reinterpret_cast<char*>(&g.orbital_spread[sz_t].min), sizeof(double));
-                                inData.read(reinterpret_cast<char*>(&g.orbital_spread[sz_t].average), sizeof(double));
-                                inData.read(reinterpret_cast<char*>(&g.orbital_spread[sz_t].spread), sizeof(double));
-                                inData.read(reinterpret_cast<char*>(&g.orbital_spread[sz_t].quantity), sizeof(int));
-                                // Read characters
-                                inData.read(buffer, 10);
-                                // Set null point to signify end of string
-                                buffer[10] = 0;
-                                // Assign
-                                g.orbital_spread[sz_t].label = buffer;
-        	        }
-	
-        	        inData.read(reinterpret_cast<char*>(&sz), sizeof(sz));
-                	g.dma_spread.resize(sz);
-                        // Generate character buffer for reading string
-                        char buffer2 [11];
-                        // This is necessary as we cannot write a string directly to binary
-	                for (vector<min_max_spread>::size_type sz_t = 0; sz_t < sz; sz_t++)
-        	        {
-//                                inData.read(reinterpret_cast<char*>(&g.dma_spread[sz_t]), sizeof(min_max_spread));
-                                inData.read(reinterpret_cast<char*>(&g.dma_spread[sz_t].max), sizeof(double));
-                                inData.read(reinterpret_cast<char*>(&g.dma_spread[sz_t].min), sizeof(double));
-                                inData.read(reinterpret_cast<char*>(&g.dma_spread[sz_t].average), sizeof(double));
-                                inData.read(reinterpret_cast<char*>(&g.dma_spread[sz_t].spread), sizeof(double));
-                                inData.read(reinterpret_cast<char*>(&g.dma_spread[sz_t].quantity), sizeof(int));
-                                // Read characters
-                                inData.read(buffer2, 10);
-                                // Set null point to signify end of string
-                                buffer2[10] = 0;
-                                // Assign
-                                g.dma_spread[sz_t].label = buffer2;
-        	        }
-
-			// Horrible segfaults from trying to put the Gaussian straight into the vector.
-			// i.e. outData.push_pack(g);
-			// Trying to do it manually now... 
-
-                        // cout << "READ ONE ENTRY" << endl;
-		
-			if (!inData.eof())
-			{
-                                // cout << "RESIZING OUTDATA. OLD SIZE:" << outData.size();
-	                        outData.resize(outData.size()+1);
-                                // cout << "; NEW SIZE: " << outData.size() << endl;
-                                // cout << "ADDING INDEX: " << g.index << endl;
-				outData[outData.size()-1].index = g.index;
-                                // cout << "ADDING RANK: " << g.rank << endl;
-                	        outData[outData.size()-1].rank = g.rank;
-                                // cout << "ADDING HOMO: " << g.HOMO_value << endl;
-                        	outData[outData.size()-1].HOMO_value = g.HOMO_value;
-                                // cout << "ADDING LUMO: " << g.LUMO_value << endl;
-	                        outData[outData.size()-1].LUMO_value = g.LUMO_value;
-                                // cout << "ADDING FUNCTION: " << g.function << endl;
-        	                outData[outData.size()-1].function = g.function;
-                                // cout << "ADDING FAILED: " << g.failed << endl;
-                	        outData[outData.size()-1].failed = g.failed;
-                                // cout << "ADDING VALUES: " << g.values.size() << endl;
-                        	outData[outData.size()-1].values = g.values;
-                                // cout << "ADDING REGIONS: " << g.regions.size() << endl;
-	                        outData[outData.size()-1].regions = g.regions;
-                                // cout << "ADDING ORBITAL SPREAD: " << g.orbital_spread.size() << endl;
-                                // cout << "ORBITAL SPREAD VALUES: " << endl;
-                                // cout << "MAX: " << g.orbital_spread[0].max << endl;
-                                // cout << "MIN: " << g.orbital_spread[0].min << endl;
-                                // cout << "AVERAGE: " << g.orbital_spread[0].average << endl;
-                                // cout << "SPREAD: " << g.orbital_spread[0].spread << endl;
-                                // cout << "QUANTITY: " << g.orbital_spread[0].quantity << endl;
-                                // cout << "LABEL: " << g.orbital_spread[0].label << endl; 
-        	                outData[outData.size()-1].orbital_spread = g.orbital_spread;
-                                // cout << "ADDING DMA SPREAD: " << g.dma_spread.size() << endl;
-                	        outData[outData.size()-1].dma_spread = g.dma_spread;
-			}
-                        
-                        // cout << "ASSIGNED ONE ENTRY" << endl;
+			outData.push_back(g);
 		}
         }
         else
@@ -379,11 +392,636 @@ vector<gaussian> read_in_binary(string input, bool critical)
                 }
         }
 
-        inData.close();
-
         return outData;
 }
 
+/*
+ Checksum for journal records (32 bit FNV-1a)
+
+ @param[in] p Start of the data
+ @param[in] n Length of the data
+ @return unsigned int Checksum
+ */
+static unsigned int journal_checksum(const char *p, size_t n)
+{
+	unsigned int h = 2166136261u;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		h ^= (unsigned char) p[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/*
+ The restart journal. Version 1 wrote each gaussian in the layout of the
+ machine it ran on. Version 2 is portable, with every number little endian
+ and of fixed width, and every record the same length, so the file can be
+ mapped and records found by position. Numbers are put together a byte at a
+ time, so the file reads the same on any machine and needs no byte order marker.
+
+ Header (little endian):
+   char magic[8]   "FMEJOUR2"
+   uint32 version  2
+   uint32 shape[4] Most values, regions, orbital spreads and DMA spreads any record holds
+   uint32 stride   Length of each record
+   uint32 check    Checksum of the header up to here
+
+ Each record is a uint32 checksum of the rest of the record, then
+   int32 index, int32 rank, float64 HOMO, LUMO and function, uint8 failed,
+   3 bytes padding, uint32 counts[4] of what this record actually holds,
+   then each section padded out to the shape in the header:
+   values         int32 line_number, int32 type, float64 value
+   regions        float64 gnorm, gnorm_max, gradx_max, grady_max, gradz_max
+   spreads (x2)   float64 max, min, average, spread, int32 quantity, char label[12]
+ */
+static const char journal_magic_v1[8] = {'F','M','E','J','O','U','R','1'};
+static const char journal_magic[8] = {'F','M','E','J','O','U','R','2'};
+static const unsigned int journal_version = 2;
+static const size_t journal_header_size = 36;
+static const size_t journal_fixed_size = 4 + 4 + 4 + 3*8 + 1 + 3 + 4*4;
+static const size_t journal_value_size = 4 + 4 + 8;
+static const size_t journal_region_size = 5*8;
+static const size_t journal_spread_size = 4*8 + 4 + 12;
+
+/*
+ Number of each kind of entry a journal record has room for
+ */
+struct journal_shape
+{
+	unsigned int values;
+	unsigned int regions;
+	unsigned int orbital_spread;
+	unsigned int dma_spread;
+};
+
+/*
+ Length of a record for a given shape, including its checksum
+
+ @param[in] shape Room in each record
+ @return size_t Record length
+ */
+static size_t journal_stride(const journal_shape &shape)
+{
+	return 4 + journal_fixed_size
+		 + shape.values*journal_value_size
+		 + shape.regions*journal_region_size
+		 + (shape.orbital_spread + shape.dma_spread)*journal_spread_size;
+}
+
+/*
+ Write fixed width little endian numbers into a buffer, whatever the machine
+
+ @param[in/out] p Position in the buffer, moved on past the value
+ @param[in] v Value
+ */
+static void put_u32(unsigned char *&p, unsigned int v)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		*p++ = (unsigned char) (v >> (8*i));
+	}
+}
+
+static void put_f64(unsigned char *&p, double d)
+{
+	unsigned long long v;
+	memcpy(&v, &d, sizeof(v));
+	for (int i = 0; i < 8; i++)
+	{
+		*p++ = (unsigned char) (v >> (8*i));
+	}
+}
+
+/*
+ Read fixed width little endian numbers back
+
+ @param[in/out] p Position in the buffer, moved on past the value
+ @return Value
+ */
+static unsigned int get_u32(const unsigned char *&p)
+{
+	unsigned int v = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		v |= ((unsigned int) *p++) << (8*i);
+	}
+	return v;
+}
+
+static double get_f64(const unsigned char *&p)
+{
+	unsigned long long v = 0;
+	for (int i = 0; i < 8; i++)
+	{
+		v |= ((unsigned long long) *p++) << (8*i);
+	}
+	double d;
+	memcpy(&d, &v, sizeof(d));
+	return d;
+}
+
+/*
+ Spreads padded out to their place in the record
+
+ @param[in/out] p Position in the record
+ @param[in] v Spreads
+ @param[in] room Number the record has room for
+ */
+static void put_spreads(unsigned char *&p, const vector<min_max_spread> &v, unsigned int room)
+{
+	for (vector<min_max_spread>::size_type i = 0; i < v.size(); i++)
+	{
+		put_f64(p, v[i].max);
+		put_f64(p, v[i].min);
+		put_f64(p, v[i].average);
+		put_f64(p, v[i].spread);
+		put_u32(p, v[i].quantity);
+		memset(p, 0, 12);
+		v[i].label.copy((char *) p, 10);
+		p += 12;
+	}
+	p += (room - v.size())*journal_spread_size;
+}
+
+static void get_spreads(const unsigned char *&p, vector<min_max_spread> &v, unsigned int count, unsigned int room)
+{
+	v.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		v[i].max = get_f64(p);
+		v[i].min = get_f64(p);
+		v[i].average = get_f64(p);
+		v[i].spread = get_f64(p);
+		v[i].quantity = (int) get_u32(p);
+		v[i].label.assign((const char *) p, strnlen((const char *) p, 10));
+		p += 12;
+	}
+	p += (room - count)*journal_spread_size;
+}
+
+/*
+ Write one gaussian as a journal record. Unused room is left as zeros.
+
+ @param[out] record Start of the record, journal_stride(shape) long
+ @param[in] g Gaussian
+ @param[in] shape Room in each record
+ */
+static void put_journal_record(unsigned char *record, const gaussian &g, const journal_shape &shape)
+{
+	unsigned char *p = record + 4;
+
+	memset(record, 0, journal_stride(shape));
+
+	put_u32(p, g.index);
+	put_u32(p, g.rank);
+	put_f64(p, g.HOMO_value);
+	put_f64(p, g.LUMO_value);
+	put_f64(p, g.function);
+	*p = g.failed ? 1 : 0;
+	p += 4;
+	put_u32(p, g.values.size());
+	put_u32(p, g.regions.size());
+	put_u32(p, g.orbital_spread.size());
+	put_u32(p, g.dma_spread.size());
+
+	for (vector<gaussian_info>::size_type i = 0; i < g.values.size(); i++)
+	{
+		put_u32(p, g.values[i].line_number);
+		put_u32(p, g.values[i].type);
+		put_f64(p, g.values[i].value);
+	}
+	p += (shape.values - g.values.size())*journal_value_size;
+
+	for (vector<regions_data>::size_type i = 0; i < g.regions.size(); i++)
+	{
+		put_f64(p, g.regions[i].gnorm);
+		put_f64(p, g.regions[i].gnorm_max);
+		put_f64(p, g.regions[i].gradx_max);
+		put_f64(p, g.regions[i].grady_max);
+		put_f64(p, g.regions[i].gradz_max);
+	}
+	p += (shape.regions - g.regions.size())*journal_region_size;
+
+	put_spreads(p, g.orbital_spread, shape.orbital_spread);
+	put_spreads(p, g.dma_spread, shape.dma_spread);
+
+	p = record;
+	put_u32(p, journal_checksum((const char *) record + 4, journal_stride(shape) - 4));
+}
+
+/*
+ Read one gaussian back from a journal record
+
+ @param[in] record Start of the record
+ @param[in] shape Room in each record
+ @param[out] g Gaussian
+ @return bool False if the record is damaged
+ */
+static bool get_journal_record(const unsigned char *record, const journal_shape &shape, gaussian &g)
+{
+	const unsigned char *p = record;
+	size_t stride = journal_stride(shape);
+
+	if (get_u32(p) != journal_checksum((const char *) record + 4, stride - 4))
+	{
+		return false;
+	}
+
+	g.index = (int) get_u32(p);
+	g.rank = (int) get_u32(p);
+	g.HOMO_value = get_f64(p);
+	g.LUMO_value = get_f64(p);
+	g.function = get_f64(p);
+	g.failed = (*p != 0);
+	p += 4;
+
+	unsigned int values = get_u32(p);
+	unsigned int regions = get_u32(p);
+	unsigned int orbital_spread = get_u32(p);
+	unsigned int dma_spread = get_u32(p);
+
+	if ((values > shape.values) || (regions > shape.regions) ||
+	    (orbital_spread > shape.orbital_spread) || (dma_spread > shape.dma_spread))
+	{
+		return false;
+	}
+
+	g.values.resize(values);
+	for (unsigned int i = 0; i < values; i++)
+	{
+		g.values[i].line_number = (int) get_u32(p);
+		g.values[i].type = (int) get_u32(p);
+		g.values[i].value = get_f64(p);
+	}
+	p += (shape.values - values)*journal_value_size;
+
+	g.regions.resize(regions);
+	for (unsigned int i = 0; i < regions; i++)
+	{
+		g.regions[i].gnorm = get_f64(p);
+		g.regions[i].gnorm_max = get_f64(p);
+		g.regions[i].gradx_max = get_f64(p);
+		g.regions[i].grady_max = get_f64(p);
+		g.regions[i].gradz_max = get_f64(p);
+	}
+	p += (shape.regions - regions)*journal_region_size;
+
+	get_spreads(p, g.orbital_spread, orbital_spread, shape.orbital_spread);
+	get_spreads(p, g.dma_spread, dma_spread, shape.dma_spread);
+
+	return true;
+}
+
+/*
+ Write the journal header
+
+ @param[out] header journal_header_size bytes
+ @param[in] shape Room in each record
+ */
+static void put_journal_header(unsigned char *header, const journal_shape &shape)
+{
+	unsigned char *p = header;
+
+	memcpy(p, journal_magic, sizeof(journal_magic));
+	p += sizeof(journal_magic);
+	put_u32(p, journal_version);
+	put_u32(p, shape.values);
+	put_u32(p, shape.regions);
+	put_u32(p, shape.orbital_spread);
+	put_u32(p, shape.dma_spread);
+	put_u32(p, journal_stride(shape));
+	put_u32(p, journal_checksum((const char *) header, p - header));
+}
+
+/*
+ Check the journal header and read the record shape from it
+
+ @param[in] header Start of the file
+ @param[in] size Length of the file
+ @param[out] shape Room in each record
+ @return bool False if this isn't a journal we can read
+ */
+static bool get_journal_header(const unsigned char *header, size_t size, journal_shape &shape)
+{
+	if ((size < journal_header_size) || (memcmp(header, journal_magic, sizeof(journal_magic)) != 0))
+	{
+		return false;
+	}
+
+	const unsigned char *p = header + sizeof(journal_magic);
+
+	if (get_u32(p) != journal_version)
+	{
+		cout << "Restart journal is from an unknown version" << endl;
+		return false;
+	}
+
+	shape.values = get_u32(p);
+	shape.regions = get_u32(p);
+	shape.orbital_spread = get_u32(p);
+	shape.dma_spread = get_u32(p);
+	unsigned int stride = get_u32(p);
+	unsigned int check = journal_checksum((const char *) header, p - header);
+
+	return ((get_u32(p) == check) && (stride == journal_stride(shape)));
+}
+
+/*
+ Read in a version 1 journal, with variable length records in the
+ layout of the machine that wrote them
+
+ @param[in] input Filename, for messages
+ @param[in] content Contents of the file
+ @return Vector of Gaussians with contents of the journal
+ */
+static vector<gaussian> read_in_journal_v1(string input, const string &content)
+{
+	vector<gaussian> outData;
+	const char *p = content.data() + sizeof(journal_magic_v1);
+	const char *end = content.data() + content.size();
+
+	while (p < end)
+	{
+		const char *record = p;
+		unsigned int length;
+		unsigned int checksum;
+		gaussian g;
+
+		if (!unpack(p, end, length) ||
+		    !unpack(p, end, checksum) ||
+		    ((size_t) (end-p) < length) ||
+		    (journal_checksum(p, length) != checksum))
+		{
+			cout << "Ignoring " << (end-record) << " damaged bytes at the end of " << input << endl;
+			break;
+		}
+
+		const char *payload_end = p + length;
+
+		if (!unpack_gaussian(p, payload_end, g))
+		{
+			cout << "Ignoring " << (end-record) << " damaged bytes at the end of " << input << endl;
+			break;
+		}
+
+		outData.push_back(g);
+		p = payload_end;
+	}
+
+	return outData;
+}
+
+/*
+ Read in the restart journal. The file is mapped and every fixed length record
+ is decoded straight away into a gaussian, as the history keeps its own copies,
+ so the mapping is let go before returning. Records are all the same length,
+ so a damaged one is skipped and reading carries on with the next. If a write
+ was cut short the good records are kept, and anything damaged is dropped the
+ next time the journal is written.
+ Version 1 journals and files in the old binary format are read as they were.
+
+ @param[in] input Filename
+ @param[in] critical Flag to terminate if there is a critical problem
+ @return Vector of Gaussians with contents of the journal
+ */
+vector<gaussian> read_in_journal(string input, bool critical)
+{
+	vector<gaussian> outData;
+	int fd = open(input.c_str(), O_RDONLY);
+	struct stat st;
+
+	if ((fd < 0) || (fstat(fd, &st) != 0) || (st.st_size == 0))
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return read_in_binary(input, critical);
+	}
+
+	size_t size = st.st_size;
+	void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (mapped == MAP_FAILED)
+	{
+		return read_in_binary(input, critical);
+	}
+
+	const unsigned char *data = (const unsigned char *) mapped;
+	journal_shape shape;
+
+	if (get_journal_header(data, size, shape))
+	{
+		size_t stride = journal_stride(shape);
+		size_t records = (size - journal_header_size)/stride;
+		size_t good = 0;
+		size_t tail = size - journal_header_size - records*stride;
+		
+		outData.resize(records);
+		madvise(mapped, size, MADV_SEQUENTIAL);
+
+		for (size_t i = 0; i < records; i++)
+		{
+			if (get_journal_record(data + journal_header_size + i*stride, shape, outData[good]))
+			{
+				good++;
+			}
+		}
+		outData.resize(good);
+
+		if (good != records)
+		{
+			cout << "Skipping " << (records - good) << " damaged records in " << input << endl;
+		}
+		if (tail != 0)
+		{
+			cout << "Ignoring " << tail << " damaged bytes at the end of " << input << endl;
+		}
+	}
+	else if ((size >= sizeof(journal_magic_v1)) && (memcmp(data, journal_magic_v1, sizeof(journal_magic_v1)) == 0))
+	{
+		outData = read_in_journal_v1(input, string((const char *) data, size));
+	}
+	else
+	{
+		outData = read_in_binary(input, critical);
+	}
+
+	munmap(mapped, size);
+
+	return outData;
+}
+
+/*
+ Work out the room each record needs to hold all the gaussians given
+
+ @param[in] content Gaussians
+ @param[in/out] shape Grown where needed
+ */
+static void fit_journal_shape(const vector<gaussian> &content, journal_shape &shape)
+{
+	for (vector<gaussian>::size_type a = 0; a < content.size(); a++)
+	{
+		shape.values = max(shape.values, (unsigned int) content[a].values.size());
+		shape.regions = max(shape.regions, (unsigned int) content[a].regions.size());
+		shape.orbital_spread = max(shape.orbital_spread, (unsigned int) content[a].orbital_spread.size());
+		shape.dma_spread = max(shape.dma_spread, (unsigned int) content[a].dma_spread.size());
+	}
+}
+
+/*
+ Write out bytes and make sure they reach the disk before returning
+
+ @param[in] fd Open file
+ @param[in] data Bytes to write
+ @param[in] size Number of bytes
+ @return bool True if everything was written
+ */
+static bool write_and_sync(int fd, const unsigned char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t n = write(fd, data, size);
+
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+		data += n;
+		size -= n;
+	}
+
+	return (fsync(fd) == 0);
+}
+
+/*
+ Add new gaussians to the end of the restart journal, leaving the records
+ already there untouched. Any damaged tail from an earlier write is cut off first.
+ This can't be done if there is no version 2 journal yet, or the new gaussians
+ need more room than its records have, and then the whole history must be
+ written with write_out_journal instead.
+
+ @param[in] output Filename
+ @param[in] content New gaussians only
+ @param[in] critical Error flag if there is a problem
+ @return bool True if the gaussians were added
+ */
+bool append_to_journal(string output, vector<gaussian> content, bool critical)
+{
+	int fd = open(output.c_str(), O_RDWR);
+	struct stat st;
+	unsigned char header[journal_header_size];
+	journal_shape shape;
+
+	if ((fd < 0) || (fstat(fd, &st) != 0) ||
+	    (pread(fd, header, journal_header_size, 0) != (ssize_t) journal_header_size) ||
+	    !get_journal_header(header, st.st_size, shape))
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return false;
+	}
+
+	journal_shape needed = shape;
+	fit_journal_shape(content, needed);
+
+	if (journal_stride(needed) != journal_stride(shape))
+	{
+		close(fd);
+		return false;
+	}
+
+	size_t stride = journal_stride(shape);
+	// Start after the last whole record
+	off_t end = journal_header_size + ((st.st_size - journal_header_size)/stride)*stride;
+	vector<unsigned char> out(content.size()*stride);
+
+	for (vector<gaussian>::size_type a = 0; a < content.size(); a++)
+	{
+		put_journal_record(&out[a*stride], content[a], shape);
+	}
+
+	bool written = ((ftruncate(fd, end) == 0) &&
+			(lseek(fd, end, SEEK_SET) == end) &&
+			write_and_sync(fd, out.data(), out.size()));
+	close(fd);
+
+	if (!written)
+	{
+                // Else throw error
+                string error = "Could not write output file: " + output;
+                cout << error << endl;
+                if (critical)
+                {
+                        cout << "Critical Error" << endl;
+                        exit(EXIT_FAILURE);
+                }
+	}
+
+	return written;
+}
+
+/*
+ Compact the restart journal, rewriting it with just the gaussians given.
+ The new journal is written alongside and renamed over the old one, so
+ there is always a complete copy on disk.
+
+ @param[in] output Filename
+ @param[in] content All gaussians in the history
+ @param[in] critical Error flag if there is a problem
+ */
+void write_out_journal(string output, vector<gaussian> content, bool critical)
+{
+	journal_shape shape = {0, 0, 0, 0};
+	fit_journal_shape(content, shape);
+
+	size_t stride = journal_stride(shape);
+	vector<unsigned char> out(journal_header_size + content.size()*stride);
+
+	put_journal_header(&out[0], shape);
+	for (vector<gaussian>::size_type a = 0; a < content.size(); a++)
+	{
+		put_journal_record(&out[journal_header_size + a*stride], content[a], shape);
+	}
+
+	string temp = output + ".tmp";
+	int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	bool written = false;
+
+	if (fd >= 0)
+	{
+		written = write_and_sync(fd, out.data(), out.size());
+		close(fd);
+
+		written = written && (rename(temp.c_str(), output.c_str()) == 0);
+
+		if (!written)
+		{
+			remove(temp.c_str());
+		}
+	}
+
+	if (!written)
+	{
+                // Else throw error
+                string error = "Could not write output file: " + output;
+                cout << error << endl;
+                if (critical)
+                {
+                        cout << "Critical Error" << endl;
+                        exit(EXIT_FAILURE);
+                }
+	}
+}
 
 /*
  Generic function take a vector and write it to file AS TEXT.
@@ -424,94 +1062,100 @@ void write_out_lines(string output, vector<string> *content, bool critical)
 }
 
 /*
- Generic function take a vector of Gaussians and write it to file AS BINARY.
+ Copy one file byte for byte
 
- @param[in] output Filename
- @param[in] content Pointer to Vector containing output data (Can't remember why I used a pointer?)
+ @param[in] input Filename to copy from
+ @param[in] output Filename to copy to
+ @return bool True if the copy was made
+ */
+static bool copy_file(string input, string output)
+{
+	ifstream inData(input.c_str(), ios::in | ios::binary);
+	ofstream outData(output.c_str(), ios::out | ios::binary | ios::trunc);
+
+	if (!inData || !outData)
+	{
+		return false;
+	}
+
+	outData << inData.rdbuf();
+
+	return outData.good();
+}
+
+/*
+ Copy or move all files matching the given patterns from one folder into another.
+ This is done directly, rather than through the shell with cp and mv.
+ Patterns that match nothing are skipped silently, as the shell would.
+
+ @param[in] source Folder to take files from
+ @param[in] destination Folder to put files in. Created if needed
+ @param[in] patterns Filenames or wildcard patterns, relative to the source folder unless absolute
+ @param[in] move True to move the files, false to copy them
  @param[in] critical Error flag if there is a problem
  */
-void write_out_binary(string output, vector<gaussian> content, bool critical)
+void archive_files(string source, string destination, vector<string> patterns, bool move, bool critical)
 {
-        ofstream outData;
-	outData.open(output.c_str(), ios::out | ios::binary);
+	if ((mkdir(destination.c_str(),0755) != 0) && (errno != EEXIST))
+	{
+		cout << "Could not create folder: " << destination << endl;
+		if (critical)
+		{
+			cout << "Critical Error" << endl;
+			exit(EXIT_FAILURE);
+		}
+		return;
+	}
 
-        if (outData)
-        {
-                // Output all the data
-                for (vector<gaussian>::size_type a = 0; a < content.size(); a++)
-                {
-                        outData.write(reinterpret_cast<char*>(&content[a].index), sizeof(int));
-                        outData.write(reinterpret_cast<char*>(&content[a].rank), sizeof(int));
-                        outData.write(reinterpret_cast<char*>(&content[a].HOMO_value), sizeof(double));
-                        outData.write(reinterpret_cast<char*>(&content[a].LUMO_value), sizeof(double));
-                        outData.write(reinterpret_cast<char*>(&content[a].function), sizeof(double));
-                        outData.write(reinterpret_cast<char*>(&content[a].failed), sizeof(bool));
-
-                        size_t sz = content.at(a).values.size();
-			outData.write(reinterpret_cast<char*>(&sz), sizeof(sz));
-			// Write contents of values
-			for (vector<gaussian_info>::size_type sz_t = 0; sz_t < sz; sz_t++)
-			{
-				outData.write(reinterpret_cast<char*>(&content[a].values[sz_t]), sizeof(gaussian_info));
-			}
+	for (vector<string>::size_type i = 0; i < patterns.size(); i++)
+	{
+		string pattern = patterns[i];
 
-                        sz =  content.at(a).regions.size(); 
-			outData.write(reinterpret_cast<char*>(&sz), sizeof(sz));
-                        // Write contents of regions
-                        for (vector<regions_data>::size_type sz_t = 0; sz_t < sz; sz_t++)
-                        {
-                                outData.write(reinterpret_cast<char*>(&content[a].regions[sz_t]), sizeof(regions_data));
-                        }
+		if ((source.size() > 0) && (pattern.size() > 0) && (pattern[0] != '/'))
+		{
+			pattern = source + "/" + pattern;
+		}
 
-			sz =  content.at(a).orbital_spread.size();
-			outData.write(reinterpret_cast<char*>(&sz), sizeof(sz));
-                        // Can we write this all at once? The answer is no due to the string 
-                        // Write contents of orbital_spread
-                        for (vector<min_max_spread>::size_type sz_t = 0; sz_t < sz; sz_t++)
-                        {
-//                                outData.write(reinterpret_cast<char*>(&content[a].orbital_spread[sz_t]), sizeof(min_max_spread));
-                                  outData.write(reinterpret_cast<char*>(&content[a].orbital_spread[sz_t].max), sizeof(double));
-                                  outData.write(reinterpret_cast<char*>(&content[a].orbital_spread[sz_t].min), sizeof(double));
-                                  outData.write(reinterpret_cast<char*>(&content[a].orbital_spread[sz_t].average), sizeof(double));
-                                  outData.write(reinterpret_cast<char*>(&content[a].orbital_spread[sz_t].spread), sizeof(double));
-                                  outData.write(reinterpret_cast<char*>(&content[a].orbital_spread[sz_t].quantity), sizeof(int));
-//                                  outData << &content[a].orbital_spread[sz_t].label << std::endl;
-//                                  cout << content[a].orbital_spread[sz_t].label.c_str() << endl;
-                                  outData.write(content[a].orbital_spread[sz_t].label.c_str(), 10);
-                        }
+		glob_t matches;
 
-			sz =  content.at(a).dma_spread.size();
-			outData.write(reinterpret_cast<char*>(&sz), sizeof(sz));
-                        // Write contents of dma_spread
-                        for (vector<min_max_spread>::size_type sz_t = 0; sz_t < sz; sz_t++)
-                        {
-//                                outData.write(reinterpret_cast<char*>(&content[a].dma_spread[sz_t]), sizeof(min_max_spread));
-                                  outData.write(reinterpret_cast<char*>(&content[a].dma_spread[sz_t].max), sizeof(double));
-                                  outData.write(reinterpret_cast<char*>(&content[a].dma_spread[sz_t].min), sizeof(double));
-                                  outData.write(reinterpret_cast<char*>(&content[a].dma_spread[sz_t].average), sizeof(double));
-                                  outData.write(reinterpret_cast<char*>(&content[a].dma_spread[sz_t].spread), sizeof(double));
-                                  outData.write(reinterpret_cast<char*>(&content[a].dma_spread[sz_t].quantity), sizeof(int));
-//                                  outData << &content[a].dma_spread[sz_t].label << std::endl;
-//                                  cout << content[a].orbital_spread[sz_t].label.c_str() << endl;
-                                  outData.write(content[a].dma_spread[sz_t].label.c_str(), 10);
-                        } 
-
-			// Write all data
-                        //outData.write(reinterpret_cast<char*>(&content.at(a)), sizeof(gaussian));
-                }
-        }
-        else
-        {
-                // Else throw error
-                string error = "Could not open output file: " + output;
-                cout << error << endl;
-                if (critical)
-                {
-                        cout << "Critical Error" << endl;
-                        exit(EXIT_FAILURE);
-                }
-        }
+		if (glob(pattern.c_str(),0,NULL,&matches) != 0)
+		{
+			globfree(&matches);
+			continue;
+		}
 
-        outData.close();
-}
+		for (size_t j = 0; j < matches.gl_pathc; j++)
+		{
+			string input = matches.gl_pathv[j];
+			string output = destination + "/" + input.substr(input.find_last_of('/') + 1);
+			bool ok = false;
+
+			if (move)
+			{
+				ok = (rename(input.c_str(),output.c_str()) == 0);
+
+				// Different file systems, so fall back to copy and delete
+				if (!ok && (errno == EXDEV) && copy_file(input,output))
+				{
+					ok = (remove(input.c_str()) == 0);
+				}
+			}
+			else
+			{
+				ok = copy_file(input,output);
+			}
+
+			if (!ok)
+			{
+				cout << "Could not archive " << input << " to " << destination << endl;
+				if (critical)
+				{
+					cout << "Critical Error" << endl;
+					exit(EXIT_FAILURE);
+				}
+			}
+		}
 
+		globfree(&matches);
+	}
+}
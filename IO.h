@@ -28,7 +28,12 @@ void update_regions_file(std::string output, std::vector<gaussian> v, std::vecto
 // Generic function read in a file and return it in a vector
 std::vector<std::string> read_in_lines(std::string input, bool critical = true);
 std::vector<gaussian> read_in_binary(std::string input, bool critical = true);
+// Restart journal: read it back, add new entries on the end, or rewrite it compacted
+std::vector<gaussian> read_in_journal(std::string input, bool critical = true);
+bool append_to_journal(std::string output, std::vector<gaussian> content, bool critical = true);
+void write_out_journal(std::string output, std::vector<gaussian> content, bool critical = true);
 // Generic function take a vector and write it to file
 void write_out_lines(std::string output, std::vector<std::string> *content, bool critical = true);
-void write_out_binary(std::string output, std::vector<gaussian> content, bool critical = true);
+// Copy or move all files matching the given patterns from one folder into another
+void archive_files(std::string source, std::string destination, std::vector<std::string> patterns, bool move, bool critical = false);
 #endif
@@ -0,0 +1,257 @@
+/*
+ *  @file Islands.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include "Islands.h"
+
+using namespace std;
+
+/*
+ Constructor
+
+ @param[in/out] seed Pointer to random number seed
+ @param[in] n Number of islands
+ @param[in] mi Generations between migrations
+ */
+Islands::Islands(int *seed, int n, int mi) : Outputs(seed)
+{
+	islands.assign(n > 1 ? n : 1,Genetic(seed));
+	batch_sizes.assign(islands.size(),0);
+	seeds.assign(islands.size(),0);
+	streams.resize(islands.size());
+	use_own_streams();
+	migration_interval = mi;
+
+	if (migration_interval <= 0)
+	{
+		migration_interval = 5;
+		cout << "Using default generations between migrations for GA islands : " << migration_interval << endl;
+	}
+}
+
+/*
+ Set the initial parameters for every island
+
+ @param[in] ss The step size to be initially used for A and zeta
+ @param[in] sr Step reduction rate for A and zeta
+ @param[in] ssm Convergence criteria, defined as the target step size to reach, for A and zeta
+ @param[in] min Minimum values for A and zeta
+ @param[in] max Maximum values for A and zeta
+ @param[in] msod Maximum steps in any one direction - by default this is disabled
+ */
+void Islands::set_parameters(vector< vector<double> > ss,
+			     vector< vector<double> > sr,
+			     vector< vector<double> > ssm,
+			     vector<double> min,
+			     vector<double> max,
+			     int msod)
+{
+	// Set up one island and copy it, so any defaults are only reported once
+	islands[0].set_parameters(ss,sr,ssm,min,max,msod);
+	const Genetic configured = islands[0];
+	islands.assign(islands.size(),configured);
+	use_own_streams();
+}
+
+/*
+ Method to set the GA parameters of every island.
+ Migration happens between generations, so the islands are always generational
+
+ @param[in] ps The size of the GA population on each island
+ @param[in] ms The size of the mutant population on each island
+ @param[in] os The size of the offspring population on each island
+ @param[in] cc Convergence criteria to terminate a GA search
+ @param[in] md Check for dynamic mutation
+ @param[in] as Replace population members as each ECP finishes (not used)
+ */
+void Islands::set_ga_parameters(int ps,
+				int ms,
+				int os,
+				int cc,
+				bool md,
+				bool as)
+{
+	if (as)
+	{
+		cout << "GA islands migrate between generations. Ignoring --ga_asynchronous" << endl;
+	}
+
+	islands[0].set_ga_parameters(ps,ms,os,cc,md,false);
+	const Genetic configured = islands[0];
+	islands.assign(islands.size(),configured);
+	use_own_streams();
+}
+
+/*
+ Method to set the size of batches on every island
+
+ @param[in] bs Number of ECPs handed out in each batch
+ @param[in] ts Total number of ECPs to sample
+ */
+void Islands::set_sample_parameters(int bs, int ts)
+{
+	islands[0].set_sample_parameters(bs,ts);
+	const Genetic configured = islands[0];
+	islands.assign(islands.size(),configured);
+	use_own_streams();
+}
+
+/*
+ Point every island at its own stream of random numbers. Copying island 0 over
+ the others takes their streams with it, so this is done again after each copy
+
+ No param
+ */
+void Islands::use_own_streams()
+{
+	for (vector<Genetic>::size_type i = 0; i < islands.size(); i++)
+	{
+		islands[i].set_random_stream(&seeds[i],&streams[i]);
+	}
+}
+
+/*
+ Defines initial ECPs, and gives each island its own random population.
+ Each island's stream is started from a seed taken in turn from the search's own,
+ so island i always gets the i-th seed however many islands there are
+
+ @param[in] v Vector of initial gaussian(s) read in from ecp.template
+ */
+void Islands::set_starting_gaussians(gaussian v)
+{
+	starting_gaussians = v;
+
+	for (vector<int>::size_type i = 0; i < seeds.size(); i++)
+	{
+		// Negative restarts the stream. The generator needs seeds below 161803398
+		seeds[i] = -1 - randomNumber(100000000,idum);
+		streams[i].seeded = false;
+	}
+
+	for (vector<Genetic>::size_type i = 0; i < islands.size(); i++)
+	{
+		cout << "Island " << i << " :" << endl;
+		islands[i].set_starting_gaussians(v);
+	}
+}
+
+/*
+ Gather the ECPs of every island still searching into one batch
+
+ @return vector of ECPs to test
+ */
+vector<gaussian> Islands::get_ecps_to_test()
+{
+	ecps_to_test.clear();
+
+	for (vector<Genetic>::size_type i = 0; i < islands.size(); i++)
+	{
+		batch_sizes[i] = 0;
+
+		if (!islands[i].get_converged())
+		{
+			vector<gaussian> v = islands[i].get_ecps_to_test();
+			batch_sizes[i] = v.size();
+			ecps_to_test.insert(ecps_to_test.end(),v.begin(),v.end());
+		}
+	}
+
+	return ecps_to_test;
+}
+
+/*
+ Hand each island back its share of the batch, then swap migrants if it is time
+
+ @param[in] v Vector of ECPs just tested
+ @param[in] n Index of the highest ranked ECP over all islands (not used)
+ */
+void Islands::set_ecps_tested(vector<gaussian> v, int n)
+{
+	vector<gaussian>::size_type first = 0;
+	bool searching = false;
+
+	for (vector<Genetic>::size_type i = 0; i < islands.size(); i++)
+	{
+		if (batch_sizes[i] == 0)
+		{
+			continue;
+		}
+
+		vector<gaussian> tested(v.begin() + first,v.begin() + first + batch_sizes[i]);
+		first += batch_sizes[i];
+
+		// Each island only ranks its own ECPs
+		int best = 0;
+		for (vector<gaussian>::size_type j = 1; j < tested.size(); j++)
+		{
+			if (tested[j].function < tested[best].function)
+			{
+				best = j;
+			}
+		}
+
+		cout << "Island " << i << " :" << endl;
+		islands[i].set_ecps_tested(tested,best);
+
+		if (!islands[i].get_converged())
+		{
+			searching = true;
+		}
+	}
+
+	converged = !searching;
+
+	if (!converged)
+	{
+		migrate();
+	}
+}
+
+/*
+ Every migration_interval generations, send the best ECP of each island to the next island round the ring.
+ The islands are all formed at the same time, so the first still searching tells us if it is time
+
+ No param
+ */
+void Islands::migrate()
+{
+	vector<unsigned int> ring;
+
+	for (vector<Genetic>::size_type i = 0; i < islands.size(); i++)
+	{
+		if (islands[i].get_population_formed())
+		{
+			ring.push_back(i);
+		}
+	}
+
+	if ((ring.size() < 2) || (islands[ring[0]].get_generation() % migration_interval != 0))
+	{
+		return;
+	}
+
+	// Take every migrant before any arrive, so none travels more than one island
+	vector<gaussian> migrants(ring.size());
+
+	for (vector<unsigned int>::size_type i = 0; i < ring.size(); i++)
+	{
+		migrants[i] = islands[ring[i]].get_migrant();
+	}
+
+	int arrived = 0;
+
+	for (vector<unsigned int>::size_type i = 0; i < ring.size(); i++)
+	{
+		if (islands[ring[(i + 1) % ring.size()]].add_migrant(migrants[i]))
+		{
+			arrived++;
+		}
+	}
+
+	cout << endl;
+	cout << "Migration after generation " << islands[ring[0]].get_generation() << " : "
+	     << arrived << " of " << ring.size() << " migrants joined a population" << endl;
+	cout << endl;
+}
@@ -0,0 +1,91 @@
+/*
+ *  @Islands.h
+ *  fit_my_ecp
+ *
+ *  @brief Island model genetic algorithm. Several GA populations evolve side by side,
+ *  with every island's ECPs tested together in one batch. Every few generations each
+ *  island sends its best ECP to the next island round a ring, which keeps the
+ *  populations apart for longer than one large population would be.
+ *  Inherits some attributes from Outputs, which are rewritten here
+ *
+ */
+
+#ifndef ISLANDS_H
+#define ISLANDS_H
+
+#include "Genetic.h"
+
+class Islands : public Outputs {
+
+public:
+
+	/*
+	 Constructor
+
+	 No params
+	 */
+	Islands(){}
+
+	Islands(int *seed, int n, int mi);
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Islands(){}
+
+	virtual void set_parameters(std::vector< std::vector<double> > ss,
+				    std::vector< std::vector<double> > sr,
+  				    std::vector< std::vector<double> > ssm,
+				    std::vector<double> min,
+				    std::vector<double> max,
+				    int msod);
+
+	virtual void set_ga_parameters(int ps,
+				       int ms,
+				       int os,
+				       int cc,
+				       bool md,
+				       bool as);
+
+	virtual void set_sample_parameters(int bs, int ts);
+
+	virtual void set_starting_gaussians(gaussian v);
+
+	virtual std::vector<gaussian> get_ecps_to_test();
+
+	virtual void set_ecps_tested(std::vector<gaussian> v, int n);
+
+	/*
+	 Method to print the search type being conducted, common with all other search methods
+
+	 No Param
+	 */
+	virtual void print_type()
+	{
+		std::cout << "Performing an island model Genetic Algorithm search with " << islands.size() << " populations" << std::endl;
+	}
+
+protected:
+
+	// One GA per island
+	std::vector<Genetic> islands;
+	// Number of ECPs each island put in the last batch
+	std::vector<unsigned int> batch_sizes;
+	// Generations between migrations
+	int migration_interval;
+	// Each island draws its random numbers from a stream of its own, so its search
+	// doesn't depend on how many other islands there are or the order they are run in
+	std::vector<int> seeds;
+	std::vector<random_stream> streams;
+
+private:
+
+	void migrate();
+
+	void use_own_streams();
+};
+
+#endif
+
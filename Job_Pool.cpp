@@ -0,0 +1,329 @@
+/*
+ *  @file Job_Pool.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include "Job_Pool.h"
+
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ Constructor
+
+ @param[in] n Maximum number of calculations to run at once
+ */
+Job_Pool::Job_Pool(int n)
+{
+	max_jobs = n;
+
+	if (max_jobs < 1)
+	{
+		max_jobs = 1;
+	}
+
+	// Save where we started, so scratch folders can link back to it
+	char buffer[4096];
+	if (getcwd(buffer,sizeof(buffer)) != NULL)
+	{
+		launch_folder = buffer;
+	}
+	else
+	{
+		cout << "Could not determine the current working directory" << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	scratch_folder = "scratch";
+	copy_limit = 64.0e6;
+}
+
+/*
+ Set where the per-calculation folders are made, and what is kept out of them
+
+ @param[in] s Scratch folder, relative to the launch folder
+ @param[in] e Patterns of files in the launch folder that should not be linked into scratch
+ */
+void Job_Pool::set_scratch_folder(string s, vector<string> e)
+{
+	scratch_folder = s;
+	excluded = e;
+	// Never link the scratch folder into itself
+	excluded.push_back(s);
+}
+
+/*
+ Check a filename against the exclusion patterns
+
+ @param[in] name Filename in the launch folder
+ @return bool True if the file should not be linked into scratch
+ */
+bool Job_Pool::is_excluded(string name)
+{
+	for (vector<string>::size_type i = 0; i < excluded.size(); i++)
+	{
+		if (fnmatch(excluded[i].c_str(),name.c_str(),0) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ Copy one input into a scratch folder, keeping its permissions
+
+ @param[in] source File in the launch folder
+ @param[in] target File to create
+ @return bool True if the copy is complete
+ */
+bool Job_Pool::copy_input(string source, string target)
+{
+	struct stat sb;
+	int in = open(source.c_str(),O_RDONLY);
+
+	if ((in < 0) || (fstat(in,&sb) != 0))
+	{
+		if (in >= 0)
+		{
+			close(in);
+		}
+		return false;
+	}
+
+	int out = open(target.c_str(),O_WRONLY | O_CREAT | O_TRUNC,sb.st_mode & 0777);
+
+	if (out < 0)
+	{
+		close(in);
+		return false;
+	}
+
+	char buffer[65536];
+	ssize_t n;
+	bool complete = true;
+
+	while ((n = read(in,buffer,sizeof(buffer))) != 0)
+	{
+		if ((n < 0) && (errno == EINTR))
+		{
+			continue;
+		}
+
+		if ((n < 0) || (write(out,buffer,n) != n))
+		{
+			complete = false;
+			break;
+		}
+	}
+
+	close(in);
+
+	if (close(out) != 0)
+	{
+		complete = false;
+	}
+
+	return complete;
+}
+
+/*
+ Make a clean scratch folder for one calculation. Everything in the launch folder
+ that is an input (i.e. not excluded) is put in, so ChemShell finds the same files
+ as it would running in the launch folder. Files are copied, so a calculation that
+ writes to one (a dumpfile or checkpoint, say) cannot change it for the others.
+ Folders, and files above the copy limit, are linked instead, and must only be read.
+
+ @param[in] index Calculation index, used to name the folder
+ @return string Absolute path of the new folder
+ */
+string Job_Pool::create_scratch(int index)
+{
+	string base = launch_folder + "/" + scratch_folder;
+	string folder = base + "/job_" + NumberToString(index);
+
+	if ((mkdir(base.c_str(),0755) != 0) && (errno != EEXIST))
+	{
+		cout << "Could not create scratch folder: " << base << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// Clear anything left behind from an earlier run
+	remove_scratch(folder);
+
+	if (mkdir(folder.c_str(),0755) != 0)
+	{
+		cout << "Could not create scratch folder: " << folder << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	DIR *dir = opendir(launch_folder.c_str());
+
+	if (dir != NULL)
+	{
+		struct dirent *entry;
+
+		while ((entry = readdir(dir)) != NULL)
+		{
+			string name = entry->d_name;
+
+			if (cmpStr(name,".") || cmpStr(name,"..") || is_excluded(name))
+			{
+				continue;
+			}
+
+			string target = launch_folder + "/" + name;
+			string link = folder + "/" + name;
+			struct stat sb;
+
+			if ((stat(target.c_str(),&sb) == 0) && S_ISREG(sb.st_mode) && (sb.st_size <= copy_limit))
+			{
+				if (!copy_input(target,link))
+				{
+					cout << "Could not copy " << name << " into scratch folder " << folder << endl;
+					cout << "Critical Error" << endl;
+					exit(EXIT_FAILURE);
+				}
+
+				continue;
+			}
+
+			// Shared by every calculation, so say so the first time
+			bool reported = false;
+
+			for (vector<string>::size_type i = 0; i < linked.size(); i++)
+			{
+				if (cmpStr(linked[i],name))
+				{
+					reported = true;
+				}
+			}
+
+			if (!reported)
+			{
+				cout << "Linking " << name << " into the scratch folders rather than copying it. It must only be read" << endl;
+				linked.push_back(name);
+			}
+
+			if (symlink(target.c_str(),link.c_str()) != 0)
+			{
+				cout << "Could not link " << name << " into scratch folder " << folder << endl;
+			}
+		}
+
+		closedir(dir);
+	}
+
+	return folder;
+}
+
+/*
+ Start a calculation. The program is run directly from within the job folder,
+ with all output collected in chemshell.stdout in that folder.
+
+ @param[in] j Job to run. The pid is filled in here
+ */
+void Job_Pool::launch(pool_job j)
+{
+	string output = j.folder + "/chemshell.stdout";
+
+	j.launch_time = monotonic_seconds();
+	j.pid = runner.start(j.arguments,j.folder,output);
+	jobs.push_back(j);
+}
+
+/*
+ Block until one of the running calculations finishes, or is stopped
+ for running past the time limit. Calculations whose output shows they
+ are not going to finish well are stopped while we wait
+
+ @return pool_job The finished calculation, with its exit status
+ */
+pool_job Job_Pool::wait_for_any()
+{
+	if (jobs.size() == 0)
+	{
+		cout << "Waiting for a calculation when none are running" << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	while (true)
+	{
+		for (vector<pool_job>::size_type i = 0; i < jobs.size(); i++)
+		{
+			if (runner.check(jobs[i].pid,&jobs[i].status))
+			{
+				pool_job j = jobs[i];
+				jobs.erase(jobs.begin()+i);
+				return j;
+			}
+
+			if (jobs[i].watcher.poll())
+			{
+				cout << "Stopping calculation in " << jobs[i].folder << " : " << jobs[i].watcher.get_reason() << endl;
+				runner.abort(jobs[i].pid);
+			}
+		}
+
+		usleep(100000);
+	}
+}
+
+/*
+ Stop every calculation still running and wait for each to exit, so none are
+ left behind in their own process groups. Their results are thrown away
+
+ No params
+ */
+void Job_Pool::stop_all()
+{
+	for (vector<pool_job>::size_type i = 0; i < jobs.size(); i++)
+	{
+		cout << "Stopping calculation in " << jobs[i].folder << endl;
+		runner.stop(jobs[i].pid);
+	}
+
+	// Anything ignoring SIGTERM is killed once the grace period is up
+	for (vector<pool_job>::size_type i = 0; i < jobs.size(); i++)
+	{
+		runner.wait(jobs[i].pid);
+	}
+
+	jobs.clear();
+}
+
+/*
+ Callback for nftw to delete each entry in turn
+ */
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftwbuf)
+{
+	return remove(path);
+}
+
+/*
+ Delete a scratch folder and everything in it. Links are removed, not followed.
+
+ @param[in] folder Folder to remove
+ */
+void Job_Pool::remove_scratch(string folder)
+{
+	struct stat sb;
+
+	if (lstat(folder.c_str(),&sb) == 0)
+	{
+		nftw(folder.c_str(),remove_entry,16,FTW_DEPTH | FTW_PHYS);
+	}
+}
@@ -0,0 +1,137 @@
+/*
+ *  @Job_Pool.h
+ *  fit_my_ecp
+ *
+ *  @brief Runs ChemShell calculations concurrently, each in its own scratch folder,
+ *  and hands them back to the caller as they finish. Inputs are copied into each
+ *  folder, so anything a calculation writes stays its own
+ *
+ */
+
+#ifndef JOB_POOL_H
+#define JOB_POOL_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+// Personal headers
+#include "Utils.h"
+#include "Process_Runner.h"
+#include "Output_Watcher.h"
+
+/*
+ Details of a single calculation handed to the pool.
+ The tag is left for the caller to match the result back to its ECP.
+ The watcher, if active, follows the output so the calculation can be stopped early.
+ The status is filled in once the calculation has finished, and the launch time
+ (from monotonic_seconds) once it has been started.
+ */
+struct pool_job
+{
+	int tag;
+	int index;
+	std::string folder;
+	std::vector<std::string> arguments;
+	pid_t pid;
+	double launch_time;
+	Output_Watcher watcher;
+	process_status status;
+};
+
+class Job_Pool {
+
+public:
+
+	Job_Pool(int n);
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Job_Pool(){}
+
+	void set_scratch_folder(std::string s, std::vector<std::string> e);
+
+	/*
+	 Set the size above which inputs are linked into scratch rather than copied
+
+	 @param[in] l Limit in bytes
+	 */
+	void set_copy_limit(double l)
+	{
+		copy_limit = l;
+	}
+
+	/*
+	 Set the wall clock limits for each calculation
+
+	 @param[in] t Seconds before a calculation is stopped. Zero switches this off
+	 @param[in] g Seconds allowed after SIGTERM before SIGKILL is sent
+	 */
+	void set_timeout(double t, double g)
+	{
+		runner.set_timeout(t,g);
+	}
+
+	std::string create_scratch(int index);
+
+	void launch(pool_job j);
+
+	pool_job wait_for_any();
+
+	void stop_all();
+
+	void remove_scratch(std::string folder);
+
+	/*
+	 Return the number of calculations currently running
+
+	 @return int Number of running jobs
+	 */
+	int running()
+	{
+		return jobs.size();
+	}
+
+	/*
+	 Check if all the available job slots are in use
+
+	 @return bool True if no more jobs can be launched
+	 */
+	bool full()
+	{
+		return (int) jobs.size() >= max_jobs;
+	}
+
+	/*
+	 Return the launch folder, from which all relative paths are taken
+
+	 @return string Absolute path of the launch folder
+	 */
+	std::string get_launch_folder()
+	{
+		return launch_folder;
+	}
+
+private:
+
+	int max_jobs;
+	std::string launch_folder;
+	std::string scratch_folder;
+	// Patterns in the launch folder that are not put in scratch
+	std::vector<std::string> excluded;
+	// Inputs larger than this (bytes) are linked rather than copied, and the names already reported as linked
+	double copy_limit;
+	std::vector<std::string> linked;
+	// Jobs currently running
+	std::vector<pool_job> jobs;
+	Process_Runner runner;
+
+	bool is_excluded(std::string name);
+
+	bool copy_input(std::string source, std::string target);
+};
+
+#endif
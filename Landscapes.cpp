@@ -0,0 +1,61 @@
+/*
+ *  @file Landscapes.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include "Landscapes.h"
+
+using namespace std;
+
+/*
+ Check a landscape is one we know
+
+ @param[in] name Name of the landscape
+ @return bool True for sphere, rosenbrock or rastrigin
+ */
+bool landscape_exists(string name)
+{
+	return (cmpStr(name,"sphere") || cmpStr(name,"rosenbrock") || cmpStr(name,"rastrigin"));
+}
+
+/*
+ Work out a landscape.
+ sphere     : Sum of squares, a single smooth bowl
+ rosenbrock : Narrow curved valley, hard for steps along the axes
+ rastrigin  : Sphere with a local minimum at every whole number distance
+
+ @param[in] name Name of the landscape
+ @param[in] d Scaled distance of each value from the optimum
+ @return double Function, never negative
+ */
+double calculate_landscape(string name, const vector<double> &d)
+{
+	double f = 0.0;
+
+	if (cmpStr(name,"rosenbrock") && (d.size() > 1))
+	{
+		for (vector<double>::size_type i = 0; i + 1 < d.size(); i++)
+		{
+			double y = 1.0 + d[i];
+			double y_next = 1.0 + d[i+1];
+			f += 100.0 * (y_next - y*y) * (y_next - y*y) + d[i]*d[i];
+		}
+	}
+	else if (cmpStr(name,"rastrigin"))
+	{
+		for (vector<double>::size_type i = 0; i < d.size(); i++)
+		{
+			f += d[i]*d[i] + 10.0 * (1.0 - cos(2.0 * M_PI * d[i]));
+		}
+	}
+	else
+	{
+		for (vector<double>::size_type i = 0; i < d.size(); i++)
+		{
+			f += d[i]*d[i];
+		}
+	}
+
+	return f;
+}
@@ -0,0 +1,24 @@
+/*
+ *  @Landscapes.h
+ *  fit_my_ecp
+ *
+ *  @brief Analytic test functions, which stand in for the ChemShell function
+ *  when the searches are run without ChemShell. Each is given how far every
+ *  ECP value is from the optimum, already scaled by the caller, and is zero
+ *  at the optimum
+ *
+ */
+
+#ifndef LANDSCAPES_H
+#define LANDSCAPES_H
+
+#include <string>
+#include <vector>
+// Personal headers
+#include "Utils.h"
+
+bool landscape_exists(std::string name);
+
+double calculate_landscape(std::string name, const std::vector<double> &d);
+
+#endif
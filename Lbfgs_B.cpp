@@ -0,0 +1,851 @@
+/*
+ *  @file Lbfgs_B.cpp
+ *  fit_my_ecp
+ *
+ *  Follows Byrd, Lu, Nocedal and Zhu, SIAM J. Sci. Comput. 16 (1995) 1190:
+ *  generalised Cauchy point along the projected gradient path, then
+ *  minimisation of the quadratic model over the variables left free.
+ *  The L-BFGS matrix is kept dense, as we only ever fit a handful of parameters.
+ *
+ */
+
+#include <algorithm>
+#include "Lbfgs_B.h"
+
+using namespace std;
+
+// Sufficient decrease required of each step
+#define LBFGS_B_ARMIJO 1e-4
+// Projected gradient below which we are at a minimum
+#define LBFGS_B_PGTOL 1e-5
+
+/*
+ Dot product of two vectors
+
+ @param[in] a First vector
+ @param[in] b Second vector
+ @return double Dot product
+ */
+static double dot(const vector<double> &a, const vector<double> &b)
+{
+	double sum = 0.0;
+
+	for (vector<double>::size_type i = 0; i < a.size(); i++)
+	{
+		sum += a[i] * b[i];
+	}
+
+	return sum;
+}
+
+/*
+ Solve A x = b by Gaussian elimination with partial pivoting
+
+ @param[in] A Square matrix
+ @param[in/out] b Right hand side, replaced by the solution
+ @return bool False if the matrix is singular
+ */
+static bool solve(vector< vector<double> > A, vector<double> *b)
+{
+	const vector<double>::size_type n = b->size();
+
+	for (vector<double>::size_type k = 0; k < n; k++)
+	{
+		vector<double>::size_type pivot = k;
+
+		for (vector<double>::size_type i = k + 1; i < n; i++)
+		{
+			if (abs(A[i][k]) > abs(A[pivot][k]))
+			{
+				pivot = i;
+			}
+		}
+
+		if (A[pivot][k] == 0.0)
+		{
+			return false;
+		}
+
+		swap(A[k],A[pivot]);
+		swap((*b)[k],(*b)[pivot]);
+
+		for (vector<double>::size_type i = k + 1; i < n; i++)
+		{
+			const double factor = A[i][k] / A[k][k];
+
+			for (vector<double>::size_type j = k; j < n; j++)
+			{
+				A[i][j] -= factor * A[k][j];
+			}
+			(*b)[i] -= factor * (*b)[k];
+		}
+	}
+
+	for (vector<double>::size_type k = n; k-- > 0;)
+	{
+		for (vector<double>::size_type j = k + 1; j < n; j++)
+		{
+			(*b)[k] -= A[k][j] * (*b)[j];
+		}
+		(*b)[k] /= A[k][k];
+	}
+
+	return true;
+}
+
+/*
+ Constructor
+
+ @param[in/out] seed Pointer to the seed
+ */
+Lbfgs_B::Lbfgs_B(int *seed) : Outputs(seed)
+{
+	// Search area confines
+	step_size.resize(2);
+	step_size_min.resize(2);
+	minimums.resize(2,0.0);
+	maximums.resize(2,0.0);
+
+	history_size = 5;
+	max_evaluations = 200;
+	evaluations = 0;
+	iterations = 0;
+	f = 0.0;
+	step = 1.0;
+	started = false;
+}
+
+/*
+ Set the initial parameters for the LBFGS-B optimisation
+
+ @param[in] ss The finite difference step for the gradient, for A and zeta
+ @param[in] sr Step reduction rate for A and zeta (not used)
+ @param[in] ssm Convergence criteria, defined as the smallest step worth taking, for A and zeta
+ @param[in] min Minimum values for A and zeta
+ @param[in] max Maximum values for A and zeta
+ @param[in] msod Maximum steps in any one direction (not used)
+ */
+void Lbfgs_B::set_parameters(vector< vector<double> > ss,
+			     vector< vector<double> > sr,
+			     vector< vector<double> > ssm,
+			     vector<double> min,
+			     vector<double> max,
+			     int msod)
+{
+	step_size = ss;
+	step_size_min = ssm;
+	minimums = min;
+	maximums = max;
+
+	// - step size
+	if (step_size[0].size() == 0)
+	{
+		cout << "Using default starting step size for A: 0.001" << endl;
+		step_size[0].push_back(0.001);
+	}
+	if (step_size[1].size() == 0)
+	{
+		cout << "Using default starting step size for Z: 0.001" << endl;
+		step_size[1].push_back(0.001);
+	}
+	// - step size minimum
+	if (step_size_min[0].size() == 0)
+	{
+		cout << "Using default step size minimum for convergence for A: 1.0" << endl;
+		step_size_min[0].push_back(1.0);
+	}
+	if (step_size_min[1].size() == 0)
+	{
+		cout << "Using default step size minimum for convergence for Z: 0.001" << endl;
+		step_size_min[1].push_back(0.001);
+	}
+
+	// - constraining values for A
+	if (minimums[0] == 0.0)
+	{
+		cout << "Using default constraint of minimum value for A: 0.0" << endl;
+		minimums[0] = 0.0;
+	}
+	if (maximums[0] == 0.0)
+	{
+		cout << "Using default constraint of maximum value for A: 1000" << endl;
+		maximums[0] = 1000.0;
+	}
+	// - constraining values for Z
+	if (minimums[1] == 0.0)
+	{
+		cout << "Using default constraint of minimum value for Z: 0.0" << endl;
+		minimums[1] = 0.0;
+	}
+	if (maximums[1] == 0.0)
+	{
+		cout << "Using default constraint of maximum value for Z: 1000" << endl;
+		maximums[1] = 1000.0;
+	}
+}
+
+/*
+ Method to set the LBFGS-B parameters
+
+ @param[in] m Number of correction pairs kept for the Hessian approximation
+ @param[in] me Maximum number of ECPs to evaluate
+ */
+void Lbfgs_B::set_lbfgs_parameters(int m, int me)
+{
+	history_size = m;
+	max_evaluations = me;
+
+	// - history size
+	if (history_size < 1)
+	{
+		cout << "Using default history size for LBFGS-B : 5" << endl;
+		history_size = 5;
+	}
+	// - evaluations
+	if (max_evaluations < 1)
+	{
+		cout << "Using default maximum evaluations for LBFGS-B : 200" << endl;
+		max_evaluations = 200;
+	}
+}
+
+/*
+ Work out the box and finite difference step for each parameter.
+ A minimum of zero is not a usable ECP value, so the box starts a step above it
+
+ No param
+ */
+void Lbfgs_B::set_bounds()
+{
+	const unsigned int size = starting_gaussians.values.size();
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (step_size[i].size() != size)
+		{
+			step_size[i].resize(size,step_size[i][0]);
+		}
+
+		if (step_size_min[i].size() != size)
+		{
+			step_size_min[i].resize(size,step_size_min[i][0]);
+		}
+	}
+
+	lower.resize(size);
+	upper.resize(size);
+	h.resize(size);
+
+	for (unsigned int a = 0; a < size; a++)
+	{
+		const int type = starting_gaussians.values[a].type;
+
+		h[a] = step_size[type][a];
+		lower[a] = minimums[type];
+		upper[a] = maximums[type];
+
+		if (lower[a] == 0.0)
+		{
+			lower[a] = h[a];
+		}
+	}
+
+	cout << "======= Minimiser Settings =======" << endl;
+	cout << "n: " << size << endl;
+	cout << "m: " << history_size << endl;
+	cout << "maxfev: " << max_evaluations << endl;
+	cout << "pgtol: " << LBFGS_B_PGTOL << endl;
+}
+
+/*
+ Calculate ECPs to test from the initial data, starting from
+ the template values moved inside the box
+
+ No param.
+ */
+void Lbfgs_B::calculate_ecps_to_test()
+{
+	set_bounds();
+
+	x.resize(starting_gaussians.values.size());
+
+	for (vector<double>::size_type a = 0; a < x.size(); a++)
+	{
+		x[a] = min(max(starting_gaussians.values[a].value,lower[a]),upper[a]);
+
+		if (x[a] != starting_gaussians.values[a].value)
+		{
+			cout << "Moving starting value " << a << " inside the boundaries: " << x[a] << endl;
+		}
+	}
+
+	trial = make_gaussian(x);
+
+	ecps_to_test.clear();
+	add_stencil(x);
+}
+
+/*
+ Copy values into a gaussian shaped like the starting gaussians
+
+ @param[in] v Values
+ @return gaussian The ECP with those values
+ */
+gaussian Lbfgs_B::make_gaussian(const vector<double> &v)
+{
+	gaussian e = starting_gaussians;
+
+	for (vector<double>::size_type a = 0; a < v.size(); a++)
+	{
+		e.values[a].value = v[a];
+	}
+
+	return e;
+}
+
+/*
+ Add a point to be tested, along with the points either side in each
+ parameter for the gradient. Only points inside the box are added,
+ so at a wall the difference is taken one-sided
+
+ @param[in] v Values of the point
+ */
+void Lbfgs_B::add_stencil(const vector<double> &v)
+{
+	ecps_to_test.push_back(make_gaussian(v));
+
+	vector<double> w = v;
+
+	for (vector<double>::size_type a = 0; a < v.size(); a++)
+	{
+		if (v[a] + h[a] <= upper[a])
+		{
+			w[a] = v[a] + h[a];
+			ecps_to_test.push_back(make_gaussian(w));
+		}
+
+		if (v[a] - h[a] >= lower[a])
+		{
+			w[a] = v[a] - h[a];
+			ecps_to_test.push_back(make_gaussian(w));
+		}
+
+		w[a] = v[a];
+	}
+
+	evaluations += ecps_to_test.size();
+}
+
+/*
+ Find the function value of a point amongst the ECPs just tested
+
+ @param[in] v Values of the point
+ @param[out] fv Function value
+ @return bool True if the point was tested
+ */
+bool Lbfgs_B::find_function(const vector<double> &v, double *fv)
+{
+	const gaussian e = make_gaussian(v);
+
+	for (vector<gaussian>::size_type i = 0; i < ecps_tested.size(); i++)
+	{
+		if (compare_ecps(e,ecps_tested[i]))
+		{
+			*fv = ecps_tested[i].function;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ Read the function and finite difference gradient at a point from the ECPs just tested
+
+ @param[in] v Values of the point
+ @param[out] fv Function value
+ @param[out] gv Gradient
+ @return bool True if all the points were found
+ */
+bool Lbfgs_B::digest_stencil(const vector<double> &v, double *fv, vector<double> *gv)
+{
+	if (!find_function(v,fv))
+	{
+		return false;
+	}
+
+	gv->assign(v.size(),0.0);
+
+	vector<double> w = v;
+
+	for (vector<double>::size_type a = 0; a < v.size(); a++)
+	{
+		double f_plus = *fv;
+		double f_minus = *fv;
+		double width = 0.0;
+
+		if (v[a] + h[a] <= upper[a])
+		{
+			w[a] = v[a] + h[a];
+			if (!find_function(w,&f_plus))
+			{
+				return false;
+			}
+			width += h[a];
+		}
+
+		if (v[a] - h[a] >= lower[a])
+		{
+			w[a] = v[a] - h[a];
+			if (!find_function(w,&f_minus))
+			{
+				return false;
+			}
+			width += h[a];
+		}
+
+		w[a] = v[a];
+
+		// Parameters pinned between walls closer than a step have no gradient
+		if (width > 0.0)
+		{
+			(*gv)[a] = (f_plus - f_minus) / width;
+		}
+	}
+
+	return true;
+}
+
+/*
+ Check if the LBFGS-B has converged - if not form new ECPs to search
+
+ No param
+ */
+void Lbfgs_B::check_converged()
+{
+	// Clear ECPs
+	ecps_to_test.clear();
+
+	vector<double> x_trial(trial.values.size());
+
+	for (vector<double>::size_type a = 0; a < x_trial.size(); a++)
+	{
+		x_trial[a] = trial.values[a].value;
+	}
+
+	double f_trial = 0.0;
+	vector<double> g_trial;
+
+	if (!digest_stencil(x_trial,&f_trial,&g_trial))
+	{
+		cout << "LBFGS-B could not find all its points in the ECPs tested. Stopping" << endl;
+		converged = true;
+		return;
+	}
+
+	if (!started)
+	{
+		started = true;
+	}
+	// Check for sufficient decrease along the search direction, otherwise backtrack
+	else if (f_trial > f + LBFGS_B_ARMIJO * step * dot(g,d))
+	{
+		step *= 0.5;
+
+		bool step_allowed = false;
+		for (vector<double>::size_type a = 0; a < x.size(); a++)
+		{
+			x_trial[a] = x[a] + step * d[a];
+
+			if (abs(step * d[a]) >= step_size_min[trial.values[a].type][a])
+			{
+				step_allowed = true;
+			}
+		}
+
+		if (!step_allowed)
+		{
+			cout << "Line search step is below the step size minimum. Convergence obtained" << endl;
+			cout << "function: " << f << endl;
+			converged = true;
+			return;
+		}
+
+		if (evaluations >= max_evaluations)
+		{
+			cout << "Function evaluations has exceeded " << max_evaluations << " so exiting" << endl;
+			converged = true;
+			return;
+		}
+
+		cout << "Backtracking line search. Step: " << step << endl;
+
+		trial = make_gaussian(x_trial);
+		add_stencil(x_trial);
+		return;
+	}
+	else
+	{
+		// Save the correction pair, if it keeps the Hessian positive definite
+		vector<double> s(x.size());
+		vector<double> y(x.size());
+
+		for (vector<double>::size_type a = 0; a < x.size(); a++)
+		{
+			s[a] = x_trial[a] - x[a];
+			y[a] = g_trial[a] - g[a];
+		}
+
+		if (dot(s,y) > 1e-10 * dot(y,y))
+		{
+			s_history.push_back(s);
+			y_history.push_back(y);
+
+			if (s_history.size() > static_cast<vector<double>::size_type>(history_size))
+			{
+				s_history.erase(s_history.begin());
+				y_history.erase(y_history.begin());
+			}
+		}
+
+		iterations++;
+	}
+
+	// Accept the new point
+	bool moved = (iterations == 0);
+
+	for (vector<double>::size_type a = 0; a < x.size(); a++)
+	{
+		if (abs(x_trial[a] - x[a]) >= step_size_min[trial.values[a].type][a])
+		{
+			moved = true;
+		}
+
+		cout << "Old value: " << x[a] << endl;
+		cout << "New value: " << x_trial[a] << endl;
+	}
+
+	x = x_trial;
+	f = f_trial;
+	g = g_trial;
+
+	const double pgnorm = projected_gradient_norm();
+
+	if (!moved || (pgnorm < LBFGS_B_PGTOL))
+	{
+		cout << "Convergence obtained" << endl;
+		cout << "pgnorm: " << pgnorm << endl;
+		cout << "nfunc: " << evaluations << endl;
+		cout << "iter:  " << iterations << endl;
+		converged = true;
+		return;
+	}
+
+	if (evaluations >= max_evaluations)
+	{
+		cout << "Function evaluations has exceeded " << max_evaluations << " so exiting" << endl;
+		converged = true;
+		return;
+	}
+
+	if (!calculate_direction())
+	{
+		cout << "No downhill direction left inside the boundaries. Convergence obtained" << endl;
+		converged = true;
+		return;
+	}
+
+	// Without any curvature information keep the first step modest
+	step = 1.0;
+	if (s_history.size() == 0)
+	{
+		step = min(1.0,1.0 / sqrt(dot(d,d)));
+	}
+
+	for (vector<double>::size_type a = 0; a < x.size(); a++)
+	{
+		x_trial[a] = x[a] + step * d[a];
+	}
+
+	trial = make_gaussian(x_trial);
+	add_stencil(x_trial);
+}
+
+/*
+ Find the search direction: the generalised Cauchy point, refined over the free variables
+
+ @return bool False if there is no downhill direction
+ */
+bool Lbfgs_B::calculate_direction()
+{
+	Trace_Span span("lbfgsb direction","search");
+
+	vector< vector<double> > B;
+	vector<double> xc;
+
+	calculate_hessian(&B);
+	calculate_cauchy_point(B,&xc);
+	minimise_subspace(B,&xc);
+
+	d.resize(x.size());
+
+	for (vector<double>::size_type a = 0; a < x.size(); a++)
+	{
+		d[a] = xc[a] - x[a];
+	}
+
+	// Fall back on the projected steepest descent if the model has let us down
+	if (dot(g,d) >= 0.0)
+	{
+		for (vector<double>::size_type a = 0; a < x.size(); a++)
+		{
+			d[a] = min(max(x[a] - g[a],lower[a]),upper[a]) - x[a];
+		}
+	}
+
+	return dot(g,d) < 0.0;
+}
+
+/*
+ Build the L-BFGS Hessian approximation from the correction pairs
+
+ @param[out] B Hessian approximation
+ */
+void Lbfgs_B::calculate_hessian(vector< vector<double> > *B)
+{
+	const vector<double>::size_type n = x.size();
+
+	// Scale the initial matrix by the most recent curvature
+	double theta = 1.0;
+	if (s_history.size() > 0)
+	{
+		theta = dot(y_history.back(),y_history.back()) / dot(s_history.back(),y_history.back());
+	}
+
+	B->resize(n);
+
+	for (vector<double>::size_type i = 0; i < n; i++)
+	{
+		(*B)[i].assign(n,0.0);
+		(*B)[i][i] = theta;
+	}
+
+	// BFGS updates, oldest pair first
+	vector<double> Bs(n);
+
+	for (vector< vector<double> >::size_type k = 0; k < s_history.size(); k++)
+	{
+		const vector<double> &s = s_history[k];
+		const vector<double> &y = y_history[k];
+
+		for (vector<double>::size_type i = 0; i < n; i++)
+		{
+			Bs[i] = dot((*B)[i],s);
+		}
+
+		const double sBs = dot(s,Bs);
+		const double ys = dot(y,s);
+
+		for (vector<double>::size_type i = 0; i < n; i++)
+		{
+			for (vector<double>::size_type j = 0; j < n; j++)
+			{
+				(*B)[i][j] += (y[i] * y[j]) / ys - (Bs[i] * Bs[j]) / sBs;
+			}
+		}
+	}
+}
+
+/*
+ Find the first minimum of the quadratic model along the projected
+ gradient path x(t) = P(x - t g), one breakpoint at a time
+
+ @param[in] B Hessian approximation
+ @param[out] xc Generalised Cauchy point
+ */
+void Lbfgs_B::calculate_cauchy_point(const vector< vector<double> > &B, vector<double> *xc)
+{
+	const vector<double>::size_type n = x.size();
+
+	// Breakpoints where each variable reaches its bound
+	vector<double> t(n,HUGE_VAL);
+	vector<double> dd(n,0.0);
+	vector< pair<double,vector<double>::size_type> > breakpoints;
+
+	for (vector<double>::size_type i = 0; i < n; i++)
+	{
+		if (g[i] < 0.0)
+		{
+			t[i] = (x[i] - upper[i]) / g[i];
+		}
+		else if (g[i] > 0.0)
+		{
+			t[i] = (x[i] - lower[i]) / g[i];
+		}
+
+		if (t[i] > 0.0)
+		{
+			dd[i] = -g[i];
+
+			if (t[i] != HUGE_VAL)
+			{
+				breakpoints.push_back(make_pair(t[i],i));
+			}
+		}
+	}
+
+	sort(breakpoints.begin(),breakpoints.end());
+
+	*xc = x;
+
+	vector<double> z(n);
+	vector<double> Bd(n);
+	double t_old = 0.0;
+	vector< pair<double,vector<double>::size_type> >::size_type next = 0;
+
+	while (dot(dd,dd) > 0.0)
+	{
+		for (vector<double>::size_type i = 0; i < n; i++)
+		{
+			z[i] = (*xc)[i] - x[i];
+		}
+
+		for (vector<double>::size_type i = 0; i < n; i++)
+		{
+			Bd[i] = dot(B[i],dd);
+		}
+
+		// Slope and curvature of the model along this segment
+		const double fp = dot(g,dd) + dot(Bd,z);
+		const double fpp = dot(dd,Bd);
+
+		if (fp >= 0.0)
+		{
+			break;
+		}
+
+		const double t_next = (next < breakpoints.size()) ? breakpoints[next].first : HUGE_VAL;
+
+		if ((fpp > 0.0) && (t_old - fp / fpp < t_next))
+		{
+			for (vector<double>::size_type i = 0; i < n; i++)
+			{
+				(*xc)[i] += (-fp / fpp) * dd[i];
+			}
+			break;
+		}
+
+		if (t_next == HUGE_VAL)
+		{
+			break;
+		}
+
+		// Move on to the next breakpoint and fix the variables that reach their bounds
+		for (vector<double>::size_type i = 0; i < n; i++)
+		{
+			(*xc)[i] += (t_next - t_old) * dd[i];
+		}
+		t_old = t_next;
+
+		while ((next < breakpoints.size()) && (breakpoints[next].first <= t_next))
+		{
+			const vector<double>::size_type i = breakpoints[next].second;
+			(*xc)[i] = (dd[i] > 0.0) ? upper[i] : lower[i];
+			dd[i] = 0.0;
+			next++;
+		}
+	}
+}
+
+/*
+ Minimise the quadratic model over the variables not at a bound at the
+ Cauchy point, then pull back along that step to stay inside the box
+
+ @param[in] B Hessian approximation
+ @param[in/out] xc Cauchy point, replaced by the minimum found
+ */
+void Lbfgs_B::minimise_subspace(const vector< vector<double> > &B, vector<double> *xc)
+{
+	const vector<double>::size_type n = x.size();
+
+	vector<vector<double>::size_type> free_variables;
+
+	for (vector<double>::size_type i = 0; i < n; i++)
+	{
+		if (((*xc)[i] > lower[i]) && ((*xc)[i] < upper[i]))
+		{
+			free_variables.push_back(i);
+		}
+	}
+
+	if (free_variables.size() == 0)
+	{
+		return;
+	}
+
+	// Reduced gradient of the model at the Cauchy point
+	vector<double> z(n);
+
+	for (vector<double>::size_type i = 0; i < n; i++)
+	{
+		z[i] = (*xc)[i] - x[i];
+	}
+
+	const vector<double>::size_type nf = free_variables.size();
+	vector< vector<double> > BFF(nf,vector<double>(nf));
+	vector<double> du(nf);
+
+	for (vector<double>::size_type i = 0; i < nf; i++)
+	{
+		du[i] = -(g[free_variables[i]] + dot(B[free_variables[i]],z));
+
+		for (vector<double>::size_type j = 0; j < nf; j++)
+		{
+			BFF[i][j] = B[free_variables[i]][free_variables[j]];
+		}
+	}
+
+	if (!solve(BFF,&du))
+	{
+		return;
+	}
+
+	// Largest fraction of the step which stays in the box
+	double alpha = 1.0;
+
+	for (vector<double>::size_type i = 0; i < nf; i++)
+	{
+		const vector<double>::size_type k = free_variables[i];
+
+		if (du[i] > 0.0)
+		{
+			alpha = min(alpha,(upper[k] - (*xc)[k]) / du[i]);
+		}
+		else if (du[i] < 0.0)
+		{
+			alpha = min(alpha,(lower[k] - (*xc)[k]) / du[i]);
+		}
+	}
+
+	for (vector<double>::size_type i = 0; i < nf; i++)
+	{
+		(*xc)[free_variables[i]] += alpha * du[i];
+	}
+}
+
+/*
+ Largest component of the projected gradient, which is zero at a minimum in the box
+
+ @return double Infinity norm of the projected gradient
+ */
+double Lbfgs_B::projected_gradient_norm()
+{
+	double norm = 0.0;
+
+	for (vector<double>::size_type a = 0; a < x.size(); a++)
+	{
+		norm = max(norm,abs(min(max(x[a] - g[a],lower[a]),upper[a]) - x[a]));
+	}
+
+	return norm;
+}
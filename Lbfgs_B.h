@@ -0,0 +1,140 @@
+/*
+ *  @Lbfgs_B.h
+ *  fit_my_ecp
+ *
+ *  @brief Implementation of a box-constrained L-BFGS (L-BFGS-B) minimisation.
+ *  Each iterate is tested alongside the finite difference points for its gradient,
+ *  which stay inside the mins and maxes, and steps follow the projected gradient path.
+ *  Inherits some attributes from Outputs, which are rewritten here
+ *
+ */
+
+#ifndef LBFGS_B_H
+#define LBFGS_B_H
+
+#include "Utils.h"
+#include "Outputs.h"
+
+class Lbfgs_B : public Outputs {
+
+public:
+
+	/*
+	 Constructor
+
+	 No params
+	 */
+	Lbfgs_B(){}
+
+	Lbfgs_B(int *seed);
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Lbfgs_B(){}
+
+	virtual void set_parameters(std::vector< std::vector<double> > ss,
+				    std::vector< std::vector<double> > sr,
+  				    std::vector< std::vector<double> > ssm,
+				    std::vector<double> min,
+				    std::vector<double> max,
+				    int msod);
+
+	virtual void set_lbfgs_parameters(int m, int me);
+
+	/*
+	 Defines initial ECPs, and sets up class
+
+	 @param[in] v Vector of initial gaussian(s) read in from ecp.template
+	 */
+	void set_starting_gaussians(gaussian v)
+	{
+		starting_gaussians = v;
+		calculate_ecps_to_test();
+	}
+
+	/*
+	 Takes in the details of the last search run, and saves data
+
+	 @param[in] v Vector of ECPs just tested
+	 @param[in] n Index of the highest ranked ECP
+	 */
+	void set_ecps_tested(std::vector<gaussian> v, int n)
+	{
+		ecps_tested = v;
+		check_converged();
+	}
+
+	/*
+	 Method to print the search type being conducted, common with all other search methods
+
+	 No Param
+	 */
+	virtual void print_type()
+	{
+		std::cout << "Performing a bound constrained LBFGS-B minimisation" << std::endl;
+	}
+
+protected:
+
+	// Int
+	int history_size;
+	int max_evaluations;
+	int evaluations;
+	int iterations;
+	// Vectors
+	std::vector<gaussian> ecps_tested;
+	// Floats
+	std::vector< std::vector<double> > step_size;
+	std::vector< std::vector<double> > step_size_min;
+	std::vector<double> maximums;
+	std::vector<double> minimums;
+	// Current iterate, with its function and gradient
+	std::vector<double> x;
+	std::vector<double> g;
+	double f;
+	// Line search direction and step length along it
+	std::vector<double> d;
+	double step;
+	// Bounds and finite difference steps for each parameter
+	std::vector<double> lower;
+	std::vector<double> upper;
+	std::vector<double> h;
+	// Correction pairs, oldest first
+	std::vector< std::vector<double> > s_history;
+	std::vector< std::vector<double> > y_history;
+	// Others
+	gaussian trial;
+	bool started;
+
+	virtual void calculate_ecps_to_test();
+
+	virtual void check_converged();
+
+private:
+
+	void set_bounds();
+
+	gaussian make_gaussian(const std::vector<double> &v);
+
+	void add_stencil(const std::vector<double> &v);
+
+	bool find_function(const std::vector<double> &v, double *fv);
+
+	bool digest_stencil(const std::vector<double> &v, double *fv, std::vector<double> *gv);
+
+	bool calculate_direction();
+
+	void calculate_hessian(std::vector< std::vector<double> > *B);
+
+	void calculate_cauchy_point(const std::vector< std::vector<double> > &B, std::vector<double> *xc);
+
+	void minimise_subspace(const std::vector< std::vector<double> > &B, std::vector<double> *xc);
+
+	double projected_gradient_norm();
+};
+
+#endif
+
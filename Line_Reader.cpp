@@ -0,0 +1,260 @@
+/*
+ *  @file Line_Reader.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include "Line_Reader.h"
+
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ Constructor
+
+ @param[in] filename File to read
+ @param[in] critical Catch for critical errors to terminate program if the file cannot be opened
+ */
+Line_Reader::Line_Reader(string filename, bool critical)
+{
+	opened = false;
+	data = NULL;
+	size = 0;
+	position = 0;
+	lines_read = 0;
+
+	int fd = open(filename.c_str(),O_RDONLY);
+	struct stat st;
+
+	if ((fd >= 0) && (fstat(fd,&st) == 0))
+	{
+		opened = true;
+		size = (size_t) st.st_size;
+
+		// Mapping nothing is an error, and there is nothing to read anyway
+		if (size > 0)
+		{
+			void *mapped = mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+
+			if (mapped == MAP_FAILED)
+			{
+				opened = false;
+				size = 0;
+			}
+			else
+			{
+				data = (const char *) mapped;
+				// We only ever walk forwards through the file
+				madvise(mapped,size,MADV_SEQUENTIAL);
+			}
+		}
+	}
+
+	// The mapping stays valid once the descriptor is closed
+	if (fd >= 0)
+	{
+		::close(fd);
+	}
+
+	if (!opened)
+	{
+		// Else throw error
+		string error = "Could not open input file: " + filename;
+		cout << error << endl;
+		if (critical)
+		{
+			cout << "Critical Error" << endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/*
+ Release the file early, once everything needed has been read.
+ Any views handed out are no longer valid after this.
+
+ No params
+ */
+void Line_Reader::close()
+{
+	if (data != NULL)
+	{
+		munmap((void *) data,size);
+		data = NULL;
+	}
+
+	opened = false;
+	size = 0;
+	position = 0;
+}
+
+/*
+ Get the next line of the file, without its line ending
+
+ @param[out] line View of the line, valid until the reader is closed
+ @return bool False once the end of the file is reached
+ */
+bool Line_Reader::next(line_view *line)
+{
+	if (position >= size)
+	{
+		return false;
+	}
+
+	const char *start = data + position;
+	const char *found = (const char *) memchr(start,'\n',size-position);
+	size_t length = (found != NULL) ? (size_t) (found - start) : size - position;
+
+	// Skip past the newline, if the last line has one
+	position += (found != NULL) ? length + 1 : length;
+
+	// Cope with files written on windows
+	if ((length > 0) && (start[length-1] == '\r'))
+	{
+		length--;
+	}
+
+	line->start = start;
+	line->length = length;
+	lines_read++;
+	return true;
+}
+
+/*
+ Check if a character separates tokens
+
+ @param[in] c Character to check
+ @param[in] delimiters Extra delimiters on top of whitespace
+ @return bool True if c is a delimiter
+ */
+static bool is_delimiter(char c, const char *delimiters)
+{
+	return (isspace((unsigned char) c) || (strchr(delimiters,c) != NULL && c != '\0'));
+}
+
+/*
+ Split a line into tokens, in the same way as Tokenize, but without copying anything.
+ The tokens vector is cleared first, so it can be reused line after line without allocating.
+
+ @param[in] line Line to split
+ @param[out] tokens Views of each token
+ @param[in] delimiters Extra delimiters on top of whitespace
+ */
+void split_view(line_view line, vector<line_view> &tokens, const char *delimiters)
+{
+	tokens.clear();
+
+	size_t i = 0;
+
+	while (i < line.length)
+	{
+		// Skip delimiters at beginning
+		while ((i < line.length) && is_delimiter(line.start[i],delimiters))
+		{
+			i++;
+		}
+
+		if (i == line.length)
+		{
+			break;
+		}
+
+		line_view token;
+		token.start = line.start + i;
+
+		while ((i < line.length) && !is_delimiter(line.start[i],delimiters))
+		{
+			i++;
+		}
+
+		token.length = (line.start + i) - token.start;
+		tokens.push_back(token);
+	}
+}
+
+/*
+ Compare a view to a string
+
+ @param[in] v View
+ @param[in] s String
+ @return bool True if they match exactly
+ */
+bool cmpView(line_view v, const char *s)
+{
+	return ((strlen(s) == v.length) && (strncmp(v.start,s,v.length) == 0));
+}
+
+/*
+ Look for a string anywhere in a view
+
+ @param[in] v View
+ @param[in] s String
+ @return bool True if s appears in v
+ */
+bool view_contains(line_view v, const char *s)
+{
+	const size_t length = strlen(s);
+
+	for (size_t i = 0; i + length <= v.length; i++)
+	{
+		if (strncmp(v.start+i,s,length) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ Check the last character of a view
+
+ @param[in] v View
+ @param[in] c Character
+ @return bool True if the view is not empty and ends with c
+ */
+bool view_ends_with(line_view v, char c)
+{
+	return ((v.length > 0) && (v.start[v.length-1] == c));
+}
+
+/*
+ Read a double from a view. Fortran style exponents (1.0D+00) are accepted.
+
+ @param[in] v View
+ @param[out] val Number read
+ @return bool True if a number was read
+ */
+bool ViewToNumber(line_view v, double &val)
+{
+	return parse_number(v.start,v.start+v.length,val);
+}
+
+/*
+ Read an integer from a view
+
+ @param[in] v View
+ @param[out] val Number read
+ @return bool True if a number was read
+ */
+bool ViewToNumber(line_view v, int &val)
+{
+	return parse_number(v.start,v.start+v.length,val);
+}
+
+/*
+ Copy a view into a string
+
+ @param[in] v View
+ @return string Copy of the text
+ */
+string view_to_string(line_view v)
+{
+	return string(v.start,v.length);
+}
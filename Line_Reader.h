@@ -0,0 +1,99 @@
+/*
+ *  @Line_Reader.h
+ *  fit_my_ecp
+ *
+ *  @brief Maps a text file into memory and hands it out one line at a time.
+ *  Lines and tokens are views straight into the mapped bytes, so nothing
+ *  is copied or allocated per line, however large the file.
+ *
+ */
+
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+// Personal headers
+#include "Utils.h"
+
+/*
+ A non-owning view of part of a line. Only valid while the reader is open.
+ */
+struct line_view
+{
+	const char *start;
+	size_t length;
+};
+
+class Line_Reader {
+
+public:
+
+	Line_Reader(std::string filename, bool critical = true);
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Line_Reader()
+	{
+		close();
+	}
+
+	bool next(line_view *line);
+
+	void close();
+
+	/*
+	 Check the file could be opened
+
+	 @return bool True if the file is open for reading
+	 */
+	bool is_open()
+	{
+		return opened;
+	}
+
+	/*
+	 Return the number of lines read so far, which is the line number of the
+	 last line returned, counting from one
+
+	 @return size_t Number of lines read
+	 */
+	size_t line_number()
+	{
+		return lines_read;
+	}
+
+private:
+
+	bool opened;
+	// Mapped contents of the file. NULL for an empty file.
+	const char *data;
+	size_t size;
+	// Start of the next unread line
+	size_t position;
+	size_t lines_read;
+
+	// Readers own their mapping, so copying makes no sense
+	Line_Reader(const Line_Reader &);
+	Line_Reader &operator=(const Line_Reader &);
+};
+
+// Split a line into tokens, using whitespace and any extra delimiters given
+void split_view(line_view line, std::vector<line_view> &tokens, const char *delimiters = "");
+// Compare a view to a string
+bool cmpView(line_view v, const char *s);
+// Look for a string anywhere in a view
+bool view_contains(line_view v, const char *s);
+// Check if a view finishes with the given character
+bool view_ends_with(line_view v, char c);
+// Read numbers from a view. Fortran style D exponents are accepted for doubles
+bool ViewToNumber(line_view v, double &val);
+bool ViewToNumber(line_view v, int &val);
+// Copy a view into a string
+std::string view_to_string(line_view v);
+
+#endif
@@ -7,6 +7,7 @@
  *
  */
 
+#include <climits>
 #include "Linear.h"
 
 using namespace std;
@@ -24,6 +25,10 @@ Linear::Linear(int *seed) : Outputs(seed)
 	step_size.resize(2);
 	minimums.resize(2,0.0);
 	maximums.resize(2,0.0);
+
+	// Nothing to scan until we have some starting gaussians
+	grid_size = 0;
+	grid_position = 0;
 }
 
 /*
@@ -61,7 +66,15 @@ void Linear::resize_search_vectors(gaussian g)
 				}
 				else
 				{
-					new_step_size.push_back(step_size[i][counter]);
+					// Fewer step sizes than lines given, so the last carries on for the rest
+					if (counter < (int) step_size[i].size())
+					{
+						new_step_size.push_back(step_size[i][counter]);
+					}
+					else
+					{
+						new_step_size.push_back(step_size[i].back());
+					}
 					counter++;
 				}
 				//cout << i << " " << j << " " << new_step_size[j] << endl;
@@ -143,15 +156,14 @@ void Linear::set_parameters(vector< vector<double> > ss,
 }
 
 /*
- Calculate ECPs to test from the initial data
+ Calculate ECPs to test from the initial data.
+ Only the values allowed along each parameter are stored; the grid
+ itself is walked by index, one batch at a time
  
  No param.
  */
 void Linear::calculate_ecps_to_test()
 {		
-	//cout << "Creating ECPS" << endl;
-	//cout << ecps_to_test.size() << endl;	
-
 	// We'll do this using a univariate method, coupled with Powell's if I get time
 	gaussian g = starting_gaussians;
 	
@@ -161,106 +173,165 @@ void Linear::calculate_ecps_to_test()
 		resize_search_vectors(g);
 	}
 
-	//cout << step_size[0][0] << step_size[0][1] << step_size[1][0] << step_size[1][1] << endl;
-	//cout << step_size[0].size() << endl;
-	
-        // Initialise with minima
-        for (vector<gaussian_info>::size_type a = 0; a < g.values.size(); a++)
-        {
-		g.values[a].value = minimums[g.values[a].type];
+	calculate_grid_values(g);
 
-		// Protect against an instance where the starting point is an invalid number
-		if (g.values[a].value == 0.0)
+	// The grid size is the product of the number of values along each parameter
+	grid_size = 1;
+	grid_position = 0;
+
+	for (vector< vector<double> >::size_type a = 0; a < grid_values.size(); a++)
+	{
+		if (grid_values[a].size() == 0)
 		{
-			g.values[a].value += step_size[g.values[a].type][a];
-			//cout << g.values[a].value << " " << minimums[g.values[a].type] << " " << step_size[g.values[a].type][a] << endl;
+			grid_size = 0;
+			break;
 		}
-        }
 
-        ecps_to_test.push_back(g);
+		if (grid_size > ULLONG_MAX / grid_values[a].size())
+		{
+			cout << "Linear scan grid is too large to enumerate. Reduce the range or increase the step size." << endl;
+			exit(EXIT_FAILURE);
+		}
 
-        // Now lets do all the directions
-	// Give ourselves a variable to store the ecps_to_test length
-	// As this is altered in each loop
+		grid_size *= grid_values[a].size();
+	}
 
-	unsigned int ecps_to_test_length = ecps_to_test.size();
+	//cout << "Grid size " << grid_size << endl;
 
-	// cout << "G VALUES SIZE = " << g.values.size() << endl;
+	ecps_to_test.clear();
 
-	// Add all possible combinations on to the previous collections of results
-        for (vector<gaussian_info>::size_type a = 0; a < g.values.size(); a++)
+	// Insert Starting Gaussian For Comparison
+	if (check_boundaries(starting_gaussians))
 	{
-		ecps_to_test_length = ecps_to_test.size();
-		// cout << "ECPS LENGTH = " << ecps_to_test_length << endl;
+		ecps_to_test.push_back(starting_gaussians);
+	}
 
-		for (vector<gaussian>::size_type i = 0; i < ecps_to_test_length; i++)
-		{
-			// cout << ecps_to_test_length << " " << i << endl;
-			g = ecps_to_test[i];
+	calculate_next_batch();
+}
+
+/*
+ Work out the values to visit along each parameter, from the minimum
+ up to the maximum in steps. Values outside the boundaries are dropped here,
+ so every point on the grid is inside them
+ 
+ @param[in] g Gaussian with the parameters (and types) to scan
+ */
+void Linear::calculate_grid_values(const gaussian &g)
+{
+	grid_values.assign(g.values.size(),vector<double>());
 
-			//cout << g.values[a].value << " " << maximums[g.values[a].type] << " " << step_size[g.values[a].type][a] << endl;
+	for (vector<gaussian_info>::size_type a = 0; a < g.values.size(); a++)
+	{
+		const int type = g.values[a].type;
+		const double step = step_size[type][a];
+		vector<double> &values = grid_values[a];
 
-			while (g.values[a].value < maximums[g.values[a].type])
-        		{
-				// cout << g.values[a].value << " " << maximums[g.values[a].type]	<< endl;
-	                	if (g.values[a].value != 0.0)
-        	        	{
-                	        	ecps_to_test.push_back(g);
-                		}
+		// Initialise with minima
+		double value = minimums[type];
 
-	                	g.values[a].value += step_size[g.values[a].type][a];
-        		}
+		// Protect against an instance where the starting point is an invalid number
+		if (value == 0.0)
+		{
+			value += step;
 		}
-	}
 
-	//cout << "Created ECPs" << endl;
-	//cout << ecps_to_test.size() << endl;
+		values.push_back(value);
 
-	// Insert Starting Gaussian For Comparison
-	ecps_to_test.insert(ecps_to_test.begin(),starting_gaussians);
-	
-	// Check new values for duplicates
-	check_boundaries_duplicates();
+		// A step that doesn't move us on would never reach the maximum
+		if (step > 0.0)
+		{
+			value += step;
 
-	//cout << "Tested ECPs" << endl;
-	//cout << ecps_to_test.size() << endl;
+			while (value < maximums[type])
+			{
+				if (value != 0.0)
+				{
+					values.push_back(value);
+				}
+
+				value += step;
+			}
+		}
+
+		// Check for limits
+		for (vector<double>::size_type i = 0; i < values.size(); i++)
+		{
+			if ((minimums[type] > values[i]) || (maximums[type] < values[i]))
+			{
+				cout << "Erasing a value as it is outside the boundaries. Entry : " << values[i];
+				cout << " of Gaussian " << a << endl;
+				values.erase(values.begin()+i);
+				i--;
+			}
+		}
+	}
 }
 
 /*
- Check the boundary conditions to ensure everything is reasonable,
- and that we do not have any duplicates,
+ Fill ecps_to_test with the next batch of points from the grid,
+ skipping the starting gaussian if the grid lands on it
  
  No param
  */
-void Linear::check_boundaries_duplicates()
+void Linear::calculate_next_batch()
 {
-	for (vector<gaussian>::size_type ecps_counter = 0; ecps_counter != ecps_to_test.size(); ecps_counter++)
+	// Keep the starting gaussian if it is waiting to be tested in the first batch
+	if (grid_position > 0)
+	{
+		ecps_to_test.clear();
+	}
+
+	gaussian g = starting_gaussians;
+
+	while ((grid_position < grid_size) &&
+	       (ecps_to_test.size() < grid_batch_size))
 	{
-		//Check for duplicates
-		for (vector<gaussian>::size_type ecps_counter_two = ecps_counter + 1; ecps_counter_two != ecps_to_test.size(); ecps_counter_two++)
+		get_grid_point(grid_position,&g);
+		grid_position++;
+
+		// Grid points are distinct by construction, so the only possible duplicate is the starting gaussian
+		if (!compare_ecps(g,starting_gaussians))
 		{
-			if (compare_ecps(ecps_to_test[ecps_counter],ecps_to_test[ecps_counter_two]))
-			{
-				// cout << "ECP " << ecps_counter << " IS THE SAME AS " << ecps_counter_two << endl;
-				ecps_to_test.erase(ecps_to_test.begin()+ecps_counter_two);
-				// Decrease a by one as we've just removed an item
-				ecps_counter_two--;
-			}
+			ecps_to_test.push_back(g);
 		}
-		
-		// Check for limits
-		for (vector<gaussian_info>::size_type i = 0; i < ecps_to_test[ecps_counter].values.size(); i++)
+	}
+}
+
+/*
+ Decode a grid index into its values, with the first parameter varying fastest
+ 
+ @param[in] index Position on the grid
+ @param[out] g Gaussian to write the values in to
+ */
+void Linear::get_grid_point(unsigned long long index, gaussian *g)
+{
+	for (vector< vector<double> >::size_type a = 0; a < grid_values.size(); a++)
+	{
+		const unsigned long long n = grid_values[a].size();
+
+		g->values[a].value = grid_values[a][index % n];
+		index /= n;
+	}
+}
+
+/*
+ Check the boundary conditions to ensure everything is reasonable
+ 
+ @param[in] g Gaussian to check
+ @return bool True if all values are within the minimums and maximums
+ */
+bool Linear::check_boundaries(const gaussian &g)
+{
+	for (vector<gaussian_info>::size_type i = 0; i < g.values.size(); i++)
+	{
+		if ((minimums[g.values[i].type] > g.values[i].value) ||
+			(maximums[g.values[i].type] < g.values[i].value))
 		{
-			if ((minimums[ecps_to_test[ecps_counter].values[i].type] > ecps_to_test[ecps_counter].values[i].value) ||
-				(maximums[ecps_to_test[ecps_counter].values[i].type] < ecps_to_test[ecps_counter].values[i].value))
-			{
-				cout << "Erasing a value as it is outside the boundaries. Entry : " << ecps_to_test[ecps_counter].values[i].value;
-				cout << " of Gaussian " << i << endl;
-				// Erase value
-				ecps_to_test.erase(ecps_to_test.begin()+ecps_counter);
-				ecps_counter--;
-				i = ecps_to_test[ecps_counter].values.size();
-			}
+			cout << "Erasing a value as it is outside the boundaries. Entry : " << g.values[i].value;
+			cout << " of Gaussian " << i << endl;
+			return false;
 		}
 	}
+
+	return true;
 }
@@ -57,7 +57,8 @@ public:
 	}
 	
 	/*
-	 Takes in the details of the last search run, and saves data
+	 Takes in the details of the last search run, and saves data.
+	 Moves on to the next batch of the grid if there is one.
 	 
 	 @param[in] v Vector of ECPs just tested
 	 @param[in] n Index of the highest ranked ECP
@@ -97,26 +98,47 @@ protected:
 	//std::vector< std::vector<double> > step_size_min;
 	std::vector<double> minimums;
 	std::vector<double> maximums;
+	// Grid - the allowed values along each parameter, and our place in the scan
+	std::vector< std::vector<double> > grid_values;
+	unsigned long long grid_size;
+	unsigned long long grid_position;
 	// Others
 	//gaussian previous_minimum;
 	
  	virtual void calculate_ecps_to_test();
 	
 	/*
-	Set this to true after one loop - instant exit
+	Set this to true once the whole grid has been handed out,
+	otherwise fill ecps_to_test with the next batch
  
 	No param
 	*/
 	virtual void check_converged()
 	{
-        	converged = true;
+		if (grid_position >= grid_size)
+		{
+        		converged = true;
+		}
+		else
+		{
+			calculate_next_batch();
+		}
 	}
 	
-	void check_boundaries_duplicates();
+	bool check_boundaries(const gaussian &g);
 	
 private:
+
+	// Number of grid points handed out with each call to get_ecps_to_test
+	static const unsigned int grid_batch_size = 1000;
 	
 	void resize_search_vectors(gaussian g);
+
+	void calculate_grid_values(const gaussian &g);
+
+	void calculate_next_batch();
+
+	void get_grid_point(unsigned long long index, gaussian *g);
 };
 
 #endif
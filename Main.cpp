@@ -16,6 +16,7 @@
 // - Spin Polarised ECPs
 
 // System headers
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 // Personal headers
@@ -24,7 +25,13 @@
 #include "IO.h"
 #include "Functions.h"
 #include "Genetic.h"
+#include "Islands.h"
 #include "Linear.h"
+#include "Quasi_Random.h"
+#include "Lbfgs_B.h"
+#include "Cma_Es.h"
+#include "Bayesian.h"
+#include "Surrogate.h"
 #include "Powells.h"
 #include "Outputs.h"
 #include "Newton_Raphson.h"
@@ -34,6 +41,8 @@
 #include "DFT_Program.h"
 #include "Gamess_UK.h"
 #include "Nwchem.h"
+#include "Job_Pool.h"
+#include "Trace.h"
 
 using namespace std;
 
@@ -58,7 +67,12 @@ void inputs()
 	cout << "              powells : Performs downhill minimisation to best ECP.          Requirements as above" << endl;
 	cout << "              newton  : Performs quasi-newtonian minimisation.               Requirements as above" << endl;
         cout << "              lbfgs   : Performs minimimisation.                             Requirements as above" << endl; 
+	cout << "              lbfgsb  : Performs minimisation within the mins and maxes.     Requirements as above" << endl;
+	cout << "              cmaes   : Performs global optimisation with CMA-ES.            Requirements as above" << endl;
+	cout << "              bayes   : Performs Bayesian optimisation within the mins and maxes. Requirements as above" << endl;
 	cout << "              ga      : Performs global optimisation with genetic algorithm. Requirements as above" << endl;
+	cout << "              sobol   : Samples between mins and maxes with a Sobol sequence. Requirements as above" << endl;
+	cout << "              lhs     : Samples between mins and maxes with a Latin hypercube. Requirements as above" << endl;
 	cout << endl;
 	cout << "-ef,--ecpfile=ECP_FILENAME              : Output location of ECP file, as defined in CHM_FILE" << endl;
 	cout << "-et,--ecptemplate=ECP_FILENAME          : Locaton of input ECP template file" << endl;
@@ -70,6 +84,8 @@ void inputs()
 	cout << "-of,--outputfolder=OUTPUT_FOLDER        : Folder to move results in to. Default: results" << endl;
         cout << "-e,--executable=EXECUTABLE              : ChemShell executable" << endl;
         cout << "-a,--anion=CHEMICAL_SYMBOL              : Species for which we are comparing deep lying orbitals (e.g. O 1s)" << endl;
+	cout << "-s,--scratch=SCRATCH_FOLDER             : Folder in which each calculation gets its own working folder. Default: scratch" << endl;
+	cout << "--trace=TRACE_FILENAME                  : Record the time spent on each stage, for chrome://tracing or ui.perfetto.dev. Default: OFF" << endl;
 	cout << endl;
 	cout << "*** Numeric Values ***" << endl;
 	cout << endl;
@@ -86,6 +102,11 @@ void inputs()
 //        cout << "--anion_spread=NUMBER      : Number of eigenvalues to include in spread of interest. Default: Number of anion species in Region 1)" << endl;
         cout << "--processors=NUMBER          : Total number of processors (HECToR)" << endl;
         cout << "--processors_per_node=NUMBER : Number of processors per node (HECToR)" << endl;
+	cout << "--jobs=NUMBER                : Number of ChemShell calculations to run at once. Default: 1" << endl;
+	cout << "--sample_batch=NUMBER        : Number of ECPs generated at once by sobol/lhs/powells/cmaes/bayes, or kept running by an asynchronous ga. Default: jobs" << endl;
+	cout << "--timeout=NUMBER             : Wall clock seconds before a ChemShell calculation is stopped and marked failed. Default: OFF" << endl;
+	cout << "--kill_grace=NUMBER          : Seconds to wait after stopping a calculation before it is killed. Default: 30" << endl;
+	cout << "--scratch_copy_limit=NUMBER  : Inputs up to this many MB are copied into each scratch folder, larger ones are linked. Default: 64" << endl;
         cout << endl;
 	cout << "*** Function Weights ***" << endl;
 	cout << endl;
@@ -112,13 +133,28 @@ void inputs()
 	cout << "--ga_offspring=NUMBER    : Offspring Size for GA run. Default: 2" << endl;
 	cout << "--ga_mutations=NUMBER    : Mutations Size for GA run. Default: 2" << endl;
 	cout << "--ga_convergence=NUMBER  : Convergence Criteria for GA run. Default: 3" << endl;
+	cout << "--ga_islands=NUMBER      : Number of GA populations, each with the population, offspring and mutations sizes above. Default: 1" << endl;
+	cout << "--ga_migration=NUMBER    : Generations between sending the best ECP of each island to the next. Default: 5" << endl;
+	cout << endl;
+	cout << "*** LBFGS-B Settings ***" << endl;
+	cout << endl;
+	cout << "--lbfgs_history=NUMBER     : Number of corrections kept for the Hessian approximation. Default: 5" << endl;
+	cout << "--lbfgs_evaluations=NUMBER : Maximum number of ECPs evaluated by the minimiser. Default: 200" << endl;
+	cout << endl;
+	cout << "*** Surrogate Settings ***" << endl;
+	cout << endl;
+	cout << "--surrogate_kappa=NUMBER : Standard deviations an ECP must be predicted above the best to be skipped. Default: 3" << endl;
 	cout << endl;
 	cout << "*** Boolean Options ***" << endl;
 	cout << endl;
 	cout << "--ga_mutation_dynamic    : Use dynamic mutation in GA Search" << endl;
+	cout << "--ga_asynchronous        : Use a steady-state GA, replacing one population member as each ECP finishes" << endl;
         cout << "--force_history_recalc   : All functions read in from History will be recalculated, to account for lost accuracy in outputs" << endl;
 //        cout << "--remove_history_duds    : Remove all Gaussians from History that are duds (888888), thus forcing their re-run" << endl;
 	cout << "--not_absolute_gradients : Do not use absolute gradients, but just as-read values (for 1D systems)" << endl;
+	cout << "--surrogate              : Skip ECPs which a model of the history predicts are clearly worse than the best" << endl;
+	cout << "--surrogate_report       : Report how many ChemShell calculations the surrogate model has saved" << endl;
+	cout << "--watch_output           : Follow each QM output as it is written, and stop calculations whose SCF is failing or that report an error" << endl;
 }
 
 /*
@@ -163,6 +199,23 @@ void print_chemshell_message(gaussian g, int cc, int ci)
 	cout << endl;	
 }
 
+/*
+ Returns the location of a file within a calculation folder
+
+ @param[in] folder Calculation folder. Empty if working in the launch folder
+ @param[in] file Filename
+ @return string Path to the file
+ */
+string in_folder(string folder, string file)
+{
+	if ((folder.length() == 0) || (file.length() == 0) || (file[0] == '/'))
+	{
+		return file;
+	}
+
+	return folder + "/" + file;
+}
+
 /*
  Main method. Here we read in, organise and perform the ECP minimisation
  Most of the IO is outsourced, as is managing which ECPs to calculate with
@@ -188,6 +241,17 @@ int main (int argc, char * const argv[]) {
 	// To be used later with parallelisation
 	int processors_per_node = 0;
 	int processors = 0;
+	// Number of ChemShell calculations running at once
+	int jobs = 0;
+	// Number of ECPs generated at once by space-filling searches
+	int sample_batch = 0;
+	// Time limits for each ChemShell calculation, in seconds
+	double timeout = 0;
+	double kill_grace = -1;
+	// Inputs up to this size (MB) are copied into each scratch folder
+	double scratch_copy_limit = -1;
+	// Screening of ECPs with a model of the history
+	double surrogate_kappa = 0;
 	// Strings
 	string function = "";
 	string ecp_file = "";
@@ -203,6 +267,8 @@ int main (int argc, char * const argv[]) {
 	string gradient_output_file = "";
 	string output_folder = "";
         string anion_species = "";
+	string scratch_folder = "";
+	string trace_output_file = "";
 	// string command_line = "";
 	// Vectors
 	vector<string> outData;
@@ -216,9 +282,13 @@ int main (int argc, char * const argv[]) {
 	bool force_recalc = false;
 //        bool remove_duds = false;
         bool absolute_gradients = true;
+	bool surrogate_screening = false;
+	bool surrogate_report = false;
+	bool watch_output = false;
 	// Some classes to do the important stuff
 	Outputs *ecp_searcher = NULL;
 	Functions *func_calc = new Functions();
+	Job_Pool *job_pool = NULL;
 	// History *ecps_history = new History();
         vector<History *> ecps_history;
 
@@ -247,6 +317,11 @@ int main (int argc, char * const argv[]) {
 		int mutations_size = 0;
 		int offspring_size = 0;
 		int convergence_criteria = 0;
+		int ga_islands = 0;
+		int ga_migration = 0;
+		// Initialise LBFGS-B parameters
+		int lbfgs_history = 0;
+		int lbfgs_evaluations = 0;
 		// We are going to put in the function weights here
 		// These will be put to defaults in the appropriate region
 		// Initiate to -1 as 0 is acceptable
@@ -280,6 +355,7 @@ int main (int argc, char * const argv[]) {
 		string argv_variable = "";
 		// Boolean value
 		bool mutation_dynamic = false;
+		bool ga_asynchronous = false;
 		
 		for (int argc_counter = 1; argc_counter < argc; argc_counter++)
 		{
@@ -358,6 +434,14 @@ int main (int argc, char * const argv[]) {
                                 {
                                         anion_species = argv_value;
                                 }
+				else if (cmpStr("scratch",argv_variable) || cmpStr("s",argv_variable))
+				{
+					scratch_folder = argv_value;
+				}
+				else if (cmpStr("trace",argv_variable))
+				{
+					trace_output_file = argv_value;
+				}
 				// And now we'll collect numbers
 				else if (cmpStr("seed",argv_variable))
 				{
@@ -580,6 +664,38 @@ int main (int argc, char * const argv[]) {
 				{
 					StringToNumber(argv_value,processors_per_node);
 				}
+				else if (cmpStr("jobs",argv_variable))
+				{
+					StringToNumber(argv_value,jobs);
+				}
+				else if (cmpStr("sample_batch",argv_variable))
+				{
+					StringToNumber(argv_value,sample_batch);
+				}
+				else if (cmpStr("timeout",argv_variable))
+				{
+					StringToNumber(argv_value,timeout);
+				}
+				else if (cmpStr("kill_grace",argv_variable))
+				{
+					StringToNumber(argv_value,kill_grace);
+				}
+				else if (cmpStr("scratch_copy_limit",argv_variable))
+				{
+					StringToNumber(argv_value,scratch_copy_limit);
+				}
+				else if (cmpStr("surrogate_kappa",argv_variable))
+				{
+					StringToNumber(argv_value,surrogate_kappa);
+				}
+				else if (cmpStr("lbfgs_history",argv_variable))
+				{
+					StringToNumber(argv_value,lbfgs_history);
+				}
+				else if (cmpStr("lbfgs_evaluations",argv_variable))
+				{
+					StringToNumber(argv_value,lbfgs_evaluations);
+				}
 				else if (cmpStr("ga_population",argv_variable))
 				{
 					StringToNumber(argv_value,population_size);
@@ -596,6 +712,14 @@ int main (int argc, char * const argv[]) {
 				{
 					StringToNumber(argv_value,convergence_criteria);
 				}
+				else if (cmpStr("ga_islands",argv_variable))
+				{
+					StringToNumber(argv_value,ga_islands);
+				}
+				else if (cmpStr("ga_migration",argv_variable))
+				{
+					StringToNumber(argv_value,ga_migration);
+				}
 				else
 				{
 					// Insert error about correct usage
@@ -615,10 +739,26 @@ int main (int argc, char * const argv[]) {
                         {
                                 absolute_gradients = false;
                         }
+			else if (cmpStr("surrogate",argv_string))
+			{
+				surrogate_screening = true;
+			}
+			else if (cmpStr("surrogate_report",argv_string))
+			{
+				surrogate_report = true;
+			}
+			else if (cmpStr("watch_output",argv_string))
+			{
+				watch_output = true;
+			}
 			else if (cmpStr("ga_mutation_dynamic",argv_string))
 			{
 				mutation_dynamic = true;
 			}
+			else if (cmpStr("ga_asynchronous",argv_string))
+			{
+				ga_asynchronous = true;
+			}
 			else if (cmpStr("dryrun",argv_string) || cmpStr("d",argv_variable))
 			{
 				dry_run = true;
@@ -651,8 +791,22 @@ int main (int argc, char * const argv[]) {
 		}
 		else if (cmpStr(function,"ga"))
 		{
-			ecp_searcher = new Genetic(&random_seed);
-			
+			if (ga_islands > 1)
+			{
+				ecp_searcher = new Islands(&random_seed,ga_islands,ga_migration);
+			}
+			else
+			{
+				ecp_searcher = new Genetic(&random_seed);
+			}
+		}
+		else if (cmpStr(function,"sobol"))
+		{
+			ecp_searcher = new Quasi_Random(&random_seed);
+		}
+		else if (cmpStr(function,"lhs"))
+		{
+			ecp_searcher = new Quasi_Random(&random_seed,true);
 		}
                 else if (cmpStr(function,"newton"))
     		{
@@ -662,6 +816,18 @@ int main (int argc, char * const argv[]) {
                 {
                         ecp_searcher = new Newton_Raphson(&random_seed,true);
                 }
+		else if (cmpStr(function,"lbfgsb"))
+		{
+			ecp_searcher = new Lbfgs_B(&random_seed);
+		}
+		else if (cmpStr(function,"cmaes"))
+		{
+			ecp_searcher = new Cma_Es(&random_seed);
+		}
+		else if (cmpStr(function,"bayes"))
+		{
+			ecp_searcher = new Bayesian(&random_seed);
+		}
 		else
 		{
 			cout << "Function is not defined. Please address this." << endl;
@@ -678,7 +844,13 @@ int main (int argc, char * const argv[]) {
 		if (cmpStr(function,"ga"))
 		{
 			ecp_searcher->set_ga_parameters(population_size,mutations_size,offspring_size,
-											convergence_criteria,mutation_dynamic);
+											convergence_criteria,mutation_dynamic,ga_asynchronous);
+		}
+		
+		// Set LBFGS-B parameters
+		if (cmpStr(function,"lbfgsb"))
+		{
+			ecp_searcher->set_lbfgs_parameters(lbfgs_history,lbfgs_evaluations);
 		}
 		
 		// Set function calculation parameters
@@ -812,9 +984,75 @@ int main (int argc, char * const argv[]) {
 		}
 		//critical_error(!outputs_only || dry_run);
 	}
+	// - concurrent calculations
+	if (jobs < 1)
+	{
+		if (!outputs_only)
+		{
+			cout << "Using default number of concurrent ChemShell calculations: 1" << endl;
+		}
+		jobs = 1;
+	}
+	// - batches for space-filling and Powell's searches; fill the pool by default
+	if (sample_batch < 1)
+	{
+		if (cmpStr(function,"sobol") || cmpStr(function,"lhs") || cmpStr(function,"powells") ||
+		    cmpStr(function,"cmaes") || cmpStr(function,"bayes"))
+		{
+			cout << "Using default sample batch size: " << jobs << endl;
+		}
+		sample_batch = jobs;
+	}
+	// - surrogate screening
+	if (surrogate_screening && (surrogate_kappa <= 0))
+	{
+		if (!outputs_only)
+		{
+			cout << "Using default surrogate screening threshold: 3" << endl;
+		}
+		surrogate_kappa = 3;
+	}
+	if (surrogate_report && !surrogate_screening)
+	{
+		cout << "Surrogate report requested without --surrogate. Ignoring." << endl;
+		surrogate_report = false;
+	}
+	// - time limits
+	if (kill_grace < 0)
+	{
+		kill_grace = 30;
+	}
+	// - scratch folder
+	if (scratch_folder.length() == 0)
+	{
+		if (!outputs_only)
+		{
+			cout << "Using default scratch folder: scratch" << endl;
+		}
+		scratch_folder = "scratch";
+	}
+	if (scratch_copy_limit < 0)
+	{
+		if (!outputs_only)
+		{
+			cout << "Using default scratch copy limit: 64 MB" << endl;
+		}
+		scratch_copy_limit = 64;
+	}
 	// Defaults are set
 	cout << endl;
 
+	// Record where the time goes from here on
+	if (trace_output_file.length() > 0)
+	{
+		trace_open(trace_output_file);
+		cout << "Recording a trace of each stage in: " << trace_output_file << endl;
+		cout << endl;
+	}
+
+	// Space-filling and Powell's searches need to know the batch size and the budget of calculations
+	ecp_searcher->set_sample_parameters(sample_batch,chemshell_counter_max);
+
         // Decide what type of QM calculation we are looking at
         string qm_type = qm_output_file.substr(0,6);
 
@@ -826,6 +1064,26 @@ int main (int argc, char * const argv[]) {
         { 
         	qm_program = new Gamess_UK();
         }
+
+	// Set up the pool for running calculations.
+	// Outputs of previous runs and our own logs are kept out of the scratch folders
+	job_pool = new Job_Pool(jobs);
+	vector<string> scratch_excluded;
+	scratch_excluded.push_back(qm_type + "*");
+	scratch_excluded.push_back("gulp*");
+	scratch_excluded.push_back("hybrid*");
+	scratch_excluded.push_back("*nergy");
+	scratch_excluded.push_back("*xyz");
+	scratch_excluded.push_back(ecp_file);
+	scratch_excluded.push_back(punch_file);
+	scratch_excluded.push_back(gradient_output_file);
+	scratch_excluded.push_back(log_output_file + "*");
+	scratch_excluded.push_back(regions_output_file);
+	scratch_excluded.push_back(dma_output_file);
+	scratch_excluded.push_back(output_folder + "_*");
+	job_pool->set_scratch_folder(scratch_folder,scratch_excluded);
+	job_pool->set_timeout(timeout,kill_grace);
+	job_pool->set_copy_limit(scratch_copy_limit * 1.0e6);
 	
 	// Set anion offset
 	qm_program->set_anion_offset(region_1_anion_offset);
@@ -886,15 +1144,31 @@ int main (int argc, char * const argv[]) {
 		temp_output_log += NumberToString(a);
 		log_output_files.push_back(temp_output_log);
 	}
+
+	// One model of the history for each dataset
+	vector<Surrogate> surrogates(ecps_history.size(),Surrogate(surrogate_kappa));
+	// Calculations skipped by the models, and the time spent on those that were run
+	int surrogate_skipped = 0;
+	int calculations_timed = 0;
+	double calculation_seconds = 0;
+	// Calculations stopped early by following their output, and how long they had run
+	int calculations_stopped = 0;
+	double stopped_seconds = 0;
+	// Entries in each restart journal when it was last compacted, and records appended since.
+	// Records that are dropped on reading, such as repeats, only go when the journal is compacted
+	vector<vector<gaussian>::size_type> journal_compacted(punch.size(),0);
+	vector<vector<gaussian>::size_type> journal_appended(punch.size(),0);
 	
 
 	if (!outputs_only)
 	{
+		Trace_Span span("read restart","restart");
+
 		// Gather in all the different old outputs for restart
 		for (vector<History *>::size_type i_history = 0; i_history < ecps_history.size(); i_history++)
         	{
 			// Let's check if there are any old inputs we add to our history
-                        vector<gaussian> temp = read_in_binary(log_output_files[i_history]+".restart",false);
+                        vector<gaussian> temp = read_in_journal(log_output_files[i_history]+".restart",false);
 
 			// If the read of the binary file fails then we copy from the text outputs
 			if (temp.size() > 0)
@@ -934,9 +1208,15 @@ int main (int argc, char * const argv[]) {
 			outData.push_back(sentence);
 
 			write_out_lines(log_output_files[i_history],&outData,!dry_run);
-                        write_out_binary(log_output_files[i_history]+".restart",ecps_history[i_history]->get_history(),!dry_run);
+                        // Functions may have been recalculated, so compact the journal with the whole history
+                        write_out_journal(log_output_files[i_history]+".restart",ecps_history[i_history]->get_history(),!dry_run);
+			journal_compacted[i_history] = ecps_history[i_history]->size();
 		}
 		
+		// Searches which can start from what has been done before get to see the history
+		// The searcher works with the functions of the first punch file, as for set_ecps_tested
+		ecp_searcher->set_ecps_history(ecps_history[0]->get_history());
+
 		// Set up regions file
 		string sentence = "Entry\t|\t\tLine\t\tType\t\tValue";
 		outData.clear();
@@ -968,41 +1248,89 @@ int main (int argc, char * const argv[]) {
 		current_index += 1;
 	}
 	
+	// Searches which take results as they arrive get them back as soon as each ECP is done,
+	// while the other calculations keep running. Everything handed out by the searcher is
+	// held here until it has been passed back, and is cleared once nothing is left running.
+	const bool asynchronous = ecp_searcher->get_asynchronous();
+	// Let's duplicate these structures for the varying number of punch templates we are testing
+	vector< vector<gaussian> > ecps_to_test_vector(punch.size());
+	vector< vector<gaussian> > ecps_tested_vector(punch.size());
+	// We are going to explicitly define a vector for each dataset to show pulled from history
+	// With values set to 0 for false, 1 for true
+	vector< vector<int> > from_history_vector(punch.size());
+	// ECPs skipped by the surrogate models
+	vector<bool> screened;
+	// Calculations still to finish for each ECP, or -1 once it has been passed back
+	vector<int> outstanding;
+	// Everything that still needs calculating, as (dataset, ECP) pairs.
+	// All datasets share one queue so their calculations can run side by side.
+	vector< pair<vector<gaussian>::size_type,vector<gaussian>::size_type> > work_queue;
+	vector<gaussian>::size_type next_pair = 0;
+	vector<pool_job> finished;
+	// Failures in a row for each dataset, and how many of them will stop a search taking results as they arrive
+	vector<unsigned int> failures_in_a_row(punch.size(),0);
+	vector<gaussian>::size_type failures_allowed = 0;
+
 	// So this will loop until we get the step size small enough or we just run too many calculations
-	while (!ecp_searcher->get_converged() &&
-		   (chemshell_counter < chemshell_counter_max))
+	// Anything still running at that point is collected before stopping
+	while ((!ecp_searcher->get_converged() &&
+		(chemshell_counter < chemshell_counter_max)) ||
+	       (next_pair < work_queue.size()) || (finished.size() > 0) || (job_pool->running() > 0))
 	{
-		vector<gaussian> ecps_to_test = ecp_searcher->get_ecps_to_test();
-		vector<gaussian> ecps_tested(ecps_to_test.size());
+		// Start afresh once nothing is left running
+		if ((next_pair == work_queue.size()) && (finished.size() == 0) && (job_pool->running() == 0))
+		{
+			for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
+			{
+				ecps_to_test_vector[i_punch].clear();
+				ecps_tested_vector[i_punch].clear();
+				from_history_vector[i_punch].clear();
+			}
+			screened.clear();
+			outstanding.clear();
+			work_queue.clear();
+			next_pair = 0;
+		}
+
+		// New ECPs are only taken on while the search is still going
+		vector<gaussian> ecps_to_test;
+
+		if (!ecp_searcher->get_converged() &&
+		    (chemshell_counter < chemshell_counter_max))
+		{
+			Trace_Span span("get_ecps_to_test","search");
+			ecps_to_test = ecp_searcher->get_ecps_to_test();
+		}
 
-		// Let's duplicate these structures for the varying number of punch templates we are testing
-		vector< vector<gaussian> > ecps_to_test_vector;
-		vector< vector<gaussian> > ecps_tested_vector;
-		ecps_to_test_vector.resize(punch.size());
-		ecps_tested_vector.resize(punch.size());
+		if (failures_allowed == 0)
+		{
+			failures_allowed = ecps_to_test.size();
+		}
+
+		// Assign values, after anything already handed out
+		const vector<gaussian>::size_type first = ecps_to_test_vector[0].size();
 
-		// Assign values
 		for (vector<gaussian>::size_type i_ecps = 0; i_ecps < ecps_to_test_vector.size(); i_ecps++)
 		{
-			ecps_to_test_vector[i_ecps] = ecps_to_test;
-			ecps_tested_vector[i_ecps].resize(ecps_to_test.size());
+			ecps_to_test_vector[i_ecps].insert(ecps_to_test_vector[i_ecps].end(),ecps_to_test.begin(),ecps_to_test.end());
+			ecps_tested_vector[i_ecps].resize(ecps_to_test_vector[i_ecps].size());
+			from_history_vector[i_ecps].resize(ecps_to_test_vector[i_ecps].size(),0);
 		}
+
+		screened.resize(ecps_to_test_vector[0].size(),false);
+		outstanding.resize(ecps_to_test_vector[0].size(),0);
 		
 		// Check history. If they've already been tested, put them in the results section
 		// For some reason I couldn't get find() to work here. Probably needs some attention in the long term
-		
+		double history_started = monotonic_seconds();
+
 		for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
 	        {
 
-	                // We are going to explicitly define a vector to show pulled from history
-        	        // With values set to 0 for false, 1 for true
- 	                vector<int> from_history(ecps_to_test_vector[i_punch].size(),0);
-
-        	        // Define a counter for failures
-	                unsigned int failures = 0;
+			vector<int> &from_history = from_history_vector[i_punch];
 	
 			// Loop through our ecps to test
-			for (vector<gaussian>::size_type a = 0; a < ecps_to_test_vector[i_punch].size(); a++)
+			for (vector<gaussian>::size_type a = first; a < ecps_to_test_vector[i_punch].size(); a++)
 			{
 
 				// Loop through the history file. We'll go in reverse order as most recent ecps will be at the back
@@ -1027,154 +1355,460 @@ int main (int argc, char * const argv[]) {
 				}
 			}
 
-			// This would be the start of our loop function to test current ecps
-			for (vector<gaussian>::size_type a = 0; a != ecps_to_test_vector[i_punch].size(); a++)
+		}
+
+		trace_span("history check","history",history_started,monotonic_seconds() - history_started);
+
+		// Skip any ECPs that the models of the history expect to be clearly worse than the best so far.
+		// Their predicted function is handed to the searcher, but they are treated as pulled from
+		// history so that they are neither run nor saved.
+		if (surrogate_screening && !outputs_only && (ecps_to_test.size() > 0))
+		{
+			Trace_Span span("surrogate screening","search");
+			vector< vector<double> > predicted(punch.size(),vector<double>(ecps_to_test.size(),0.0));
+			int candidates = 0;
+			int skipped = 0;
+
+			for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
+			{
+				surrogates[i_punch].fit(ecps_history[i_punch]->get_history());
+			}
+
+			for (vector<gaussian>::size_type a = 0; a < ecps_to_test.size(); a++)
 			{
-				// Check that we have not copied the result from history
-				if (from_history[a] != 1)
+				bool needed = false;
+				screened[first + a] = true;
+
+				for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
 				{
-					// This is going to be our carrier, and written directly to ecps_tested at the end
-					gaussian g = ecps_to_test_vector[i_punch][a]; 
+					if (from_history_vector[i_punch][first + a] == 1)
+					{
+						continue;
+					}
 
-					// Set marker to see if calculation runs ok
-					g.failed = false;
+					needed = true;
 
-					chemshell_counter++;
-					cout << spacer << endl;
-					print_chemshell_message(g,chemshell_counter,current_index);
+					if (!surrogates[i_punch].screen(ecps_to_test[a],&predicted[i_punch][a]))
+					{
+						screened[first + a] = false;
+						break;
+					}
+				}
 
-					// Create folder name for moving around results
-					string current_counter = "";
-					NumberToString(current_index,current_counter);
-	                		string current_folder = output_folder;
-        	        		current_folder += "_";
-					current_folder += current_counter;
+				if (!needed)
+				{
+					screened[first + a] = false;
+				}
+				else
+				{
+					candidates++;
 
-					// Write ECP and Punch file for this run 
-					if (!outputs_only)
+					if (screened[first + a])
 					{
-						outData = qm_program->get_ecp_template(g);
-						write_out_lines(ecp_file,&outData,!dry_run);
-				
-						outData = punch[i_punch].get_punch_template();
-						write_out_lines(punch_file,&outData,!dry_run);
+						skipped++;
 					}
+				}
+			}
+
+			// Always run something, so the search cannot be steered by predictions alone
+			if ((skipped > 0) && (skipped == candidates))
+			{
+				vector<gaussian>::size_type keep = ecps_to_test.size();
+				double keep_function = 0;
 
-					// Run Chemshell QM/MM calculator, using predefined setup.
-					// command_line="aprun -n $NPROC -N $NTASK chemsh.x " + chm_file; // We should softcode this; Done a bit for now
-					// Having processors and processors_per_node in the code means we can parallelise easily
-					if (!dry_run && !outputs_only)
+				for (vector<gaussian>::size_type a = 0; a < ecps_to_test.size(); a++)
+				{
+					if (screened[first + a])
 					{
-						string command_line = "";
-						if (processors > 0 && processors_per_node > 0)
+						double summed = 0;
+
+						for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
 						{
-							command_line = "aprun -n " + NumberToString(processors) + " -N " + NumberToString(processors_per_node) + " " + executable + " " + chm_file;
+							summed += predicted[i_punch][a];
 						}
-						else
+
+						if ((keep == ecps_to_test.size()) || (summed < keep_function))
 						{
-							command_line = executable + " " + chm_file;
+							keep = a;
+							keep_function = summed;
 						}
-						cout << "Running Chemshell" << endl;
-						cout << spacer << endl;
-						system(command_line.c_str());
-						cout << spacer << endl;
-						cout << endl;
 					}
+				}
 
-					// Read in data from output once finished. We need a check here in case something hasn't converged.
-					// Check if punch_output is different size to punch_template. This will only be performed after the first calculation
-					if (outputs_only)
-					{
+				screened[first + keep] = false;
+				skipped--;
+			}
 
-						// In this case we should need to reread, as the calculation-used punch file will be the template
-						punch_output_check = true;
-					}
-					else if (!punch_output_check)
-					{
-						// We are going to reread the punch output file and check nothing has changed
-						// In a defected system this will have changed.
-						punch[i_punch].compare(read_in_lines(punch_file, false));
-						
-						// Let's check if the punch output is different from the original
-						// Note! If the system in question has a defect this will introduce errors.
-						punch_output_check = true;
-					}
-			
-					// Read in gradients to see if they are defined
-					g.regions = digest_gradients(read_in_lines(gradient_output_file, outputs_only),punch[i_punch].get_total_centres(),
-  								     punch[i_punch].get_centre_regions_total(),punch[i_punch].get_centre_regions(),absolute_gradients);
-				
-					if ((g.regions[0].gnorm_max == 0) &&
-						(g.regions[1].gnorm_max == 0) &&
-						(g.regions[2].gnorm_max == 0) &&
-						(g.regions[3].gnorm_max == 0) &&
-						(g.regions[4].gnorm_max == 0))
+			for (vector<gaussian>::size_type a = 0; a < ecps_to_test.size(); a++)
+			{
+				if (!screened[first + a])
+				{
+					continue;
+				}
+
+				for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
+				{
+					if (from_history_vector[i_punch][first + a] != 1)
 					{
-						g.failed = true;
+						ecps_tested_vector[i_punch][first + a] = ecps_to_test_vector[i_punch][first + a];
+						ecps_tested_vector[i_punch][first + a].failed = false;
+						ecps_tested_vector[i_punch][first + a].function = predicted[i_punch][a];
+						from_history_vector[i_punch][first + a] = 1;
+						surrogate_skipped++;
 					}
-			
-					// Now to calculate electronic information from DFT output
-					g = qm_program->digest_electronic(read_in_lines(qm_output_file, outputs_only), g, punch[i_punch].get_region_1_anions(), punch[i_punch].get_region_1_species());
-				
-					// Copy output to temporary location in case we want to check it.
-					// This should be optional otherwise we'll end up with lots of datafiles.
-					if (!dry_run && !outputs_only)
-					{
-						// Now lets create the command line to move files around
-						string command_line = " mkdir ";
-						command_line += current_folder;
-						command_line += " ; cp ";
-						command_line += qm_type;
-						command_line += "* ";
-						command_line += current_folder;
-						command_line += " ; mv gulp* hybrid* ";
-						command_line += ecp_file;
-						command_line += " ";
-						command_line += gradient_output_file;
-						command_line += " *nergy *xyz ";
-						command_line += current_folder;
-						// cout << command_line << endl;
-						system(command_line.c_str());
-					}	
-			
-					// Calculate function value
-					if (!g.failed && g.function != 888888)
-					{
+				}
+			}
 
-						// Create a temporary vector to hold the DMA spreads
-						vector<double> temp(g.dma_spread.size());
-						for (vector<double>::size_type i = 0; i < temp.size(); i++)
-						{
-							temp[i] = g.dma_spread[i].spread;
-						}
+			if (surrogate_report)
+			{
+				cout << "Surrogate model skipped " << skipped << " of the " << candidates << " ECPs needing calculation" << endl;
+			}
+		}
+
+		// Queue up everything that wasn't found in history
+		// ECPs with nothing to calculate are done already
+		vector< vector<gaussian>::size_type > completed;
+
+		for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
+		{
+			for (vector<gaussian>::size_type a = first; a < ecps_to_test_vector[i_punch].size(); a++)
+			{
+				if (from_history_vector[i_punch][a] != 1)
+				{
+					work_queue.push_back(make_pair(i_punch,a));
+					outstanding[a]++;
+				}
+			}
+		}
+
+		for (vector<gaussian>::size_type a = first; a < outstanding.size(); a++)
+		{
+			if (outstanding[a] == 0)
+			{
+				completed.push_back(a);
+			}
+		}
+
+		// This would be the start of our loop function to test current ecps
+		// Calculations are handed to the job pool, and digested in the order they finish
+		time_t calculations_started = time(NULL);
+		int calculations_running = -1;
+		int calculations_digested = 0;
+
+		while (true)
+		{
+			// Fill any free slots in the pool
+			while ((next_pair < work_queue.size()) && !job_pool->full())
+			{
+				vector<gaussian>::size_type i_punch = work_queue[next_pair].first;
+				vector<gaussian>::size_type a = work_queue[next_pair].second;
+
+				// This is going to be our carrier, and written directly to ecps_tested at the end
+				gaussian g = ecps_to_test_vector[i_punch][a]; 
+
+				// Set marker to see if calculation runs ok
+				g.failed = false;
+				g.failure_reason = "";
+
+				// Add index to reflect this calculation
+				g.index = current_index;
+				current_index++;
+
+				chemshell_counter++;
+				cout << spacer << endl;
+				print_chemshell_message(g,chemshell_counter,g.index);
+
+				ecps_tested_vector[i_punch][a] = g;
+
+				pool_job job;
+				job.tag = next_pair;
+				next_pair++;
+				job.index = g.index;
+				job.folder = "";
+
+				// Each calculation gets its own folder when ChemShell is actually run
+				if (!dry_run && !outputs_only)
+				{
+					Trace_Span span("create scratch","files",g.index);
+					job.folder = job_pool->create_scratch(g.index);
+				}
+
+				// Write ECP and Punch file for this run 
+				if (!outputs_only)
+				{
+					vector<string> punchData;
+					double rendered = monotonic_seconds();
+					outData = qm_program->get_ecp_template(g);
+					punchData = punch[i_punch].get_punch_template();
 
-						// Calculate function
-						g.function = func_calc->calculate_function(g.regions[0].gnorm, g.regions[1].gnorm, g.regions[2].gnorm, g.orbital_spread[0].spread, g.HOMO_value, g.LUMO_value, temp, i_punch);
+					double written = monotonic_seconds();
+					trace_span("render templates","templates",rendered,written - rendered,g.index);
+					write_out_lines(in_folder(job.folder,ecp_file),&outData,!dry_run);
+					write_out_lines(in_folder(job.folder,punch_file),&punchData,!dry_run);
+					trace_span("write inputs","files",written,monotonic_seconds() - written,g.index);
+				}
 
-						// Print the function value to screen
-						cout << "Function value : " << g.function << endl;
-						cout << endl;
+				// Run Chemshell QM/MM calculator, using predefined setup.
+				// command_line="aprun -n $NPROC -N $NTASK chemsh.x " + chm_file; // We should softcode this; Done a bit for now
+				// Having processors and processors_per_node in the code means we can parallelise easily
+				if (!dry_run && !outputs_only)
+				{
+					// The program is run directly, so the arguments are split here rather than by a shell
+					if (processors > 0 && processors_per_node > 0)
+					{
+						job.arguments.push_back("aprun");
+						job.arguments.push_back("-n");
+						job.arguments.push_back(NumberToString(processors));
+						job.arguments.push_back("-N");
+						job.arguments.push_back(NumberToString(processors_per_node));
 					}
-					// If not set the function value arbitrarily high
-					else 
+					Tokenize(executable,job.arguments);
+					job.arguments.push_back(chm_file);
+
+					// Follow the QM output, so a calculation that is going wrong can be stopped before ChemShell gives up
+					if (watch_output)
 					{
-						g.function = 888888;
-						failures++;
+						job.watcher = Output_Watcher(qm_program,in_folder(job.folder,qm_output_file));
 					}
+
+					cout << "Running Chemshell in " << job.folder << endl;
+					cout << spacer << endl;
+					Trace_Span span("launch","jobs",g.index);
+					job_pool->launch(job);
+				}
+				else
+				{
+					finished.push_back(job);
+				}
+			}
+
+			if (calculations_running < 0)
+			{
+				calculations_running = job_pool->running();
+			}
+
+			// Searches taking results as they arrive go back as soon as any ECP is done
+			if (asynchronous && (completed.size() > 0))
+			{
+				break;
+			}
+
+			// Everything has been launched and collected
+			if ((finished.size() == 0) && (job_pool->running() == 0))
+			{
+				break;
+			}
+
+			// Pick up the next calculation to finish
+			pool_job job;
+			if (finished.size() > 0)
+			{
+				job = finished[0];
+				finished.erase(finished.begin());
+			}
+			else
+			{
+				double waited = monotonic_seconds();
+				job = job_pool->wait_for_any();
+				trace_span("wait for calculation","jobs",waited,monotonic_seconds() - waited);
+				trace_calculation("qm run",job.launch_time,job.status.wall_time,job.index,Process_Runner::describe(job.status));
+				cout << spacer << endl;
+				cout << "Chemshell finished in " << job.folder << " (" << Process_Runner::describe(job.status) << ")" << endl;
+			}
+
+			vector<gaussian>::size_type i_punch = work_queue[job.tag].first;
+			gaussian g = ecps_tested_vector[i_punch][work_queue[job.tag].second];
+
+			// A calculation that crashed or was stopped cannot be trusted, whatever it left behind
+			if (!dry_run && !outputs_only && !Process_Runner::succeeded(job.status))
+			{
+				cout << "Chemshell did not complete successfully. Marking calculation as failed" << endl;
+				g.failed = true;
+
+				if (job.status.aborted)
+				{
+					g.failure_reason = job.watcher.get_reason();
+					calculations_stopped++;
+					stopped_seconds += job.status.wall_time;
+				}
+				else
+				{
+					g.failure_reason = "Chemshell " + Process_Runner::describe(job.status);
+				}
+			}
+
+			// Create folder name for moving around results
+			string current_counter = "";
+			NumberToString(g.index,current_counter);
+                	string current_folder = output_folder;
+        	        	current_folder += "_";
+			current_folder += current_counter;
+
+			// Read in data from output once finished. We need a check here in case something hasn't converged.
+			// Check if punch_output is different size to punch_template. This will only be performed after the first calculation
+			if (outputs_only)
+			{
+
+				// In this case we should need to reread, as the calculation-used punch file will be the template
+				punch_output_check = true;
+			}
+			else if (!punch_output_check)
+			{
+				// We are going to reread the punch output file and check nothing has changed
+				// In a defected system this will have changed.
+				Trace_Span span("punch check","parse",g.index);
+				punch[i_punch].compare(in_folder(job.folder,punch_file), false);
 				
-					// Add index to reflect this calculation
-					g.index = current_index;
-					current_index++;
-				
-					// Copy this complete ECP to ECP_tested
-					ecps_tested_vector[i_punch][a] = g;
+				// Let's check if the punch output is different from the original
+				// Note! If the system in question has a defect this will introduce errors.
+				punch_output_check = true;
+			}
+	
+			// Read in gradients to see if they are defined
+			double parsed = monotonic_seconds();
+			g.regions = digest_gradients(in_folder(job.folder,gradient_output_file),punch[i_punch].get_total_centres(),
+  							     punch[i_punch].get_centre_regions_total(),punch[i_punch].get_centre_regions(),absolute_gradients,outputs_only);
+			trace_span("gradient parse","parse",parsed,monotonic_seconds() - parsed,g.index);
+		
+			if ((g.regions[0].gnorm_max == 0) &&
+				(g.regions[1].gnorm_max == 0) &&
+				(g.regions[2].gnorm_max == 0) &&
+				(g.regions[3].gnorm_max == 0) &&
+				(g.regions[4].gnorm_max == 0))
+			{
+				g.failed = true;
+
+				if (g.failure_reason.size() == 0)
+				{
+					g.failure_reason = "No gradients in " + gradient_output_file;
+				}
+			}
+		
+			// Now to calculate electronic information from DFT output
+			parsed = monotonic_seconds();
+			g = qm_program->digest_electronic(in_folder(job.folder,qm_output_file), g, punch[i_punch].get_region_1_anions(), punch[i_punch].get_region_1_species(), outputs_only);
+			trace_span("electronic parse","parse",parsed,monotonic_seconds() - parsed,g.index);
+		
+			// Copy output to temporary location in case we want to check it.
+			// This should be optional otherwise we'll end up with lots of datafiles.
+			if (!dry_run && !outputs_only)
+			{
+				Trace_Span span("archive","files",g.index);
+
+				// Move the results out of scratch before it is removed
+				string destination = job_pool->get_launch_folder() + "/" + current_folder;
+				vector<string> patterns;
+				patterns.push_back(qm_type + "*");
+				archive_files(job.folder,destination,patterns,false);
+
+				patterns.clear();
+				patterns.push_back("gulp*");
+				patterns.push_back("hybrid*");
+				patterns.push_back(ecp_file);
+				patterns.push_back(gradient_output_file);
+				patterns.push_back("*nergy");
+				patterns.push_back("*xyz");
+				patterns.push_back("chemshell.stdout");
+				archive_files(job.folder,destination,patterns,true);
+
+				// Everything worth keeping has been moved
+				job_pool->remove_scratch(job.folder);
+			}	
+	
+			// Calculate function value
+			if (!g.failed && g.function != 888888)
+			{
+
+				// Create a temporary vector to hold the DMA spreads
+				vector<double> temp(g.dma_spread.size());
+				for (vector<double>::size_type i = 0; i < temp.size(); i++)
+				{
+					temp[i] = g.dma_spread[i].spread;
+				}
+
+				// Calculate function
+				Trace_Span span("objective","scoring",g.index);
+				g.function = func_calc->calculate_function(g.regions[0].gnorm, g.regions[1].gnorm, g.regions[2].gnorm, g.orbital_spread[0].spread, g.HOMO_value, g.LUMO_value, temp, i_punch);
+
+				// Print the function value to screen
+				cout << "Function value : " << g.function << endl;
+				cout << endl;
+			}
+			// If not set the function value arbitrarily high
+			else 
+			{
+				g.function = 888888;
+
+				if (g.failure_reason.size() == 0)
+				{
+					g.failure_reason = "No electronic structure in " + qm_output_file;
+				}
+
+				cout << "Calculation failed : " << g.failure_reason << endl;
+				cout << endl;
+			}
+		
+			// Copy this complete ECP to ECP_tested
+			vector<gaussian>::size_type a = work_queue[job.tag].second;
+			ecps_tested_vector[i_punch][a] = g;
+			calculations_digested++;
+
+			// The ECP is done once it has been calculated for every dataset
+			outstanding[a]--;
+			if (outstanding[a] == 0)
+			{
+				completed.push_back(a);
+			}
+		}
+
+		// Keep track of the time each calculation takes, allowing for those run side by side
+		if (calculations_digested > 0)
+		{
+			calculation_seconds += difftime(time(NULL),calculations_started) * max(calculations_running,1);
+			calculations_timed += calculations_digested;
+		}
+
+		// Nothing is running and the searcher has nothing more to test
+		if (asynchronous && (completed.size() == 0))
+		{
+			cout << "The search has no more ECPs to test" << endl;
+			break;
+		}
+
+		// Gather up the ECPs which are done, in the order they were handed out
+		sort(completed.begin(),completed.end());
+		vector< vector<gaussian> > completed_vector(punch.size());
+		vector< vector<int> > completed_from_history(punch.size());
+		vector<bool> completed_screened;
+
+		for (vector<gaussian>::size_type i = 0; i < completed.size(); i++)
+		{
+			for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
+			{
+				completed_vector[i_punch].push_back(ecps_tested_vector[i_punch][completed[i]]);
+				completed_from_history[i_punch].push_back(from_history_vector[i_punch][completed[i]]);
+			}
+			completed_screened.push_back(screened[completed[i]]);
+			outstanding[completed[i]] = -1;
+		}
+
+		// All calculations for these ECPs are done, so each dataset can now be ranked and saved
+		for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
+	        {
+			vector<int> &from_history = completed_from_history[i_punch];
+			unsigned int failures = 0;
+
+			// Count the failures, including any pulled in from history
+			for (vector<gaussian>::size_type i = 0; i < completed_vector[i_punch].size(); i++)
+			{
+				if (completed_vector[i_punch][i].failed || (completed_vector[i_punch][i].function == 888888))
+				{
+					failures++;
+					failures_in_a_row[i_punch]++;
 				}
 				else
 				{
-					if (ecps_tested_vector[i_punch][a].failed || ecps_tested_vector[i_punch][a].function == 888888)
-					{
-						failures++;
-					}
+					failures_in_a_row[i_punch] = 0;
 				}
 			}
 		
@@ -1186,25 +1820,25 @@ int main (int argc, char * const argv[]) {
 			#define DELTA (0.000000001)
 			// We've calculated all the function values, so now we just need to rank all of them
 			// We'll do this in a simple double loop, as it should be a quick calculation
-			for (vector<gaussian>::size_type i = 0; i < ecps_tested_vector[i_punch].size(); i++)
+			for (vector<gaussian>::size_type i = 0; i < completed_vector[i_punch].size(); i++)
 			{
 				// Check if calculation failed
-				if (ecps_tested_vector[i_punch][i].failed)
+				if (completed_vector[i_punch][i].failed)
 				{
 					// If so it's rank is maximum possible
-					ecps_tested_vector[i_punch][i].rank = ecps_tested_vector[i_punch].size();
+					completed_vector[i_punch][i].rank = completed_vector[i_punch].size();
 				}
 				else
 				{
-					ecps_tested_vector[i_punch][i].rank = 1;
-					for (vector<gaussian>::size_type j = 0; j < ecps_tested_vector[i_punch].size(); j++)
+					completed_vector[i_punch][i].rank = 1;
+					for (vector<gaussian>::size_type j = 0; j < completed_vector[i_punch].size(); j++)
 					{
 						// Originally this had an a != i clause, but that shouldn't make a difference as it >, not >= clause
-						if ((ecps_tested_vector[i_punch][i].function - ecps_tested_vector[i_punch][j].function) > DELTA)
+						if ((completed_vector[i_punch][i].function - completed_vector[i_punch][j].function) > DELTA)
 						{
 							// Increment rank number if the function of another gaussian
 							// is lower, and we are not looking at the same gaussian
-							ecps_tested_vector[i_punch][i].rank++;
+							completed_vector[i_punch][i].rank++;
 						}
 					}
 				}
@@ -1214,32 +1848,60 @@ int main (int argc, char * const argv[]) {
 			if (!outputs_only)
 			{
 				// Now we have everything ranked lets append to the output file
-				update_log_file(log_output_files[i_punch],ecps_tested_vector[i_punch],!dry_run);
+				// Predictions from the surrogate model are left out, as they were never calculated
+				vector<gaussian> logged;
+				for (vector<gaussian>::size_type i = 0; i < completed_vector[i_punch].size(); i++)
+				{
+					if (!completed_screened[i])
+					{
+						logged.push_back(completed_vector[i_punch][i]);
+					}
+				}
+				double logging = monotonic_seconds();
+				update_log_file(log_output_files[i_punch],logged,!dry_run);
 			
 				// This needs to be done on every loop, as otherwise restart won't work.
-				update_regions_file(regions_output_file,ecps_tested_vector[i_punch],from_history,!dry_run);
+				update_regions_file(regions_output_file,completed_vector[i_punch],from_history,!dry_run);
+				trace_span("write logs","logs",logging,monotonic_seconds() - logging);
 
 				// Print to screen to check failures counter
-				cout << failures << " of the " << ecps_tested.size() << " " << qm_program->type() << " calculations have failed." << endl;
+				cout << failures << " of the " << completed.size() << " " << qm_program->type() << " calculations have failed." << endl;
 			
-				if (!dry_run && (failures == ecps_tested_vector[i_punch].size()))
+				// When results come back as they arrive, a first batch's worth of failures in a row counts as all
+				if (!dry_run &&
+				    ((!asynchronous && (failures == completed_vector[i_punch].size())) ||
+				     (asynchronous && (failures_in_a_row[i_punch] >= failures_allowed))))
 	        	        // All calculations have failed so we need to exit otherwise we're wasting CPU time
 				{
 					string error = "All of the "; 
 	                                error += qm_program->type();
         	                        error += " calculations have failed! Quiting.";
 					cout << error << endl;
+					// Calculations for other ECPs may still be running, and would outlive us
+					job_pool->stop_all();
 					critical_error(true);
 				}
 			
 				// Save any results from the post calculation strip down. This should be placed in "history" file so we can look at previous results
 				// Due to the nature of this search, the history will be unordered. But that shouldn't be to big a problem as we won't be running lots of calculations
-				ecps_history[i_punch]->append(ecps_tested_vector[i_punch],from_history);
+				Trace_Span span("checkpoint","restart");
+				ecps_history[i_punch]->append(completed_vector[i_punch],from_history);
 
-                                //Update the binary file as well with new history (Append does not work nicely at present...)
+                                // Update the restart journal as well, adding just the new entries
 				if (ecps_history[i_punch]->get_number_of_entries_last_added() > 0)
 				{
-                                	write_out_binary(log_output_files[i_punch]+".restart",ecps_history[i_punch]->get_history(),!dry_run);
+					// Compact once the journal has doubled since it was last written whole,
+					// so the cost of compacting stays in proportion to what was appended
+					journal_appended[i_punch] += ecps_history[i_punch]->get_number_of_entries_last_added();
+					bool compact = (journal_appended[i_punch] >= max(journal_compacted[i_punch],(vector<gaussian>::size_type) 100));
+
+                                	if (compact || !append_to_journal(log_output_files[i_punch]+".restart",ecps_history[i_punch]->get_last_added(),!dry_run))
+					{
+						// Either it is time to compact, or the new entries don't fit the records of the journal, so start it again
+                                		write_out_journal(log_output_files[i_punch]+".restart",ecps_history[i_punch]->get_history(),!dry_run);
+						journal_compacted[i_punch] = ecps_history[i_punch]->size();
+						journal_appended[i_punch] = 0;
+					}
 				}
 			}
 		}
@@ -1248,15 +1910,15 @@ int main (int argc, char * const argv[]) {
 		// We need to firstly work out which is the number_one_ranked overall!
 		if (!outputs_only)
 		{
-			vector<int> summed_ranks(ecps_tested.size(),0);
-			vector<double> summed_functions(ecps_tested.size(),0.0);
+			vector<int> summed_ranks(completed.size(),0);
+			vector<double> summed_functions(completed.size(),0.0);
 
 			for (vector<gaussian>::size_type i_punch = 0; i_punch < punch.size(); i_punch++)
                 	{
-				for (vector<gaussian>::size_type i = 0; i < ecps_tested_vector[i_punch].size(); i++)
+				for (vector<gaussian>::size_type i = 0; i < completed_vector[i_punch].size(); i++)
                         	{
-					summed_ranks[i] += ecps_tested_vector[i_punch][i].rank;
-					summed_functions[i] += ecps_tested_vector[i_punch][i].function;
+					summed_ranks[i] += completed_vector[i_punch][i].rank;
+					summed_functions[i] += completed_vector[i_punch][i].function;
 				}
 			}
 			
@@ -1264,7 +1926,7 @@ int main (int argc, char * const argv[]) {
 			int number_one_ranked = 0;
 			
 			// We've got all the summed ranks and functions, now to find the best.
-			for (vector<gaussian>::size_type i = 0; i < ecps_tested.size(); i++)
+			for (vector<gaussian>::size_type i = 0; i < completed.size(); i++)
 			{
 				//cout << i << " " << number_one_ranked << endl;
 				cout << endl;
@@ -1291,8 +1953,12 @@ int main (int argc, char * const argv[]) {
 			cout << "Number one ranked ECP: " << number_one_ranked << endl;
 			cout << endl;
 			
-			ecp_searcher->set_ecps_tested(ecps_tested_vector[0],number_one_ranked);
+			Trace_Span span("set_ecps_tested","search");
+			ecp_searcher->set_ecps_tested(completed_vector[0],number_one_ranked);
 		}
+
+		// Keep the trace on disk in step with the logs
+		trace_flush();
 	}
 	
 	// Confirm we've converged
@@ -1310,8 +1976,28 @@ int main (int argc, char * const argv[]) {
 			cout << "Convergence achieved" << endl;
 			cout << endl;	
 		}
-		
+
+		if (watch_output)
+		{
+			cout << calculations_stopped << " " << qm_program->type() << " calculations were stopped early, ";
+			cout << "after " << stopped_seconds << " seconds between them" << endl;
+			cout << endl;
+		}
+
+		if (surrogate_report)
+		{
+			cout << "Surrogate model skipped " << surrogate_skipped << " " << qm_program->type() << " calculations, ";
+			cout << "alongside the " << calculations_timed << " that were run" << endl;
+
+			if (calculations_timed > 0)
+			{
+				cout << "Estimated time saved: " << surrogate_skipped * calculation_seconds / calculations_timed << " seconds" << endl;
+			}
+			cout << endl;
+		}
 	}
 	
+	trace_close();
+
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,532 @@
+/*
+ *  @file Mock_Chemshell.cpp
+ *  fit_my_ecp
+ *
+ *  @brief Stand-in for chemsh.x, so the whole fitting driver can be run and profiled
+ *  without ChemShell or a QM code. It reads the ECP written for the calculation,
+ *  scores it with an analytic objective, and writes a GAMESS-UK or NWChem output
+ *  and a gradient punch file which get worse as the objective does.
+ *  Build with "make mock" and pass as the executable, e.g.
+ *  -e="./mock_chemsh -ef=ecp.in -pf=punch.in --latency=2 --failure_rate=0.1"
+ *
+ */
+
+#include <iostream>
+// Personal headers
+#include "Utils.h"
+#include "IO.h"
+#include "Punch.h"
+#include "Landscapes.h"
+#include "Synthetic_Outputs.h"
+
+using namespace std;
+
+// Weight of the gradients in each region, relative to region 1
+const double region_weights[5] = {1.0, 0.5, 0.1, 0.01, 0.01};
+// Added to the objective, so even the optimum has gradients that can be read
+const double objective_floor = 1.0e-3;
+// SCF cycles written for a calculation which converges, and for one which does not
+const int cycles_converged = 12;
+const int cycles_failing = 40;
+
+/*
+ Ways a calculation can go wrong
+ */
+enum mock_failure
+{
+	MOCK_NONE,
+	MOCK_DIVERGE,
+	MOCK_OSCILLATE,
+	MOCK_CRASH,
+	MOCK_NO_GRADIENT
+};
+
+/*
+ Everything the electronic structure is worked out from
+ */
+struct mock_result
+{
+	double objective;
+	// Objective squashed into [0,1), so orbitals keep their order however poor the ECP
+	double saturated;
+	double energy;
+	double HOMO;
+	double LUMO;
+	// Number of centres in region 1, which are treated as the QM cluster
+	int qm_centres;
+	int failure;
+};
+
+/*
+ Help function which prints to screen the options
+
+ No params
+ */
+void help()
+{
+	cout << "Usage: mock_chemsh [options] CHM_FILE" << endl;
+	cout << endl;
+	cout << "Stands in for chemsh.x. The CHM_FILE is accepted as ChemShell would be given it, but is not read" << endl;
+	cout << endl;
+	cout << "-h,--help   : Display this message" << endl;
+	cout << endl;
+	cout << "*** Character Values ***" << endl;
+	cout << endl;
+	cout << "-ef,--ecpfile=ECP_FILENAME              : ECP file written by fit_my_ecp for this calculation" << endl;
+	cout << "-pf,--punchfile=PUNCH_FILENAME          : Punch file written by fit_my_ecp for this calculation" << endl;
+	cout << "-qmo,--qmoutput=QUANTUM_OUTPUT_FILENAME : QM output to write. NWChem format if it starts with nwchem. Default: gamess1.out.1" << endl;
+	cout << "-go,--gradientoutput=GRADIENT_FILENAME  : Gradient output to write. Default: gradient" << endl;
+	cout << "--objective=sphere                      : Sum of squared relative distances from the optimum. Default" << endl;
+	cout << "            rosenbrock                  : Rosenbrock valley through the optimum" << endl;
+	cout << "            rastrigin                   : Sphere with a rippled surface of local minima" << endl;
+	cout << "--optimum=ECP_FILENAME                  : ECP file or template holding the values at the minimum. Default: every value 1.0" << endl;
+	cout << endl;
+	cout << "*** Numeric Values ***" << endl;
+	cout << endl;
+	cout << "--seed=NUMBER         : Seed mixed with the ECP to decide noise and failures. Default: 0" << endl;
+	cout << "--scale=NUMBER        : Region 1 gnorm average (a.u.) per unit of objective. Default: 0.01" << endl;
+	cout << "--noise=NUMBER        : Relative noise added to the objective. Default: 0" << endl;
+	cout << "--latency=NUMBER      : Mean wall clock seconds per calculation. Default: 0" << endl;
+	cout << "--failure_rate=NUMBER : Fraction of calculations which diverge, oscillate, crash or lose their gradients. Default: 0" << endl;
+}
+
+/*
+ Check a token is a plain number
+
+ @param[in] s Token
+ @param[in] integer True if the number must not have a decimal point
+ @return bool True if the whole token is a number
+ */
+bool is_number(const string &s, bool integer)
+{
+	if ((s.size() == 0) || (s.find_first_not_of(integer ? "+-0123456789" : "+-.0123456789eEdD") != string::npos))
+	{
+		return false;
+	}
+
+	double value;
+	return parse_number(s.data(),s.data()+s.size(),value);
+}
+
+/*
+ Pick the values out of an ECP file. Each primitive is a line of three numbers,
+ the power of r and then the coefficient and exponent in the order the QM code uses.
+ Templates are read the same way, as the exclamation marks are taken as spaces
+
+ @param[in] ecp_file Filename of the ECP
+ @return vector<double> Values in the order they appear
+ */
+vector<double> read_ecp_values(string ecp_file)
+{
+	vector<string> lines = read_in_lines(ecp_file);
+	vector<double> values;
+
+	for (vector<string>::size_type i = 0; i < lines.size(); i++)
+	{
+		vector<string> tokens;
+		Tokenize(lines[i],tokens,"! \n\t");
+
+		if ((tokens.size() == 3) && is_number(tokens[0],true) && is_number(tokens[1],false) && is_number(tokens[2],false))
+		{
+			values.push_back(StringToNumber<double>(tokens[1]));
+			values.push_back(StringToNumber<double>(tokens[2]));
+		}
+	}
+
+	return values;
+}
+
+/*
+ Score an ECP. Each value is measured relative to its optimum, so coefficients
+ and exponents of very different sizes count the same
+
+ @param[in] x ECP values
+ @param[in] optimum Values at the minimum, zero at which
+ @param[in] objective Name of the landscape
+ @return double Objective, never negative
+ */
+double calculate_objective(vector<double> x, vector<double> optimum, string objective)
+{
+	vector<double> d(x.size());
+
+	for (vector<double>::size_type i = 0; i < x.size(); i++)
+	{
+		d[i] = (optimum[i] != 0.0) ? (x[i] - optimum[i]) / fabs(optimum[i]) : x[i];
+	}
+
+	return calculate_landscape(objective,d);
+}
+
+/*
+ Hash the ECP file, so each ECP always gets the same noise and failures
+
+ @param[in] ecp_file Filename of the ECP
+ @param[in] seed User seed
+ @return int Negative seed, ready to start the random number generator
+ */
+int ecp_seed(string ecp_file, int seed)
+{
+	vector<string> lines = read_in_lines(ecp_file);
+	unsigned long hash = 2166136261UL ^ (unsigned long) seed;
+
+	for (vector<string>::size_type i = 0; i < lines.size(); i++)
+	{
+		for (string::size_type j = 0; j < lines[i].size(); j++)
+		{
+			hash = ((hash ^ (unsigned char) lines[i][j]) * 16777619UL) & 0xffffffffUL;
+		}
+	}
+
+	return -1 - (int) (hash % 100000000UL);
+}
+
+/*
+ SCF energy at a cycle, converging or failing as asked
+
+ @param[in] r Result being written
+ @param[in] cycle Cycle, counting from one
+ @return double Total energy
+ */
+double scf_energy(mock_result r, int cycle)
+{
+	if (r.failure == MOCK_DIVERGE)
+	{
+		return r.energy + 0.01 * pow(2.5,cycle) * ((cycle % 2 == 0) ? 1.0 : -1.0);
+	}
+	else if (r.failure == MOCK_OSCILLATE)
+	{
+		return r.energy + 0.05 * ((cycle % 2 == 0) ? 1.0 : -1.0);
+	}
+
+	return r.energy + 0.8 * pow(0.3,cycle);
+}
+
+/*
+ Orbital energies, lowest first. The deep lying region 1 orbitals spread out as the
+ objective gets worse, then come the valence orbitals up to the HOMO and the virtuals
+
+ @param[in] r Result being written
+ @param[out] occupied Number of doubly occupied orbitals
+ @return vector<double> Orbital energies (a.u.)
+ */
+vector<double> orbital_energies(mock_result r, int *occupied)
+{
+	const int core = r.qm_centres;
+	const int valence = 3 * r.qm_centres;
+	const int virtuals = 5;
+	const double spread = 0.02 * r.saturated + 1.0e-4;
+	vector<double> e;
+
+	for (int i = 0; i < core; i++)
+	{
+		e.push_back(-18.62 + ((core > 1) ? spread * i / (core - 1) : 0.0));
+	}
+
+	for (int i = 0; i < valence; i++)
+	{
+		e.push_back(-0.9 + (r.HOMO + 0.9) * (i + 1) / valence);
+	}
+
+	for (int i = 0; i < virtuals; i++)
+	{
+		e.push_back(r.LUMO + 0.05 * i);
+	}
+
+	*occupied = core + valence;
+
+	return e;
+}
+
+/*
+ Put together the QM output for a result
+
+ @param[in] r Result being written
+ @param[in] labels Label of each centre
+ @param[in] regions Region of each centre
+ @param[in] cycle_seconds Seconds per SCF cycle
+ @return synthetic_output What to write
+ */
+synthetic_output describe_output(mock_result r, vector<string> labels, vector<int> regions, double cycle_seconds)
+{
+	synthetic_output o;
+	const int cycles = (r.failure == MOCK_NONE || r.failure == MOCK_NO_GRADIENT) ? cycles_converged : cycles_failing;
+
+	o.title = "mock_chemsh stand-in";
+	for (int i = 1; i <= cycles; i++)
+	{
+		o.scf_energies.push_back(scf_energy(r,i));
+	}
+	o.energy = r.energy;
+	o.converged = ((r.failure != MOCK_DIVERGE) && (r.failure != MOCK_OSCILLATE));
+	o.crash_cycle = (r.failure == MOCK_CRASH) ? cycles / 2 : 0;
+	o.cycle_seconds = cycle_seconds;
+
+	int occupied = 0;
+	o.mo_energies.push_back(orbital_energies(r,&occupied));
+	o.occupied.push_back(occupied);
+
+	o.labels = labels;
+	o.regions = regions;
+	o.dma = true;
+	o.dma_spread = 0.2 * r.saturated + objective_floor;
+
+	return o;
+}
+
+/*
+ Size of the gradient on each centre, set by the objective and its region
+
+ @param[in] r Result being written
+ @param[in] regions Region of each centre
+ @param[in] scale Region 1 gnorm average per unit of objective
+ @return vector<double> Gradient sizes
+ */
+vector<double> gradient_sizes(mock_result r, vector<int> regions, double scale)
+{
+	vector<double> sizes(regions.size());
+
+	for (vector<int>::size_type i = 0; i < regions.size(); i++)
+	{
+		int region = max(1,min(regions[i],5));
+		sizes[i] = scale * region_weights[region-1] * (r.objective + objective_floor);
+	}
+
+	return sizes;
+}
+
+int main(int argc, char *argv[])
+{
+	string ecp_file = "";
+	string punch_file = "";
+	string qm_output_file = "";
+	string gradient_output_file = "";
+	string objective = "";
+	string optimum_file = "";
+	string chm_file = "";
+	int seed = 0;
+	double scale = -1;
+	double noise = 0.0;
+	double latency = 0.0;
+	double failure_rate = 0.0;
+
+	for (int argc_counter = 1; argc_counter < argc; argc_counter++)
+	{
+		string argv_string = argv[argc_counter];
+		string argv_variable = "";
+		string argv_value = "";
+		bool option = (argv_string[0] == '-');
+
+		// Remove leading hyphens, and separate value from parameter
+		while ((argv_string.size() > 0) && (argv_string[0] == '-'))
+		{
+			argv_string.erase(argv_string.begin());
+		}
+
+		size_t argv_splitter = argv_string.find_first_of('=');
+
+		if (argv_splitter != string::npos)
+		{
+			argv_variable = argv_string.substr(0,argv_splitter);
+			argv_value = argv_string.substr(argv_splitter+1);
+		}
+		else
+		{
+			argv_variable = argv_string;
+		}
+
+		if (cmpStr("help",argv_variable) || cmpStr("h",argv_variable))
+		{
+			help();
+			exit(EXIT_SUCCESS);
+		}
+		else if (!option)
+		{
+			chm_file = argv[argc_counter];
+		}
+		else if (cmpStr("ecpfile",argv_variable) || cmpStr("ef",argv_variable))
+		{
+			ecp_file = argv_value;
+		}
+		else if (cmpStr("punchfile",argv_variable) || cmpStr("pf",argv_variable))
+		{
+			punch_file = argv_value;
+		}
+		else if (cmpStr("qmoutput",argv_variable) || cmpStr("qmo",argv_variable))
+		{
+			qm_output_file = argv_value;
+		}
+		else if (cmpStr("gradientoutput",argv_variable) || cmpStr("go",argv_variable))
+		{
+			gradient_output_file = argv_value;
+		}
+		else if (cmpStr("objective",argv_variable))
+		{
+			objective = argv_value;
+		}
+		else if (cmpStr("optimum",argv_variable))
+		{
+			optimum_file = argv_value;
+		}
+		else if (cmpStr("seed",argv_variable))
+		{
+			StringToNumber(argv_value,seed);
+		}
+		else if (cmpStr("scale",argv_variable))
+		{
+			StringToNumber(argv_value,scale);
+		}
+		else if (cmpStr("noise",argv_variable))
+		{
+			StringToNumber(argv_value,noise);
+		}
+		else if (cmpStr("latency",argv_variable))
+		{
+			StringToNumber(argv_value,latency);
+		}
+		else if (cmpStr("failure_rate",argv_variable))
+		{
+			StringToNumber(argv_value,failure_rate);
+		}
+		else
+		{
+			cout << "Unrecognised input: " << argv[argc_counter] << endl;
+			help();
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if ((ecp_file.length() == 0) || (punch_file.length() == 0))
+	{
+		cout << "Both -ef and -pf are needed, to find the ECP and punch files written for this calculation" << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	if (chm_file.length() == 0)
+	{
+		cout << "No CHM_FILE given. Carrying on, as it is not read" << endl;
+	}
+
+	// Check defaults
+	if (qm_output_file.length() == 0)
+	{
+		qm_output_file = "gamess1.out.1";
+		cout << "Using default QM output: " << qm_output_file << endl;
+	}
+
+	if (gradient_output_file.length() == 0)
+	{
+		gradient_output_file = "gradient";
+		cout << "Using default gradient output: " << gradient_output_file << endl;
+	}
+
+	if (objective.length() == 0)
+	{
+		objective = "sphere";
+		cout << "Using default objective: " << objective << endl;
+	}
+	else if (!landscape_exists(objective))
+	{
+		cout << "Unrecognised objective: " << objective << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	if (scale <= 0.0)
+	{
+		scale = 0.01;
+		cout << "Using default scale: " << scale << endl;
+	}
+
+	// Read in this calculation
+	vector<double> values = read_ecp_values(ecp_file);
+
+	if (values.size() == 0)
+	{
+		cout << "No ECP values found in: " << ecp_file << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	vector<double> optimum(values.size(),1.0);
+
+	if (optimum_file.length() > 0)
+	{
+		optimum = read_ecp_values(optimum_file);
+
+		if (optimum.size() != values.size())
+		{
+			cout << "The optimum in " << optimum_file << " has " << optimum.size() << " values, but the ECP has " << values.size() << endl;
+			cout << "Critical Error" << endl;
+			exit(EXIT_FAILURE);
+		}
+	}
+	else
+	{
+		cout << "Using default optimum: 1.0 for every ECP value" << endl;
+	}
+
+	Punch punch;
+	punch.set_punch_template(read_in_lines(punch_file),"");
+	vector<int> regions = punch.get_centre_regions();
+	vector<string> labels = punch.get_centre_labels();
+
+	if (regions.size() == 0)
+	{
+		cout << "No centres found in: " << punch_file << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// Everything random follows from the ECP, so a repeated calculation gives the same answer
+	int random_seed = ecp_seed(ecp_file,seed);
+
+	mock_result r;
+	r.objective = calculate_objective(values,optimum,objective);
+	r.objective *= max(0.0,1.0 + noise * (2.0 * randomNumber(&random_seed) - 1.0));
+	r.saturated = r.objective / (1.0 + r.objective);
+	r.qm_centres = max(1,punch.get_centre_regions_total()[0]);
+	r.energy = -75.0 * r.qm_centres + 0.01 * r.saturated;
+	r.HOMO = -0.30 - 0.05 * r.saturated;
+	r.LUMO = 0.05 + 0.05 * r.saturated;
+	r.failure = MOCK_NONE;
+
+	if (randomNumber(&random_seed) < failure_rate)
+	{
+		r.failure = MOCK_DIVERGE + randomNumber(4,&random_seed);
+	}
+
+	const double wall = latency * (0.5 + randomNumber(&random_seed));
+	const int cycles = (r.failure == MOCK_NONE || r.failure == MOCK_NO_GRADIENT) ? cycles_converged : cycles_failing;
+
+	cout << "mock_chemsh: " << values.size() << " ECP values, " << objective << " objective " << r.objective << endl;
+
+	synthetic_output o = describe_output(r,labels,regions,wall / cycles);
+	bool completed;
+
+	if (cmpStr(qm_output_file.substr(0,6),"nwchem"))
+	{
+		// NWChem outputs are written without a DMA
+		o.dma = false;
+		completed = write_nwchem(qm_output_file,o);
+	}
+	else
+	{
+		completed = write_gamess_uk(qm_output_file,o);
+	}
+
+	if (!completed)
+	{
+		cout << "mock_chemsh: QM calculation failed" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	if (r.failure != MOCK_NO_GRADIENT)
+	{
+		write_gradients(gradient_output_file,gradient_sizes(r,regions,scale));
+	}
+
+	cout << "mock_chemsh: finished" << endl;
+
+	return 0;
+}
@@ -139,7 +139,8 @@ vector<string> Nwchem::get_ecp_template(gaussian g)
 		// However in NWCHEM the ecp template the order is exponent, coefficient.
 		
 		// Replace the value as needed
-		NumberToString(g.values[i].value,tokens[abs(g.values[i].type-1)+1]);
+		// Written in full, so the calculation runs on exactly the ECP the search asked for
+		NumberToString(g.values[i].value,tokens[abs(g.values[i].type-1)+1],round_trip_precision);
 		// This is plus one to offset the r factor at the start of each line
 		
 		// Now reconstruct string and submit back to outData
@@ -157,24 +158,18 @@ vector<string> Nwchem::get_ecp_template(gaussian g)
 }
 
 /*
- Decodes the NWChem output
+ Decodes the NWChem output. The file is read through once, a line at a time,
+ so it never needs to be held in memory.
  
- @param[in] nwchem_output Vector containing string output
+ @param[in] nwchem_output Filename of the NWChem output
  @param[in] g Current gaussian being investigated
  @param[in] r1_anions Number of anions in R1 
  @param[in] r1_species Array of types for R1 species
+ @param[in] critical Catch for critical errors to terminate program if the output is missing
  @return gaussian Updated information on the ECP
  */
-gaussian Nwchem::digest_electronic(vector<string> nwchem_output, gaussian g, int r1_anions, vector<string> r1_species)
+gaussian Nwchem::digest_electronic(string nwchem_output, gaussian g, int r1_anions, vector<string> r1_species, bool critical)
 {
-	// Zero all the counters we use
-	int MO_line_number = 0;
-        int DMA_line_number = 0;
-	int number_electrons = 0;
-        int alpha_electrons = 0;
-        int beta_electrons = 0;
-	int spin_counter = 0;
-        int spin_polarised = 0;
 	// Zero gaussian counters
 	//g.anion_max = -1000.0;
 	//g.anion_min = 1000.0;
@@ -205,107 +200,53 @@ gaussian Nwchem::digest_electronic(vector<string> nwchem_output, gaussian g, int
 	
 	if (!g.failed)
 	{
-		for (vector<string>::size_type i = 0; i < nwchem_output.size(); i++)
+		nwchem_state s;
+		Line_Reader reader(nwchem_output, critical);
+		line_view line;
+		// Reused for every line, so tokenising doesn't allocate
+		vector<line_view> tokens;
+
+		// Zero all the counters we use
+		s.line_number = 0;
+		s.wavefunction_line = -1;
+		s.number_electrons = 0;
+		s.alpha_electrons = 0;
+		s.beta_electrons = 0;
+		s.spin_polarised = 0;
+		s.spin_counter = 0;
+		s.MO_line_number = 0;
+		s.reading_MOs = false;
+		s.DMA_line_number = 0;
+		s.DMA_stage = DMA_NONE;
+		s.DMA_match = -1;
+		s.finished = false;
+
+		while (!s.finished && reader.next(&line))
 		{
-			vector<string> tokens;
-			Tokenize(nwchem_output[i],tokens,"= \n\t");
-			
-			if ((tokens.size() > 3) && MO_line_number == 0)
-			{
-				// We need to find this line and get the number of electrons
-				// Wavefunction type: closed shell. / spin polarized (one only)
-				// Or such like as it appears before the MOs. Then round to nearest integer, as it is not explicitly defined
-				// We only need to do this if number of electrons isn't defined, as it shouldn't change
-				if (number_electrons == 0)
-				{
-					//if (cmpStr(tokens[0],"No.") &&
-					//	cmpStr(tokens[1],"of") &&
-					//	cmpStr(tokens[2],"electrons") &&
-					//	cmpStr(tokens[3],":")) 
-					if (cmpStr(tokens[0],"Wavefunction") &&
-					    cmpStr(tokens[1],"type:"))
-					{
-                                                if (cmpStr(tokens[2],"spin") &&
-                                                    cmpStr(tokens[3],"polarized."))
-						{
-							spin_polarised = 1;
-							//cout << "Spin Polarised" << endl;
-						}
-						// Now lets gather all the other information in
-						tokens.clear();
-						Tokenize(nwchem_output[i+2],tokens,"= \n\t");
-
-						// Save number of electrons. This seems to work fine
-						StringToNumber(tokens[4],number_electrons);
-						//cout << "Number of Electrons " << number_electrons << endl;
-
-						// Lets force read the electrons in each channel here
-						// First up Alpha electrons
-						tokens.clear();
-                                                Tokenize(nwchem_output[i+3],tokens,"= \n\t");
-						StringToNumber(tokens[3],alpha_electrons);
-						//cout << "Alpha Electrons " << alpha_electrons << endl;
-
-						// And then Beta electrons
-						tokens.clear();
-						Tokenize(nwchem_output[i+4],tokens,"= \n\t");
-                                                StringToNumber(tokens[3],beta_electrons);
-						//cout << "Beta Electrons " << beta_electrons << endl;
-					}
-				}
-				else if (spin_polarised == 0)
-				{
-					// Setting i to nwchem_output gives us an exit route
-					// This is now disabled, and this process just returns i as is
-					i = digest_rhf(tokens, &nwchem_output, &MO_line_number, 
-								   &g, i, number_electrons);
-				}
-				else
-				{
-					// This is for unrestricted calculation
-					if (spin_counter == 0)
-					{
-						spin_counter = digest_uhf(tokens, &nwchem_output, &MO_line_number, 
-									   &g, i, alpha_electrons, spin_counter);
-
-						//cout << spin_counter << " " << MO_line_number << endl;
-	                                        if (spin_counter == 1)
-        	                                {
-                	                                MO_line_number = 0;
-                        	                }
-					}
-					else
-					{
-						spin_counter = digest_uhf(tokens, &nwchem_output, &MO_line_number,
-                                                                           &g, i, beta_electrons, spin_counter);
-						
-	                                        // If DMA is not needed this can be used
-        	                                //else if (spin_counter == 2)
-                	                        //{
-                        	                //       i = nwchem_output.size();
-                                	        //}
-					}
-				}
-			} 
-			// By checking the number of electrons we will only call this after
-			// we have made a decent way through the output
-			else if ((tokens.size() == 4 && number_electrons != 0))
-			{
-				// Now we are looking for distributed multipole analysis.
-                                i = digest_dma(tokens, &nwchem_output, &DMA_line_number, &g, i);
-			}
+			digest_line(line, &tokens, &s, &g);
+		}
+
+		// Anything still being read ran to the end of the file
+		if (s.reading_MOs)
+		{
+			finish_MOs(&s, &g);
+		}
+
+		if ((s.DMA_stage != DMA_NONE) && (s.DMA_stage != DMA_DONE))
+		{
+			finish_dma(&s, &g);
 		}
 		
 		// MOs were not found and read in
 		// We'll count this as failures
-		if (MO_line_number == 0)
+		if (s.MO_line_number == 0)
 		{
 			g.failed = true;
 			cout << "Critical Failure: Getting MOs" << endl;
 		}
 		
 		/* TO DO
-		if (DMA_line_number == 0)
+		if (s.DMA_line_number == 0)
 		{
 			cout << "Non-critical Failure: Getting DMA" << endl;	
 		}
@@ -360,447 +301,436 @@ gaussian Nwchem::digest_electronic(vector<string> nwchem_output, gaussian g, int
 }
 
 /*
- Method designed to take apart the restricted hartree-fock output from NWChem 
- 
- @param[in] tokens Current line contents
- @param[in/out] nwchem_output Vector of output content
- @param[in/out] MO_line_number The position in the file where the MOs start
- @param[in/out] g Updating gaussin ECP
- @param[in] i Current index in the nwchem_output
- @param[in] en Number of electrons
- 
- @return int Index for continued search
- */
-int Nwchem::digest_rhf(vector<string> tokens, vector<string> *nwchem_output, int *MO_line_number, 
-						  gaussian *g, int i, int en)
-{
-	/** This is the proceeding line from the outputs before we get the MOs
+ Check for the line that starts the MOs. For a closed shell calculation this is
 
                        DFT Final Molecular Orbital Analysis
                        ------------------------------------
 
- Vector    1  Occ=2.000000D+00  E=-1.862267D+01
-              MO Center=  2.8D+00,  2.8D+00,  8.4D+00, r^2= 5.7D-01
-   Bfn.  Coefficient  Atom+Function         Bfn.  Coefficient  Atom+Function
-  ----- ------------  ---------------      ----- ------------  ---------------
-   344      0.636973   13 O  s              343      0.433767   13 O  s
+ and for a spin polarised calculation
 
- Vector    2  Occ=2.000000D+00  E=-1.862264D+01
-              MO Center=  2.7D+00,  2.8D+00, -2.6D+00, r^2= 2.5D+00
-   Bfn.  Coefficient  Atom+Function         Bfn.  Coefficient  Atom+Function
-  ----- ------------  ---------------      ----- ------------  ---------------
-    64      0.627347    3 O  s               63      0.427213    3 O  s
-
-
-	 So we need to characterise this in the output **/
-	
-	// This will find the start of the MOs
-	if (cmpStr(tokens[0],"DFT") &&
-		cmpStr(tokens[1],"Final") &&
-		cmpStr(tokens[2],"Molecular") &&
-		cmpStr(tokens[3],"Orbital") &&
-		cmpStr(tokens[4],"Analysis"))
-	{
-		*MO_line_number = i + 3; // Skip forward to where MOs start
-  		double value = 0.0;
-		vector<double> MO_energy;
-		int last_MO_line_number = 0;
-		
-		// Different to Gamess-UK, these values aren't line after line.
-		// So let's get all the values into an new vector, and read them out from there.
-                for (vector<string>::size_type j = *MO_line_number; j < nwchem_output->size(); j++)
-                {
-			// cout << j << endl;
-			tokens.clear();
-			Tokenize(nwchem_output->at(j),tokens,"= \n\t");
-
-                        // cout << nwchem_output->at(j) << " " << tokens.size() << endl;
-			
-			if (tokens.size() > 4)
-			{
-				if (cmpStr(tokens[0],"Vector"))
-				{
-                	                // cout << "in" << endl;
-	                                last_MO_line_number = (int) j;
-					// cout << tokens[5] << endl;
-					replace(tokens[5].begin(),tokens[5].end(),'D','E');
-					//cout << tokens[5] << endl;
-					StringToNumber(tokens[5],value);
-					MO_energy.push_back(value);
-	
-					// cout << last_MO_line_number << "  " << MO_energy[MO_energy.size()-1] << endl;		
-				}
-			}
-                        
-			// cout << j << " " << nwchem_output->size() << endl;
-		}
-		
-		// Firstly lets work out the spread of Anion Orbitals 
-		g->orbital_spread[0].min = MO_energy[region_1_anion_offset];
-		
-		// Find Anion maximum
-                g->orbital_spread[0].max = MO_energy[region_1_anion_offset+(g->orbital_spread[0].quantity)-1];
-                
-		//cout << g->orbital_spread[0].min << " " << g->orbital_spread[0].max << " " << region_1_anion_offset << endl;
-		
-		g->orbital_spread[0].spread = g->orbital_spread[0].max - g->orbital_spread[0].min;
-		
-		// Lets work out the average of the Anion Orbital 
-		for (int a = region_1_anion_offset; a < (g->orbital_spread[0].quantity)+region_1_anion_offset; a++)
-		{
-			//cout << tokens[2] << " " << value << " " << r1_anions << endl;
-			g->orbital_spread[0].average += MO_energy[a];
-		}
-		g->orbital_spread[0].average /= g->orbital_spread[0].quantity;
-		
-		// Now lets set the HOMO and LUMO values
-		g->HOMO_value = MO_energy[(en/2)-1];
-		g->LUMO_value = MO_energy[(en/2)];
-		// And we're done! Now to print these an see if they are right....
-		// We'll do that outside the loop
+                    DFT Final Alpha Molecular Orbital Analysis
+                    ------------------------------------------
 
-		// Prior to DMA this was used. The use of DMA doubles the output_read process. Hey ho.	
-		// This will break us out of the loop now we have the information we want
-		// return nwchem_output->size();
+ with the same again for Beta.
 
-		return last_MO_line_number;
+ @param[in] tokens Current line contents
+ @param[in] spin_polarised 1 if looking for the Alpha/Beta header
+ @return bool True if this line is the header
+ */
+static bool is_MO_header(vector<line_view> *tokens, int spin_polarised)
+{
+	if (spin_polarised == 0)
+	{
+		return ((tokens->size() > 4) &&
+			cmpView(tokens->at(0),"DFT") &&
+			cmpView(tokens->at(1),"Final") &&
+			cmpView(tokens->at(2),"Molecular") &&
+			cmpView(tokens->at(3),"Orbital") &&
+			cmpView(tokens->at(4),"Analysis"));
 	}
-	
-	// No luck finding results, return i
-	return i;
+
+	return ((tokens->size() > 5) &&
+		cmpView(tokens->at(0),"DFT") &&
+		cmpView(tokens->at(1),"Final") &&
+		cmpView(tokens->at(3),"Molecular") &&
+		cmpView(tokens->at(4),"Orbital") &&
+		cmpView(tokens->at(5),"Analysis"));
 }
 
 /*
- Method designed to take apart the unrestricted hartree-fock output from NWChem 
- 
- @param[in] tokens Current line contents
- @param[in/out] nwchem_output Vector of output content
- @param[in/out] MO_line_number The position in the file where the MOs start
- @param[in/out] g Updating gaussin ECP
- @param[in] i Current index in the nwchem_output
- @param[in] en Number of electrons in this channel
- @param[in] spin_counter Check if we are doing alpha or beta
+ Take in one line of the NWChem output, and update what we know.
  
- @return int Index for continued search
+ @param[in] line Current line
+ @param[in/out] tokens Space to tokenise the line into
+ @param[in/out] s Where we are up to in the output
+ @param[in/out] g Updating gaussian ECP
  */
-int Nwchem::digest_uhf(vector<string> tokens, vector<string> *nwchem_output, int *MO_line_number, 
-						  gaussian *g, int i, int en, int spin_counter)
+void Nwchem::digest_line(line_view line, vector<line_view> *tokens, nwchem_state *s, gaussian *g)
 {
-	// We should be able to recalculate this from the input files.
-	
-	/** This is the proceeding line from the outputs before we get the MOs
-                    DFT Final Alpha Molecular Orbital Analysis
-                    ------------------------------------------
-
- Vector   19  Occ=1.000000D+00  E=-1.873084D+01
-              MO Center=  2.8D+00,  2.8D+00,  2.8D+00, r^2= 1.5D-02
-   Bfn.  Coefficient  Atom+Function         Bfn.  Coefficient  Atom+Function
-  ----- ------------  ---------------      ----- ------------  ---------------
-   120      0.639008    5 O  s              119      0.435300    5 O  s
-	
-	The header for the Beta orbitals is:
-                     DFT Final Beta Molecular Orbital Analysis
-                     -----------------------------------------
-
- Vector   19  Occ=1.000000D+00  E=-1.873084D+01
-              MO Center=  2.8D+00,  2.8D+00,  2.8D+00, r^2= 1.5D-02
-   Bfn.  Coefficient  Atom+Function         Bfn.  Coefficient  Atom+Function
-  ----- ------------  ---------------      ----- ------------  ---------------
-   120      0.639008    5 O  s              119      0.435300    5 O  s
-
-	**/
-	
-	// This will find the start of the MOs
-	if (cmpStr(tokens[0],"DFT") &&
-		cmpStr(tokens[1],"Final") &&
-		cmpStr(tokens[3],"Molecular") &&
-		cmpStr(tokens[4],"Orbital") &&
-		cmpStr(tokens[5],"Analysis"))
-	{
-                *MO_line_number = i + 3; // Skip forward to where MOs start
-                double value = 0.0;
-                vector<double> MO_energy;
-
-                // Different to Gamess-UK, these values aren't line after line.
-                // So let's get all the values into an new vector, and read them out from there.
-                for (vector<string>::size_type j = *MO_line_number; j < nwchem_output->size(); j++)
-                {
-                        //cout << j << endl;
-                        tokens.clear();
-                        Tokenize(nwchem_output->at(j),tokens,"= \n\t");
-
-                        if (cmpStr(tokens[0],"Vector"))
-                        {
-				//cout << tokens[5] << endl;
-                                replace(tokens[5].begin(),tokens[5].end(),'D','E');
-                                //cout << tokens[5] << endl;
-                                StringToNumber(tokens[5],value);
-                                MO_energy.push_back(value);
-
-                                //cout << MO_line_number << "  " << MO_energy[MO_energy.size()-1] << endl;         
-                        }
-			else
-			{
-				// We need some check for when we reach the Beta MOs
-				// Let's use the same check as for entering this loop
-
-				if (cmpStr(tokens[0],"DFT") &&
-			                cmpStr(tokens[1],"Final") &&
-			                cmpStr(tokens[3],"Molecular") &&
-			                cmpStr(tokens[4],"Orbital") &&
-			                cmpStr(tokens[5],"Analysis"))
-			        {	
-					j = nwchem_output->size();
-				}
-			}
-                }
+	int i = s->line_number;
+	s->line_number++;
+
+	split_view(line,*tokens,"=");
+
+	// The electron counts follow two to four lines after the wavefunction type
+	//
+	//          Wavefunction type:  closed shell.
+	//          No. of atoms     :    10
+	//          No. of electrons :    80
+	//           Alpha electrons :    40
+	//            Beta electrons :    40
+	if (s->wavefunction_line >= 0)
+	{
+		int offset = i - s->wavefunction_line;
 
-                // Getting minimum value of Anion Orbitals
-                // Check if this is the first or second loop through
-                // And get spread inclusive of alpha and beta values
-		if (spin_counter == 0)
+		if ((offset == 2) && (tokens->size() > 4))
 		{
-                	g->orbital_spread[0].min = MO_energy[region_1_anion_offset];
+			// Save number of electrons. This seems to work fine
+			ViewToNumber(tokens->at(4),s->number_electrons);
 		}
-		else
+		else if ((offset == 3) && (tokens->size() > 3))
+		{
+			// Lets force read the electrons in each channel here
+			ViewToNumber(tokens->at(3),s->alpha_electrons);
+		}
+		else if (offset == 4)
 		{
-			// Compare to previous value
-			if (g->orbital_spread[0].min > MO_energy[region_1_anion_offset])
+			if (tokens->size() > 3)
 			{
-				// Save if lower
-				g->orbital_spread[0].min = MO_energy[region_1_anion_offset];
-
+				ViewToNumber(tokens->at(3),s->beta_electrons);
 			}
+			s->wavefunction_line = -1;
 		}
+	}
 
-                // Getting minimum value of Anion S Orbital 
-                // Check if this is the first or second loop through
-                // And get spread inclusive of alpha and beta values
-                if (spin_counter == 0)
-                {
-                        g->orbital_spread[0].max = MO_energy[region_1_anion_offset+(g->orbital_spread[0].quantity)-1];
-                }
-                else
-                {
-                        // Compare to previous value
-                        if (g->orbital_spread[0].max < MO_energy[region_1_anion_offset+(g->orbital_spread[0].quantity)-1])
-                        {
-                                // Save if higher
-                                g->orbital_spread[0].max = MO_energy[region_1_anion_offset+(g->orbital_spread[0].quantity)-1];
-                        }
-                }
-
-                g->orbital_spread[0].spread = g->orbital_spread[0].max - g->orbital_spread[0].min;
-
-                // Lets work out the average of the Anion Orbital 
-                for (int a = region_1_anion_offset; a < (g->orbital_spread[0].quantity)+region_1_anion_offset; a++)
-                {
-                        g->orbital_spread[0].average += MO_energy[a];
-                }
-
-                // Check spin_counter here to set anion_average
-                if (spin_counter == 1)
-                {
-                        // Divide through by number of alpha and beta electrons
-                        g->orbital_spread[0].average /= (g->orbital_spread[0].quantity*2);
-			//cout << g->orbital_spread[0].average << endl;
-                }
-
-		// Getting LUMO value
-		// Check if this is the first or second loop through
-		// We want the lowest value we can find
-		if (spin_counter == 0)
+	// Different to Gamess-UK, the MO values aren't line after line,
+	// so pick out the energy from each Vector line as we pass
+	//
+	// Vector    1  Occ=2.000000D+00  E=-1.862267D+01
+	//              MO Center=  2.8D+00,  2.8D+00,  8.4D+00, r^2= 5.7D-01
+	if (s->reading_MOs)
+	{
+		if ((tokens->size() > 5) && cmpView(tokens->at(0),"Vector"))
 		{
-			g->LUMO_value = MO_energy[en];
+			double value = 0.0;
+			ViewToNumber(tokens->at(5),value);
+			s->MO_energy.push_back(value);
 		}
-		else
+		else if ((s->spin_polarised != 0) && is_MO_header(tokens,s->spin_polarised))
 		{
-			// Compare to previous value
-			if (g->LUMO_value > MO_energy[en])
+			// We have reached the Beta MOs, so the Alpha are done
+			finish_MOs(s,g);
+		}
+	}
+
+	if (!s->reading_MOs && (s->MO_line_number == 0) && (tokens->size() > 3))
+	{
+		// We need to find this line and get the number of electrons
+		// Wavefunction type: closed shell. / spin polarized (one only)
+		// Or such like as it appears before the MOs. Then round to nearest integer, as it is not explicitly defined
+		// We only need to do this if number of electrons isn't defined, as it shouldn't change
+		if (s->number_electrons == 0)
+		{
+			if ((s->wavefunction_line < 0) &&
+			    cmpView(tokens->at(0),"Wavefunction") &&
+			    cmpView(tokens->at(1),"type:"))
 			{
-				// Save if higher
-				g->LUMO_value = MO_energy[en];
+				if (cmpView(tokens->at(2),"spin") &&
+				    cmpView(tokens->at(3),"polarized."))
+				{
+					s->spin_polarised = 1;
+				}
+				s->wavefunction_line = i;
 			}
 		}
-		
-		// Getting HOMO value
-		// Check if this is the first or second loop through
-		// We want the highest value we can find
-		if (spin_counter == 0)
+		else if (is_MO_header(tokens,s->spin_polarised))
 		{
-			g->HOMO_value = MO_energy[en-1];
+			s->MO_line_number = i + 3; // Where MOs start
+			s->MO_energy.clear();
+			s->reading_MOs = true;
 		}
-		else
+	}
+	// By checking the MOs have been found we will only look for DMA after
+	// we have made a decent way through the output
+	else if ((s->MO_line_number != 0) &&
+		 ((s->spin_polarised == 0) || (s->spin_counter > 0)))
+	{
+		if (s->DMA_stage == DMA_NONE)
 		{
-			// Compare to previous value
-			if (g->HOMO_value < MO_energy[en-1])
+			// Now we are looking for distributed multipole analysis.
+			// Keyphrase: distributed multipole analysis module
+			if ((tokens->size() == 4) &&
+			    cmpView(tokens->at(0),"distributed") &&
+			    cmpView(tokens->at(1),"multipole") &&
+			    cmpView(tokens->at(2),"analysis") &&
+			    cmpView(tokens->at(3),"module"))
 			{
-				// Save if higher
-				g->HOMO_value = MO_energy[en-1];
+				s->DMA_line_number = i + 16; // Skip forward to where the sites start
+				s->DMA_stage = DMA_START;
 			}
 		}
-		
-		// And we're done! Now to print these an see if they are right....
-		// We'll do that outside the loop
-		
-		// We need this to check if we have been through twice
-		// And picked alpha and beta values
-		
-		// Increment spin_counter
-		spin_counter++;
+		else if (s->DMA_stage != DMA_DONE)
+		{
+			// The DMA values are only separated by whitespace
+			split_view(line,*tokens);
+			digest_dma(tokens,s,g,i);
+		}
+	}
+
+	// Nothing more to be gained from the rest of the file
+	if ((s->DMA_stage == DMA_DONE) && !s->reading_MOs)
+	{
+		s->finished = true;
 	}
-	
-	// Haven't found all the results, return spin_counter
-	return spin_counter;
 }
 
 /*
- Method designed to take aprt the DMA output from NWChem 
+ Take in one line of the NWChem output while the calculation is still running.
+ The DFT module prints a line per SCF cycle such as
+  d= 0,ls=0.0,diis     1   -460.4563411917  4.42D+00  1.02D-01     1.7
+ and the cycle count going back to one marks the start of a new SCF.
+ A fatal error is printed in a banner, which always ends with the current input line
  
- @param[in] tokens Current line contents
- @param[in/out] nwchem_output Vector of output content
- @param[in/out] DMA_line_number The position in the file where the DMAs start
- @param[in/out] g Updating gaussin ECP
- @param[in] i Current index in the nwchem_output
- 
- @return int Index for continued search
+ @param[in] line Current line
+ @param[in/out] tokens Space to tokenise the line into
+ @param[in/out] w What has been seen of the SCF so far
  */
-int Nwchem::digest_dma(vector<string> tokens, vector<string> *nwchem_output, int *DMA_line_number,
-                                                  gaussian *g, int i)
+void Nwchem::watch_line(line_view line, vector<line_view> *tokens, scf_watch *w)
 {
-	// This needs testing for a UHF system
+	split_view(line,*tokens);
 
-	// Now we are looking for distributed multipole analysis.
-        // Keyphrase: distributed multipole analysis module
-        if (cmpStr(tokens[0],"distributed") &&
-            cmpStr(tokens[1],"multipole") &&
-            cmpStr(tokens[2],"analysis") &&
-            cmpStr(tokens[3],"module"))
-        {
+	if (tokens->size() == 0)
+	{
+		return;
+	}
 
-		// cout << "FOUND DMA" << endl;
+	if (view_contains(line,"failed to converge") ||
+	    view_contains(line,"There is an error in the input file"))
+	{
+		line_view message;
+		message.start = tokens->front().start;
+		message.length = tokens->back().start + tokens->back().length - message.start;
+		w->reason = "NWChem reports: " + view_to_string(message);
+		return;
+	}
+
+	if (view_contains(line,"current input line"))
+	{
+		w->reason = "NWChem stopped with an error";
+		return;
+	}
+
+	int cycle = 0;
+
+	if ((tokens->size() > 3) && cmpView(tokens->at(0),"d=") && ViewToNumber(tokens->at(2),cycle))
+	{
+		if (cycle == 1)
+		{
+			w->energies.clear();
+		}
+
+		double energy = 0.0;
+
+		if (!ViewToNumber(tokens->at(3),energy))
+		{
+			// Overflowed values are printed as stars
+			energy = HUGE_VAL;
+		}
+
+		w->energies.push_back(energy);
+		w->cycles++;
+	}
+}
+
+/*
+ Work out the HOMO, LUMO and anion orbital spread once a set of MOs has been read.
+ For a spin polarised calculation this is called once for Alpha and once for Beta,
+ with the spread taken over both.
  
-                *DMA_line_number = i + 16; // Skip forward to where MOs start
-		int DMA_step = 0;
-		double value = 0.0;
+ @param[in/out] s Where we are up to in the output, including the MO energies
+ @param[in/out] g Updating gaussian ECP
+ */
+void Nwchem::finish_MOs(nwchem_state *s, gaussian *g)
+{
+	s->reading_MOs = false;
+
+	vector<double> &MO_energy = s->MO_energy;
+	int quantity = g->orbital_spread[0].quantity;
+	int spin_counter = s->spin_counter;
+	// Number of electrons in this channel, or in total if not spin polarised
+	int en = s->number_electrons;
+	int homo = (en/2)-1;
+
+	if (s->spin_polarised != 0)
+	{
+		en = (spin_counter == 0) ? s->alpha_electrons : s->beta_electrons;
+		homo = en-1;
+	}
+
+	// Make sure we have found enough MOs to look at
+	int highest = max(homo+1,region_1_anion_offset+max(quantity-1,0));
+
+	if ((homo < 0) || (highest >= (int) MO_energy.size()))
+	{
+		s->MO_line_number = 0;
+		return;
+	}
+
+	// Firstly lets work out the spread of Anion Orbitals 
+	// Check if this is the first or second loop through
+	// And get spread inclusive of alpha and beta values
+	if ((spin_counter == 0) || (g->orbital_spread[0].min > MO_energy[region_1_anion_offset]))
+	{
+		g->orbital_spread[0].min = MO_energy[region_1_anion_offset];
+	}
+
+	// Find Anion maximum
+	if ((spin_counter == 0) || (g->orbital_spread[0].max < MO_energy[region_1_anion_offset+quantity-1]))
+	{
+		g->orbital_spread[0].max = MO_energy[region_1_anion_offset+quantity-1];
+	}
+
+	g->orbital_spread[0].spread = g->orbital_spread[0].max - g->orbital_spread[0].min;
+
+	// Lets work out the average of the Anion Orbital 
+	for (int a = region_1_anion_offset; a < quantity+region_1_anion_offset; a++)
+	{
+		g->orbital_spread[0].average += MO_energy[a];
+	}
+
+	if (s->spin_polarised == 0)
+	{
+		g->orbital_spread[0].average /= quantity;
+	}
+	else if (spin_counter == 1)
+	{
+		// Divide through by number of alpha and beta electrons
+		g->orbital_spread[0].average /= (quantity*2);
+	}
+
+	// Now lets set the HOMO and LUMO values
+	// We want the highest HOMO and lowest LUMO we can find across both spins
+	if ((spin_counter == 0) || (g->HOMO_value < MO_energy[homo]))
+	{
+		g->HOMO_value = MO_energy[homo];
+	}
 
-		tokens.clear();
-                Tokenize(nwchem_output->at(*DMA_line_number),tokens," \n\t");
+	if ((spin_counter == 0) || (g->LUMO_value > MO_energy[homo+1]))
+	{
+		g->LUMO_value = MO_energy[homo+1];
+	}
 
-		// cout << nwchem_output->at(*DMA_line_number) << endl;
+	if (s->spin_polarised != 0)
+	{
+		// We need this to check if we have been through twice
+		// And picked alpha and beta values
+		s->spin_counter++;
 
-		while ( cmpStr(tokens[4].substr(tokens[4].length()-1),"1") )
+		// Go back to looking for the Beta header
+		if (s->spin_counter == 1)
 		{
-			
-/**
-Here is the setup I used and the values we are trying to fill:
-        g.dma_spread.resize(r1_species.size());
-        for (vector<min_max_spread>::size_type i = 0; i < g.dma_spread.size(); i++)
-        {
-                g.dma_spread[i].max = -1000.0;
-                g.dma_spread[i].min =  1000.0;
-                g.dma_spread[i].average = 0.0;
-                g.dma_spread[i].spread  = 0.0;
-                g.dma_spread[i].quantity =  0;
-                g.dma_spread[i].label    = r1_species[i];
-        }
-**/			
-			int int_match = -1;
-
-			// Find the matching species
-			for (vector<min_max_spread>::size_type j = 0; j < g->dma_spread.size(); j++)
-			{
-				bool match = true;
-
-				if (tokens[4].length() == g->dma_spread[j].label.length()+1)
-                               	{
-                               		for (size_t ichar = 0; ichar < g->dma_spread[j].label.length(); ichar++ )
-                                       	{
-                                       		if ( toupper(tokens[4][ichar]) != g->dma_spread[j].label[ichar])
-                                               	{
-                                                       	match = false;
-                                               	}
-                                       	}
-
-                                       	if (match)
-                                       	{
-                                 	 	int_match = j;
-						g->dma_spread[j].quantity++;
-						// Quick exit?
-						j = g->dma_spread.size();
-                                        }
-                                }	
-			}
+			s->MO_line_number = 0;
+		}
+	}
+}
 
-			// cout << DMA_step << " " << int_match << " " << tokens[4];
-	
-			tokens.clear();
-			DMA_step++;
-			Tokenize(nwchem_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
-
-			// Find modulus of dipolar expansion
-                        while ( !cmpStr(tokens[0],"|q2|") )
-                        {
-                                tokens.clear();
-                                DMA_step++;
-                                Tokenize(nwchem_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
-
-				// Catch scenario where we have a blank line
-                                while ( tokens.size() == 0 )
-                                {
-                                        tokens.clear();
-                                        DMA_step++;
-                                        Tokenize(nwchem_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
-                                }
-                        }
-
-			// cout << " : " << tokens[0] << " " << tokens[1] << " " << " " << tokens[2] << endl;
+/*
+ Take apart the DMA output from NWChem, one line at a time. Each site looks like
 
+ site     x    y    z    O1
+  ...
+ |q2|  =  value
+
+ and the sites carry on while their label ends in 1.
+ 
+ @param[in] tokens Current line contents, split on whitespace only
+ @param[in/out] s Where we are up to in the output
+ @param[in/out] g Updating gaussian ECP
+ @param[in] i Current line index in the output
+ */
+void Nwchem::digest_dma(vector<line_view> *tokens, nwchem_state *s, gaussian *g, int i)
+{
+	// This needs testing for a UHF system
+
+	if (s->DMA_stage == DMA_START)
+	{
+		if (i < s->DMA_line_number)
+		{
+			return;
+		}
+		s->DMA_stage = DMA_SITE;
+	}
+	else if (s->DMA_stage == DMA_FIND_SITE)
+	{
+		// Find next start point
+		if ((tokens->size() == 0) || !cmpView(tokens->at(0),"site"))
+		{
+			return;
+		}
+		s->DMA_stage = DMA_SITE;
+	}
+	else if (s->DMA_stage == DMA_FIND_Q2)
+	{
+		// Find modulus of dipolar expansion
+		if ((tokens->size() > 2) && cmpView(tokens->at(0),"|q2|"))
+		{
 			// Get DMA value, and store information for later analysis
-		        StringToNumber(tokens[2],value);
+			double value = 0.0;
+			ViewToNumber(tokens->at(2),value);
 
-			g->dma_spread[int_match].average += value;
-			
-			if ( value > g->dma_spread[int_match].max )	
+			if (s->DMA_match >= 0)
 			{
-				g->dma_spread[int_match].max = value;
-			}
+				min_max_spread &m = g->dma_spread[s->DMA_match];
+
+				m.average += value;
 			
-			if ( value < g->dma_spread[int_match].min )
-			{
-				g->dma_spread[int_match].min = value;
+				if ( value > m.max )	
+				{
+					m.max = value;
+				}
+			
+				if ( value < m.min )
+				{
+					m.min = value;
+				}
 			}
 
-			// Find next start point
-			while ( !cmpStr(tokens[0],"site") )
-                	{
-				tokens.clear();
-				DMA_step++;
-				Tokenize(nwchem_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
+			s->DMA_stage = DMA_FIND_SITE;
+		}
+		return;
+	}
+
+	// So this is a site. Carry on while the labels are those with a 1 on the end
+	if ((tokens->size() < 5) || !view_ends_with(tokens->at(4),'1'))
+	{
+		finish_dma(s,g);
+		return;
+	}
+
+	s->DMA_match = -1;
 
-				// Catch scenario where we have a blank line
-				while ( tokens.size() == 0 )
+	// Find the matching species
+	line_view label = tokens->at(4);
+
+	for (vector<min_max_spread>::size_type j = 0; j < g->dma_spread.size(); j++)
+	{
+		if (label.length == g->dma_spread[j].label.length()+1)
+		{
+			bool match = true;
+
+			for (size_t ichar = 0; ichar < g->dma_spread[j].label.length(); ichar++ )
+			{
+				if ( toupper(label.start[ichar]) != g->dma_spread[j].label[ichar])
 				{
-					tokens.clear();
-					DMA_step++;
-					Tokenize(nwchem_output->at(*DMA_line_number+DMA_step),tokens," \n\t");
+					match = false;
 				}
-			}				
+			}
+
+			if (match)
+			{
+				s->DMA_match = j;
+				g->dma_spread[j].quantity++;
+				break;
+			}
 		}
+	}
+
+	s->DMA_stage = DMA_FIND_Q2;
+}
+
+/*
+ Work out the DMA spreads once all the sites have been read
+
+ @param[in/out] s Where we are up to in the output
+ @param[in/out] g Updating gaussian ECP
+ */
+void Nwchem::finish_dma(nwchem_state *s, gaussian *g)
+{
+	for (vector<min_max_spread>::size_type j = 0; j < g->dma_spread.size(); j++)
+	{
+		g->dma_spread[j].spread = g->dma_spread[j].max - g->dma_spread[j].min;
+		g->dma_spread[j].average /= g->dma_spread[j].quantity;
+	}
 
-		for (vector<min_max_spread>::size_type j = 0; j < g->dma_spread.size(); j++)
-                {
-			g->dma_spread[j].spread = g->dma_spread[j].max - g->dma_spread[j].min;
-			g->dma_spread[j].average /= g->dma_spread[j].quantity;
-                }
-                
-		// And we're done! Now to print these an see if they are right....
-                // We'll do that outside the loop
-
-                // This will break us out of the loop now we have the information we want
-                return nwchem_output->size();
-        }
-
-        // No luck finding results, return i
-        return i;
+	s->DMA_stage = DMA_DONE;
 }
@@ -19,6 +19,7 @@
 #include "Utils.h"
 #include "Structures.h"
 #include "DFT_Program.h"
+#include "Line_Reader.h"
 
 class Nwchem : public DFT_Program {
 	
@@ -38,28 +39,60 @@ public:
 
         std::vector<std::string> get_ecp_template(gaussian g);
 
-	gaussian digest_electronic(std::vector<std::string> nwchem_output, gaussian g, int r1_anion, std::vector<std::string> r1_species);
+	gaussian digest_electronic(std::string nwchem_output, gaussian g, int r1_anion, std::vector<std::string> r1_species, bool critical);
+
+	void watch_line(line_view line, std::vector<line_view> *tokens, scf_watch *w);
 
         std::string type()
 	{ return "NWCHEM"; }
 	
 private:
+
+	/*
+	 Stages of reading the distributed multipole analysis
+	 */
+	enum dma_stage
+	{
+		DMA_NONE,
+		DMA_START,
+		DMA_SITE,
+		DMA_FIND_Q2,
+		DMA_FIND_SITE,
+		DMA_DONE
+	};
+
+	/*
+	 Everything we need to remember while reading through the output a line at a time
+	 */
+	struct nwchem_state
+	{
+		int line_number;
+		// Line of "Wavefunction type:", until the electron counts below it are read
+		int wavefunction_line;
+		int number_electrons;
+		int alpha_electrons;
+		int beta_electrons;
+		int spin_polarised;
+		int spin_counter;
+		int MO_line_number;
+		bool reading_MOs;
+		std::vector<double> MO_energy;
+		int DMA_line_number;
+		int DMA_stage;
+		int DMA_match;
+		bool finished;
+	};
 	
 	void calculate_starting_gaussian_ecps();
-	
-	int digest_rhf(std::vector<std::string> tokens, 
-				   std::vector<std::string> *nwchem_output, 
-				   int *MO_line_number, gaussian *g, int i, int en);
-	
-	int digest_uhf(std::vector<std::string> tokens, 
-				   std::vector<std::string> *nwchem_output, 
-				   int *MO_line_number, gaussian *g, int i, int en, int spin_counter);
 
-        int digest_dma(std::vector<std::string> tokens,
-                                   std::vector<std::string> *nwchem_output,
-                                   int *DMA_line_number, gaussian *g, int i);
+	void digest_line(line_view line, std::vector<line_view> *tokens, nwchem_state *s, gaussian *g);
+
+	void finish_MOs(nwchem_state *s, gaussian *g);
+
+	void digest_dma(std::vector<line_view> *tokens, nwchem_state *s, gaussian *g, int i);
+
+	void finish_dma(nwchem_state *s, gaussian *g);
 	
 };
 
 #endif
-
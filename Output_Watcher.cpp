@@ -0,0 +1,218 @@
+/*
+ *  @file Output_Watcher.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include "Output_Watcher.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Most of the output read in one go, so a large file is caught up with over several polls
+#define WATCH_READ_MAX 1048576
+// Cycles in a row that each change the energy by more than the last, and the change (Hartree) that is then too large
+#define WATCH_DIVERGE_CYCLES 5
+#define WATCH_DIVERGE_CHANGE 1.0
+// Cycles in a row that swap the direction of the energy change, and the change (Hartree) below which this is just noise
+#define WATCH_OSCILLATE_CYCLES 20
+#define WATCH_OSCILLATE_CHANGE 1.0e-4
+// Fraction of its size an oscillation must keep over those cycles, or else it is dying away
+#define WATCH_OSCILLATE_DAMPING 0.5
+
+/*
+ Constructor
+
+ No params
+ */
+Output_Watcher::Output_Watcher()
+{
+	program = NULL;
+	reset();
+}
+
+/*
+ Constructor
+
+ @param[in] p QM program, which knows how to read its own output
+ @param[in] f Output file to follow. It need not exist yet
+ */
+Output_Watcher::Output_Watcher(DFT_Program *p, string f)
+{
+	program = p;
+	filename = f;
+	reset();
+}
+
+/*
+ Start again from the beginning of the output
+
+ No params
+ */
+void Output_Watcher::reset()
+{
+	position = 0;
+	partial.clear();
+	state.in_table = false;
+	state.cycles = 0;
+	state.energies.clear();
+	state.reason.clear();
+}
+
+/*
+ Read anything written to the output since the last poll, and check it
+
+ @return bool True when a reason to stop the calculation has just been found
+ */
+bool Output_Watcher::poll()
+{
+	// Nothing to follow, or already given up on
+	if ((program == NULL) || (state.reason.size() > 0))
+	{
+		return false;
+	}
+
+	int fd = open(filename.c_str(),O_RDONLY);
+
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat sb;
+
+	if (fstat(fd,&sb) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	// Rewritten from the start, so forget what we had
+	if (sb.st_size < position)
+	{
+		reset();
+	}
+
+	if (sb.st_size == position)
+	{
+		close(fd);
+		return false;
+	}
+
+	size_t length = (size_t) (sb.st_size - position);
+
+	if (length > WATCH_READ_MAX)
+	{
+		length = WATCH_READ_MAX;
+	}
+
+	const size_t previous = partial.size();
+	partial.resize(previous + length);
+	ssize_t count = pread(fd,&partial[previous],length,position);
+	close(fd);
+
+	if (count <= 0)
+	{
+		partial.resize(previous);
+		return false;
+	}
+
+	partial.resize(previous + count);
+	position += count;
+
+	// Only whole lines are looked at. The rest waits for the next poll
+	const size_t energies = state.energies.size();
+	vector<line_view> tokens;
+	size_t start = 0;
+	size_t end;
+
+	while ((end = partial.find('\n',start)) != string::npos)
+	{
+		line_view line;
+		line.start = partial.data() + start;
+		line.length = end - start;
+		program->watch_line(line,&tokens,&state);
+		start = end + 1;
+
+		if (state.reason.size() > 0)
+		{
+			return true;
+		}
+	}
+
+	partial.erase(0,start);
+
+	if (state.energies.size() != energies)
+	{
+		check_energies();
+	}
+
+	return (state.reason.size() > 0);
+}
+
+/*
+ Look over the SCF energies so far for signs that the SCF will not converge
+
+ No params
+ */
+void Output_Watcher::check_energies()
+{
+	const vector<double> &e = state.energies;
+	const vector<double>::size_type n = e.size();
+
+	if ((n > 0) && !isfinite(e[n-1]))
+	{
+		state.reason = "SCF energy is no longer a finite number";
+		return;
+	}
+
+	// Each change bigger than the last, ending in a large one
+	if (n > WATCH_DIVERGE_CYCLES + 1)
+	{
+		bool diverging = (fabs(e[n-1] - e[n-2]) > WATCH_DIVERGE_CHANGE);
+
+		for (vector<double>::size_type i = n - WATCH_DIVERGE_CYCLES; diverging && (i < n); i++)
+		{
+			if (fabs(e[i] - e[i-1]) <= fabs(e[i-1] - e[i-2]))
+			{
+				diverging = false;
+			}
+		}
+
+		if (diverging)
+		{
+			double change = e[n-1] - e[n-2];
+			state.reason = "SCF energy diverging, last change " + NumberToString(change) + " Hartree";
+			return;
+		}
+	}
+
+	// The energy going up and down in turn, without getting any smaller
+	if (n > WATCH_OSCILLATE_CYCLES + 1)
+	{
+		const vector<double>::size_type first = n - WATCH_OSCILLATE_CYCLES;
+		const double first_change = fabs(e[first] - e[first-1]);
+		const double last_change = fabs(e[n-1] - e[n-2]);
+		bool oscillating = ((last_change > WATCH_OSCILLATE_CHANGE) &&
+				    (last_change >= WATCH_OSCILLATE_DAMPING * first_change));
+
+		for (vector<double>::size_type i = first + 1; oscillating && (i < n); i++)
+		{
+			if ((e[i] - e[i-1]) * (e[i-1] - e[i-2]) >= 0.0)
+			{
+				oscillating = false;
+			}
+		}
+
+		if (oscillating)
+		{
+			double change = last_change;
+			int cycles = WATCH_OSCILLATE_CYCLES;
+			state.reason = "SCF energy oscillating by " + NumberToString(change) + " Hartree over " +
+				       NumberToString(cycles) + " cycles";
+		}
+	}
+}
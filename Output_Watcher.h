@@ -0,0 +1,75 @@
+/*
+ *  @Output_Watcher.h
+ *  fit_my_ecp
+ *
+ *  @brief Follows the QM output of a running calculation as it is written,
+ *  and decides if the calculation is not going to finish well. An error banner,
+ *  an SCF energy that runs away, or one that keeps swinging up and down
+ *  without settling, are all reasons to stop it early.
+ *
+ */
+
+#ifndef OUTPUT_WATCHER_H
+#define OUTPUT_WATCHER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+// Personal headers
+#include "Utils.h"
+#include "DFT_Program.h"
+#include "Line_Reader.h"
+
+class Output_Watcher {
+
+public:
+
+	Output_Watcher();
+
+	Output_Watcher(DFT_Program *p, std::string f);
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Output_Watcher(){}
+
+	bool poll();
+
+	/*
+	 Check if there is an output being followed
+
+	 @return bool True if poll has something to do
+	 */
+	bool get_active()
+	{
+		return (program != NULL);
+	}
+
+	/*
+	 Return why the calculation should be stopped
+
+	 @return string Reason, or empty if all looks fine
+	 */
+	std::string get_reason()
+	{
+		return state.reason;
+	}
+
+private:
+
+	DFT_Program *program;
+	std::string filename;
+	// Amount of the output read so far, and any line not yet finished
+	off_t position;
+	std::string partial;
+	scf_watch state;
+
+	void reset();
+
+	void check_energies();
+};
+
+#endif
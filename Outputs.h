@@ -17,6 +17,7 @@
 #include <cmath>
 // Personal headers
 #include "Structures.h"
+#include "Trace.h"
 
 class Outputs{
 	
@@ -94,12 +95,40 @@ public:
 	 @param[in] os The size of the offspring population
 	 @param[in] cc Convergence criteria to terminate a GA search
 	 @param[in] md Check for dynamic mutation
+	 @param[in] as Replace population members as each ECP finishes, rather than by generation
 	 */
 	virtual void set_ga_parameters(int ps,
 								   int ms,
 								   int os,
 								   int cc,
-								   bool md)
+								   bool md,
+								   bool as)
+	{;}
+	
+	/*
+	 Method to set the LBFGS-B parameters
+	 
+	 @param[in] m Number of correction pairs kept for the Hessian approximation
+	 @param[in] me Maximum number of ECPs to evaluate
+	 */
+	virtual void set_lbfgs_parameters(int m, int me)
+	{;}
+	
+	/*
+	 Method to set the size of batches for space-filling searches
+	 
+	 @param[in] bs Number of ECPs handed out in each batch
+	 @param[in] ts Total number of ECPs to sample
+	 */
+	virtual void set_sample_parameters(int bs, int ts)
+	{;}
+	
+	/*
+	 Passes in the ECPs already in the history, once it has been read in
+	 
+	 @param[in] v Vector of ECPs from the history
+	 */
+	virtual void set_ecps_history(std::vector<gaussian> v)
 	{;}
 	
 	/*
@@ -112,6 +141,18 @@ public:
 	
 	virtual std::vector<gaussian> get_ecps_to_test();
 	
+	/*
+	 Check if the search takes ECPs back as soon as they are done, rather than by the batch.
+	 If so, set_ecps_tested is called with whichever ECPs have finished, and
+	 get_ecps_to_test must then only return ECPs which have not been handed out before
+	 
+	 @return bool True if ECPs are taken back as they finish
+	 */
+	virtual bool get_asynchronous()
+	{
+		return false;
+	}
+	
 	/*
 	 Takes in the details of the last search run, and saves data
 	 
@@ -24,6 +24,7 @@ Powells::Powells(int *seed) : Outputs(seed)
 	//idum = seed;
 	vector_counter = 0;
 	max_steps_in_one_direction = 0;
+	line_steps = 1;
 	minimisation_count = 0;
 	number_one_ranked = 0;
 	
@@ -293,6 +294,23 @@ void Powells::set_parameters(vector< vector<double> > ss,
 	// Defaults are set
 }
 
+/*
+ Set how many ECPs are tested at once. Half of the batch goes each way along
+ the current search vector, at increasing multiples of the step size
+ 
+ @param[in] bs Number of ECPs to be tested at once
+ @param[in] ts Total number of ECPs to sample (not used)
+ */
+void Powells::set_sample_parameters(int bs, int ts)
+{
+	line_steps = bs / 2;
+
+	if (line_steps < 1)
+	{
+		line_steps = 1;
+	}
+}
+
 /*
  Calculate ECPs to test from the initial data
  
@@ -311,72 +329,49 @@ void Powells::calculate_ecps_to_test()
 		resize_search_vectors(g);
 	}
 	
-	// Dynamically scale all vectors
-	bool values_allowed = false;
-	while (!values_allowed)
+	// Step out either way along the search vector, one multiple of the step size further each time
+	for (int k = 1; k <= line_steps; k++)
 	{
-		// Count the number of zeros
-		int zero_counter = 0;
-		
-		for (vector<gaussian_info>::size_type a = 0; a < g.values.size(); a++)
+		for (int direction_factor = 1; direction_factor >= -1; direction_factor -= 2)
 		{
-			// g.values[a].value += search_vectors[vector_counter][g.values[a].type]*step_size[g.values[a].type][a];
-			g.values[a].value += search_vectors[vector_counter][a]*step_size[g.values[a].type][a];
-			
-			if (g.values[a].value == 0)
+			g = ecps_to_test[0];
+
+			int multiple = direction_factor*k;
+
+			// Dynamically scale all vectors
+			bool values_allowed = false;
+			while (!values_allowed)
 			{
-				zero_counter++;
-			}
-		}
-		
-		if (zero_counter == 0)
-		{
-			values_allowed = true;
-		}
-		else 
-		{
-			// Non-critical error. Using work around
-			cout << "One of the ECP values is zero, which is unacceptable! Making another step" << endl;
-		}
-	}
-	
-	ecps_to_test.push_back(g);
-	
-	// Add variant with decreased value
-	g = ecps_to_test[0];
-	
-	// Dynamically scale all vectors in opposite direction
-	values_allowed = false;
-	while (!values_allowed)
-	{
-		// Count the number of zeros
-		int zero_counter = 0;
+				// Count the number of zeros
+				int zero_counter = 0;
 		
-		for (vector<gaussian_info>::size_type a = 0; a < g.values.size(); a++)
-		{			
-			// g.values[a].value -= search_vectors[vector_counter][g.values[a].type]*step_size[g.values[a].type][a];
-			g.values[a].value -= search_vectors[vector_counter][a]*step_size[g.values[a].type][a];
+				for (vector<gaussian_info>::size_type a = 0; a < g.values.size(); a++)
+				{
+					g.values[a].value += multiple*search_vectors[vector_counter][a]*step_size[g.values[a].type][a];
 			
-			if (g.values[a].value == 0)
-			{
-				zero_counter++;
-			}
-		}
+					if (g.values[a].value == 0)
+					{
+						zero_counter++;
+					}
+				}
 		
-		if (zero_counter == 0)
-		{
-			values_allowed = true;
-		}
-		else 
-		{
-			// Non-critical error. Using work around
-			cout << "One of the ECP values is zero, which is unacceptable! Making another step." << endl;
+				if (zero_counter == 0)
+				{
+					values_allowed = true;
+				}
+				else 
+				{
+					// Non-critical error. Using work around
+					cout << "One of the ECP values is zero, which is unacceptable! Making another step" << endl;
+					multiple = direction_factor;
+				}
+			}
+	
+			// Add new values
+			ecps_to_test.push_back(g);
 		}
 	}
 	
-	// Add new values
-	ecps_to_test.push_back(g);	
-	
 	//cout << ecps_to_test.size() << endl;
 	
 	// Check new values for duplicates
@@ -460,27 +455,24 @@ void Powells::check_converged()
 		// Increment Powell's search vector if not a Powell's search
 		if (vector_counter < (search_vectors.size()-1))
 		{
-			// search vector could be negative
-			int direction_factor = -1;
-			int direction_sum = 0;
+			// search vector could be negative, and we may have moved more than one step along it
+			int direction_factor = 0;
 			
-			// Check over all values for direction taken
+			// Check the first value we moved for how many steps were taken, and in which direction
 			for (vector<gaussian_info>::size_type a = 0; a < ecps_tested[number_one_ranked].values.size(); a++)
 			{
-				//if (ecps_tested[number_one_ranked].values[a].value == 
-				//	(previous_minimum.values[a].value + search_vectors[vector_counter][previous_minimum.values[a].type]*step_size[previous_minimum.values[a].type][a]))
-				if (ecps_tested[number_one_ranked].values[a].value == 
-					(previous_minimum.values[a].value + search_vectors[vector_counter][a]*step_size[previous_minimum.values[a].type][a]))
-					
+				const double step = search_vectors[vector_counter][a]*step_size[previous_minimum.values[a].type][a];
+
+				if (step != 0.0)
 				{
-					direction_sum++;
+					direction_factor = int(floor((ecps_tested[number_one_ranked].values[a].value - previous_minimum.values[a].value) / step + 0.5));
+					break;
 				}
 			}
-			// Compare total. If matches number of vectors we have moved in a positive direction
-			int ecps_tested_one_size = ecps_tested[number_one_ranked].values.size();
-			if (direction_sum == ecps_tested_one_size)
+			
+			if (direction_factor == 0)
 			{
-				direction_factor = 1;
+				direction_factor = -1;
 			}
 			
 			// Search vector direction has now been set correctly
@@ -42,6 +42,8 @@ public:
 				    std::vector<double> min,
 				    std::vector<double> max,
 				    int msod);	
+
+	virtual void set_sample_parameters(int bs, int ts);
 	
 	/*
 	 Defines initial ECPs, and sets up class
@@ -84,6 +86,8 @@ protected:
 	
 	std::vector<int>::size_type vector_counter;
 	int max_steps_in_one_direction;
+	// Number of step multiples tested either side of the minimum along a search vector
+	int line_steps;
 	int minimisation_count;
 	int number_one_ranked;
 	// Vectors
@@ -0,0 +1,313 @@
+/*
+ *  @file Process_Runner.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include "Process_Runner.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ Constructor
+
+ No params
+ */
+Process_Runner::Process_Runner()
+{
+	timeout = 0.0;
+	grace = 30.0;
+}
+
+/*
+ Start a program directly, without going through a shell. The program is put in its
+ own process group, so anything it starts in turn can be stopped along with it.
+
+ @param[in] arguments Program name followed by its arguments. The program is searched for in PATH
+ @param[in] folder Folder to run in. Empty to stay in the current folder
+ @param[in] output File to take stdout and stderr. Empty to leave them alone
+ @return pid_t Process ID of the new program
+ */
+pid_t Process_Runner::start(vector<string> arguments, string folder, string output)
+{
+	if (arguments.size() == 0)
+	{
+		cout << "No program given to run" << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// Build the argument list before forking, so the child does no allocation
+	vector<char *> argv;
+
+	for (vector<string>::size_type i = 0; i < arguments.size(); i++)
+	{
+		argv.push_back(const_cast<char *>(arguments[i].c_str()));
+	}
+
+	argv.push_back(NULL);
+
+	// Make sure nothing buffered is written twice by the child
+	cout.flush();
+	fflush(stdout);
+
+	pid_t pid = fork();
+
+	if (pid == 0)
+	{
+		setpgid(0,0);
+
+		if ((folder.size() > 0) && (chdir(folder.c_str()) != 0))
+		{
+			_exit(127);
+		}
+
+		if (output.size() > 0)
+		{
+			int fd = open(output.c_str(),O_WRONLY | O_CREAT | O_TRUNC,0644);
+
+			if (fd >= 0)
+			{
+				dup2(fd,STDOUT_FILENO);
+				dup2(fd,STDERR_FILENO);
+				close(fd);
+			}
+		}
+
+		execvp(argv[0],&argv[0]);
+		_exit(127);
+	}
+	else if (pid < 0)
+	{
+		cout << "Could not start program: " << arguments[0] << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// Also set the group from here, so it is in place whichever of us runs first
+	setpgid(pid,pid);
+
+	running_process p;
+	p.pid = pid;
+	p.start_time = monotonic_seconds();
+	p.term_time = 0.0;
+	p.stopping = false;
+	p.killed = false;
+	p.timed_out = false;
+	p.aborted = false;
+	processes.push_back(p);
+
+	return pid;
+}
+
+/*
+ See if a process has finished, without blocking. If it has run out of time
+ it is sent SIGTERM, and SIGKILL once the grace period has also passed.
+
+ @param[in] pid Process to check
+ @param[out] s Exit status and resource use, filled in if the process has finished
+ @return bool True if the process has finished
+ */
+bool Process_Runner::check(pid_t pid, process_status *s)
+{
+	vector<running_process>::size_type i;
+
+	for (i = 0; i < processes.size(); i++)
+	{
+		if (processes[i].pid == pid)
+		{
+			break;
+		}
+	}
+
+	if (i == processes.size())
+	{
+		cout << "Checking on a process that was not started here: " << pid << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// Look without reaping, so the group is still ours to clear up once the program has finished
+	siginfo_t info;
+	int result;
+	info.si_pid = 0;
+
+	do
+	{
+		result = waitid(P_PID,pid,&info,WEXITED | WNOHANG | WNOWAIT);
+	}
+	while ((result < 0) && (errno == EINTR));
+
+	double t = monotonic_seconds();
+
+	if ((result == 0) && (info.si_pid == 0))
+	{
+		// Still running, so see if it is overdue
+		if ((timeout > 0.0) && !processes[i].stopping && (t - processes[i].start_time > timeout))
+		{
+			processes[i].timed_out = true;
+			stop(pid);
+		}
+		else if (processes[i].stopping && !processes[i].killed && (t - processes[i].term_time > grace))
+		{
+			processes[i].killed = true;
+			kill(-pid,SIGKILL);
+		}
+
+		return false;
+	}
+	else if (result < 0)
+	{
+		cout << "Lost track of process: " << pid << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	// Tidy up anything the program left running in its group. The program has not been
+	// reaped yet, so the group can't have been handed on to anything else
+	if (!processes[i].killed)
+	{
+		processes[i].killed = true;
+		kill(-pid,SIGKILL);
+	}
+
+	int status = 0;
+	struct rusage usage;
+	pid_t reaped;
+
+	do
+	{
+		reaped = wait4(pid,&status,0,&usage);
+	}
+	while ((reaped < 0) && (errno == EINTR));
+
+	if (reaped != pid)
+	{
+		cout << "Lost track of process: " << pid << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	s->exit_code = 0;
+	s->signal = 0;
+
+	if (WIFEXITED(status))
+	{
+		s->exit_code = WEXITSTATUS(status);
+	}
+	else if (WIFSIGNALED(status))
+	{
+		s->signal = WTERMSIG(status);
+	}
+
+	s->timed_out = processes[i].timed_out;
+	s->aborted = processes[i].aborted;
+	s->wall_time = t - processes[i].start_time;
+	s->user_time = (double) usage.ru_utime.tv_sec + 1.0e-6 * (double) usage.ru_utime.tv_usec;
+	s->system_time = (double) usage.ru_stime.tv_sec + 1.0e-6 * (double) usage.ru_stime.tv_usec;
+	s->max_rss = usage.ru_maxrss;
+
+	processes.erase(processes.begin()+i);
+
+	return true;
+}
+
+/*
+ Block until a process finishes, applying the time limits as for check
+
+ @param[in] pid Process to wait for
+ @return process_status Exit status and resource use
+ */
+process_status Process_Runner::wait(pid_t pid)
+{
+	process_status s;
+
+	while (!check(pid,&s))
+	{
+		usleep(100000);
+	}
+
+	return s;
+}
+
+/*
+ Ask a process and its group to stop straight away, without waiting for it.
+ It is sent SIGTERM, and SIGKILL by check once the grace period has passed
+
+ @param[in] pid Process to stop
+ */
+void Process_Runner::stop(pid_t pid)
+{
+	for (vector<running_process>::size_type i = 0; i < processes.size(); i++)
+	{
+		if ((processes[i].pid == pid) && !processes[i].stopping)
+		{
+			processes[i].stopping = true;
+			processes[i].term_time = monotonic_seconds();
+			kill(-pid,SIGTERM);
+		}
+	}
+}
+
+/*
+ Stop a process and its group early, because the caller can see it is not going to
+ give a useful result. It is stopped as for stop, but reported as aborted
+
+ @param[in] pid Process to stop
+ */
+void Process_Runner::abort(pid_t pid)
+{
+	for (vector<running_process>::size_type i = 0; i < processes.size(); i++)
+	{
+		if ((processes[i].pid == pid) && !processes[i].stopping)
+		{
+			processes[i].aborted = true;
+		}
+	}
+
+	stop(pid);
+}
+
+/*
+ Summarise how a process finished, for printing
+
+ @param[in] s Status from check or wait
+ @return string One line description
+ */
+string Process_Runner::describe(process_status s)
+{
+	string text;
+
+	if (s.timed_out)
+	{
+		text = "timed out";
+	}
+	else if (s.aborted)
+	{
+		text = "stopped early";
+	}
+	else if (s.signal != 0)
+	{
+		text = "killed by signal " + NumberToString(s.signal);
+	}
+	else
+	{
+		text = "exit status " + NumberToString(s.exit_code);
+	}
+
+	text += ", wall " + NumberToString(s.wall_time) + " s";
+	double cpu_time = s.user_time + s.system_time;
+	text += ", cpu " + NumberToString(cpu_time) + " s";
+	text += ", max rss " + NumberToString(s.max_rss) + " kB";
+
+	return text;
+}
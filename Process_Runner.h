@@ -0,0 +1,98 @@
+/*
+ *  @Process_Runner.h
+ *  fit_my_ecp
+ *
+ *  @brief Starts external programs directly with fork/exec, without a shell,
+ *  and keeps track of them until they exit. Programs running past their
+ *  wall clock limit, or aborted by the caller, are sent SIGTERM, and then
+ *  SIGKILL if they ignore it.
+ *
+ */
+
+#ifndef PROCESS_RUNNER_H
+#define PROCESS_RUNNER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+// Personal headers
+#include "Utils.h"
+
+/*
+ How a process finished, and what it cost
+ */
+struct process_status
+{
+	int exit_code;
+	int signal;
+	bool timed_out;
+	bool aborted;
+	double wall_time;
+	double user_time;
+	double system_time;
+	long max_rss;
+};
+
+class Process_Runner {
+
+public:
+
+	Process_Runner();
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Process_Runner(){}
+
+	/*
+	 Set the wall clock limits for each process
+
+	 @param[in] t Seconds before a process is asked to stop. Zero switches this off
+	 @param[in] g Seconds allowed after SIGTERM before SIGKILL is sent
+	 */
+	void set_timeout(double t, double g)
+	{
+		timeout = t;
+		grace = g;
+	}
+
+	pid_t start(std::vector<std::string> arguments, std::string folder, std::string output);
+
+	bool check(pid_t pid, process_status *s);
+
+	process_status wait(pid_t pid);
+
+	void stop(pid_t pid);
+
+	void abort(pid_t pid);
+
+	static bool succeeded(process_status s)
+	{
+		return (!s.timed_out && !s.aborted && s.signal == 0 && s.exit_code == 0);
+	}
+
+	static std::string describe(process_status s);
+
+private:
+
+	struct running_process
+	{
+		pid_t pid;
+		double start_time;
+		double term_time;
+		// SIGTERM has been sent, and why, and whether SIGKILL has followed
+		bool stopping;
+		bool killed;
+		bool timed_out;
+		bool aborted;
+	};
+
+	double timeout;
+	double grace;
+	std::vector<running_process> processes;
+};
+
+#endif
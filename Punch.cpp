@@ -249,15 +249,29 @@ void Punch::analyse(vector<string> p)
 }
 
 /*
- Compares two punch templates to see if a defect has been introduced
+ Compares two punch templates to see if a defect has been introduced.
+ The output is only counted over in place, and is read in properly if it differs.
  
- @param[in] punch_output Updated punch file
+ @param[in] punch_output Filename of the updated punch file
+ @param[in] critical Catch for critical errors to terminate program if the file is missing
  */
-void Punch::compare(vector<string> punch_output)
+void Punch::compare(string punch_output, bool critical)
 {
+	Line_Reader reader(punch_output, critical);
+	line_view line;
+
+	if (!reader.is_open())
+	{
+		return;
+	}
+
+	while (reader.next(&line))
+	{
+	}
+
 	// This should only run once in the scenario where we have introduced a defect
 	// Needs full testing but I'm confident
-	if (punch_output.size() != punch_template.size())
+	if (reader.line_number() != punch_template.size())
 	{
 		cout << endl;
 		cout << "Punch output and template do not have the same number of atoms" << endl;
@@ -275,7 +289,7 @@ void Punch::compare(vector<string> punch_output)
 		centre_coords.clear();
 		
 		// Update the numbers to reflect the potentially defective system
-		analyse(punch_output);
+		analyse(read_in_lines(punch_output, critical));
 	}
 }
 
@@ -16,6 +16,8 @@
 // Personal headers
 #include "Utils.h"
 #include "Structures.h"
+#include "IO.h"
+#include "Line_Reader.h"
 
 class Punch {
 
@@ -50,7 +52,7 @@ public:
 		analyse(s);
 	}
 	
-	void compare(std::vector<std::string> punch_output);
+	void compare(std::string punch_output, bool critical = true);
 	
 	void print_regions();
 	
@@ -105,7 +107,24 @@ public:
 	{
 		return centre_regions_total;
 	}
-	
+
+	/*
+	 Return the label of each centre, without its region number
+
+	 @return vector<string> Vector array containing the labels, of size total_centres
+	 */
+	std::vector<std::string> get_centre_labels()
+	{
+		std::vector<std::string> labels(centre_coords.size());
+
+		for (std::vector<std::string>::size_type i = 0; i < labels.size(); i++)
+		{
+			labels[i] = centre_coords[i].label;
+		}
+
+		return labels;
+	}
+
 	/*
 	 Return the template punch for runtime
 	 
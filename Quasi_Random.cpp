@@ -0,0 +1,307 @@
+/*
+ *  @file Quasi_Random.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include "Quasi_Random.h"
+
+using namespace std;
+
+// Number of bits in each Sobol coordinate
+#define SOBOL_BITS 32
+
+/*
+ Sobol primitive polynomials and initial direction numbers (Joe and Kuo)
+ for every dimension after the first, which is the van der Corput sequence.
+ Each row is the degree, the polynomial coefficients, then the direction numbers
+ */
+static const unsigned int sobol_table[][10] = {
+	{1, 0, 1},
+	{2, 1, 1, 3},
+	{3, 1, 1, 3, 1},
+	{3, 2, 1, 1, 1},
+	{4, 1, 1, 1, 3, 3},
+	{4, 4, 1, 3, 5, 13},
+	{5, 2, 1, 1, 5, 5, 17},
+	{5, 4, 1, 1, 5, 5, 5},
+	{5, 7, 1, 1, 7, 11, 19},
+	{5, 11, 1, 1, 5, 1, 1},
+	{5, 13, 1, 1, 1, 3, 11},
+	{5, 14, 1, 3, 5, 5, 31},
+	{6, 1, 1, 3, 3, 9, 7, 49},
+	{6, 13, 1, 1, 1, 15, 21, 21},
+	{6, 16, 1, 3, 1, 13, 27, 49},
+	{6, 19, 1, 1, 1, 15, 7, 5},
+	{6, 22, 1, 3, 1, 15, 13, 25},
+	{6, 25, 1, 1, 5, 5, 19, 61},
+	{7, 1, 1, 3, 7, 11, 23, 15, 103},
+	{7, 4, 1, 3, 7, 13, 13, 15, 69}
+};
+
+static const unsigned int sobol_dimensions_max = 1 + sizeof(sobol_table) / sizeof(sobol_table[0]);
+
+/*
+ Constructor
+
+ @param[in/out] seed Pointer to the seed
+ @param[in] flag Use a Latin hypercube instead of the Sobol sequence
+ */
+Quasi_Random::Quasi_Random(int *seed, bool flag) : Outputs(seed)
+{
+	latin_hypercube = flag;
+	batch_size = 1;
+	total_samples = 1;
+	sample_index = 0;
+	sample_limit = 0;
+
+	// Search area confines
+	minimums.resize(2,0.0);
+	maximums.resize(2,0.0);
+}
+
+/*
+ Set the boundaries for the search. Step sizes are not used here
+
+ @param[in] ss The step size to be initially used for A and zeta
+ @param[in] sr Step reduction rate for A and zeta
+ @param[in] ssm Convergence criteria, defined as the target step size to reach, for A and zeta
+ @param[in] min Minimum values for A and zeta
+ @param[in] max Maximum values for A and zeta
+ @param[in] msod Maximum steps in any one direction - by default this is disabled
+ */
+void Quasi_Random::set_parameters(vector< vector<double> > ss,
+			     vector< vector<double> > sr,
+			     vector< vector<double> > ssm,
+			     vector<double> min,
+			     vector<double> max,
+			     int msod)
+{
+	minimums = min;
+	maximums = max;
+
+	// - constraining values for A
+	if (minimums[0] == 0.0)
+	{
+		cout << "Using default constraint of minimum value for A: 0.0" << endl;
+		minimums[0] = 0.0;
+	}
+	if (maximums[0] == 0.0)
+	{
+		cout << "Using default constraint of maximum value for A: 1000" << endl;
+		maximums[0] = 1000.0;
+	}
+	// - constraining values for Z
+	if (minimums[1] == 0.0)
+	{
+		cout << "Using default constraint of minimum value for Z: 0.0" << endl;
+		minimums[1] = 0.0;
+	}
+	if (maximums[1] == 0.0)
+	{
+		cout << "Using default constraint of maximum value for Z: 1000" << endl;
+		maximums[1] = 1000.0;
+	}
+
+	// Defaults are set
+}
+
+/*
+ Method to set the size of batches
+
+ @param[in] bs Number of ECPs handed out in each batch
+ @param[in] ts Total number of ECPs to sample, which sets the size of the Latin hypercube
+ */
+void Quasi_Random::set_sample_parameters(int bs, int ts)
+{
+	batch_size = bs > 0 ? bs : 1;
+	total_samples = ts > 0 ? ts : 1;
+}
+
+/*
+ Set up the sequence for the number of parameters in the starting gaussian,
+ and create the first batch. The starting gaussian is put in first for comparison.
+ The sequence only depends on the seed, so a restarted search revisits the same
+ ECPs in the same order and picks them up from the history.
+
+ No param.
+ */
+void Quasi_Random::calculate_ecps_to_test()
+{
+	const unsigned int dimensions = starting_gaussians.values.size();
+
+	if (latin_hypercube)
+	{
+		calculate_hypercube(dimensions);
+		sample_index = 0;
+		sample_limit = total_samples;
+	}
+	else
+	{
+		calculate_directions(dimensions);
+		// Skip the first point as it sits on the minimums
+		sample_index = 1;
+		sample_limit = 0xFFFFFFFFULL;
+	}
+
+	ecps_to_test.clear();
+	ecps_to_test.push_back(starting_gaussians);
+
+	calculate_next_batch();
+}
+
+/*
+ Calculate Sobol direction numbers for each dimension
+
+ @param[in] dimensions Number of parameters being searched
+ */
+void Quasi_Random::calculate_directions(unsigned int dimensions)
+{
+	if (dimensions > sobol_dimensions_max)
+	{
+		cout << "Sobol search is limited to " << sobol_dimensions_max << " parameters. ";
+		cout << "There are " << dimensions << " in the ECP template; use the Latin hypercube (lhs) instead." << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	directions.assign(dimensions,vector<unsigned int>(SOBOL_BITS,0));
+
+	for (unsigned int d = 0; d < dimensions; d++)
+	{
+		vector<unsigned int> &v = directions[d];
+
+		// First dimension is the van der Corput sequence
+		if (d == 0)
+		{
+			for (unsigned int k = 0; k < SOBOL_BITS; k++)
+			{
+				v[k] = 1U << (SOBOL_BITS - 1 - k);
+			}
+			continue;
+		}
+
+		const unsigned int *row = sobol_table[d-1];
+		const unsigned int s = row[0];
+		const unsigned int a = row[1];
+
+		for (unsigned int k = 0; k < s; k++)
+		{
+			v[k] = row[2+k] << (SOBOL_BITS - 1 - k);
+		}
+
+		// Recurrence from the primitive polynomial for the rest
+		for (unsigned int k = s; k < SOBOL_BITS; k++)
+		{
+			v[k] = v[k-s] ^ (v[k-s] >> s);
+
+			for (unsigned int i = 1; i < s; i++)
+			{
+				if ((a >> (s - 1 - i)) & 1)
+				{
+					v[k] ^= v[k-i];
+				}
+			}
+		}
+	}
+}
+
+/*
+ Create the Latin hypercube, with one point in each of total_samples slices
+ along every dimension, jittered within the slice
+
+ @param[in] dimensions Number of parameters being searched
+ */
+void Quasi_Random::calculate_hypercube(unsigned int dimensions)
+{
+	hypercube.assign(total_samples,vector<double>(dimensions,0.0));
+
+	vector<unsigned int> slices(total_samples);
+
+	for (unsigned int d = 0; d < dimensions; d++)
+	{
+		for (unsigned int i = 0; i < total_samples; i++)
+		{
+			slices[i] = i;
+		}
+
+		// Shuffle the slices for this dimension
+		for (unsigned int i = total_samples - 1; i > 0; i--)
+		{
+			unsigned int j = randomNumber(i + 1, idum);
+			swap(slices[i],slices[j]);
+		}
+
+		for (unsigned int i = 0; i < total_samples; i++)
+		{
+			double r = randomNumber(idum);
+
+			// Keep away from the minimum, which can be an invalid number
+			while (r == 0.0)
+			{
+				r = randomNumber(idum);
+			}
+
+			hypercube[i][d] = (slices[i] + r) / total_samples;
+		}
+	}
+}
+
+/*
+ Fill ecps_to_test with the next batch of points
+
+ No param
+ */
+void Quasi_Random::calculate_next_batch()
+{
+	gaussian g = starting_gaussians;
+	vector<double> u(g.values.size());
+
+	while ((sample_index < sample_limit) &&
+	       (ecps_to_test.size() < batch_size))
+	{
+		get_sample(sample_index,&u);
+		sample_index++;
+
+		// Scale from the unit cube into the box
+		for (vector<gaussian_info>::size_type i = 0; i < g.values.size(); i++)
+		{
+			const int type = g.values[i].type;
+			g.values[i].value = minimums[type] + u[i] * (maximums[type] - minimums[type]);
+		}
+
+		ecps_to_test.push_back(g);
+	}
+}
+
+/*
+ Get a point in the unit cube by its position in the sequence
+
+ @param[in] index Position in the sequence
+ @param[out] u Coordinates of the point
+ */
+void Quasi_Random::get_sample(unsigned long long index, vector<double> *u)
+{
+	if (latin_hypercube)
+	{
+		*u = hypercube[index];
+		return;
+	}
+
+	// Gray code of the index picks the direction numbers to combine
+	const unsigned long long gray = index ^ (index >> 1);
+
+	for (vector<double>::size_type d = 0; d < u->size(); d++)
+	{
+		unsigned int x = 0;
+
+		for (unsigned int k = 0; k < SOBOL_BITS; k++)
+		{
+			if ((gray >> k) & 1)
+			{
+				x ^= directions[d][k];
+			}
+		}
+
+		(*u)[d] = x / 4294967296.0;
+	}
+}
@@ -0,0 +1,137 @@
+/*
+ *  @Quasi_Random.h
+ *  fit_my_ecp
+ *
+ *  @brief Implementation of space-filling searches, using either a
+ *  Sobol sequence or a Latin hypercube between the mins and maxes.
+ *  Inherits some attributes from Outputs, which are rewritten here
+ *
+ */
+
+#ifndef QUASI_RANDOM_H
+#define QUASI_RANDOM_H
+
+#include "Utils.h"
+#include "Outputs.h"
+
+class Quasi_Random : public Outputs {
+
+public:
+
+	/*
+	 Constructor
+
+	 No params
+	 */
+	Quasi_Random(){}
+
+	Quasi_Random(int *seed, bool flag = false);
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Quasi_Random(){}
+
+	virtual void set_parameters(std::vector< std::vector<double> > ss,
+				    std::vector< std::vector<double> > sr,
+  				    std::vector< std::vector<double> > ssm,
+				    std::vector<double> min,
+				    std::vector<double> max,
+				    int msod);
+
+	virtual void set_sample_parameters(int bs, int ts);
+
+	/*
+	 Defines initial ECPs, and sets up class
+
+	 @param[in] v Vector of initial gaussian(s) read in from ecp.template
+	 */
+	void set_starting_gaussians(gaussian v)
+	{
+		starting_gaussians = v;
+		calculate_ecps_to_test();
+	}
+
+	/*
+	 Takes in the details of the last search run, and moves on to the next batch
+
+	 @param[in] v Vector of ECPs just tested
+	 @param[in] n Index of the highest ranked ECP
+	 */
+	void set_ecps_tested(std::vector<gaussian> v, int n)
+	{
+		ecps_tested = v;
+		check_converged();
+	}
+
+	/*
+	 Method to print the search type being conducted, common with all other search methods
+
+	 No Param
+	 */
+	virtual void print_type()
+	{
+		if (latin_hypercube)
+		{
+			std::cout << "Performing a Latin Hypercube Search" << std::endl;
+		}
+		else
+		{
+			std::cout << "Performing a Sobol Sequence Search" << std::endl;
+		}
+	}
+
+protected:
+
+	bool latin_hypercube;
+	// Number of points handed out at once, and in total for the Latin hypercube
+	unsigned int batch_size;
+	unsigned int total_samples;
+	// Position in the sequence of the next point
+	unsigned long long sample_index;
+	unsigned long long sample_limit;
+	// Vectors
+	std::vector<gaussian> ecps_tested;
+	std::vector<double> minimums;
+	std::vector<double> maximums;
+	// Sobol direction numbers, by dimension (x) and bit (y)
+	std::vector< std::vector<unsigned int> > directions;
+	// Latin hypercube, points (x) by dimension (y) in the unit cube
+	std::vector< std::vector<double> > hypercube;
+
+	virtual void calculate_ecps_to_test();
+
+	/*
+	 Converged once the sequence or hypercube has run out,
+	 otherwise fill ecps_to_test with the next batch
+
+	 No param
+	 */
+	virtual void check_converged()
+	{
+		if (sample_index >= sample_limit)
+		{
+			converged = true;
+		}
+		else
+		{
+			ecps_to_test.clear();
+			calculate_next_batch();
+		}
+	}
+
+private:
+
+	void calculate_directions(unsigned int dimensions);
+
+	void calculate_hypercube(unsigned int dimensions);
+
+	void calculate_next_batch();
+
+	void get_sample(unsigned long long index, std::vector<double> *u);
+};
+
+#endif
+
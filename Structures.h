@@ -67,6 +67,8 @@ struct gaussian
 	int rank;
 	int index;
 	bool failed;
+	// Why the calculation failed, for reporting
+	std::string failure_reason;
 };
 
 #endif
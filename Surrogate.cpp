@@ -0,0 +1,409 @@
+/*
+ *  @file Surrogate.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include "Surrogate.h"
+
+using namespace std;
+
+// Fewest usable ECPs in the history before the model is trusted
+#define SURROGATE_TRAINING_MIN 10
+// Most recent usable ECPs used for fitting, which keeps the factorisation cheap
+#define SURROGATE_TRAINING_MAX 300
+
+/*
+ Constructor
+
+ @param[in] k Number of standard deviations an ECP must be predicted above the best to be screened out
+ */
+Surrogate::Surrogate(double k)
+{
+	kappa = k;
+	fitted = false;
+	best = 0.0;
+	output_mean = 0.0;
+	output_scale = 1.0;
+	length_scale = 1.0;
+	noise = 0.0;
+}
+
+/*
+ Fit the model to the history. Failed calculations and duds are left out,
+ as their function does not describe the ECP. The length scale and noise
+ are chosen from a small grid by the marginal likelihood
+
+ @param[in] v Vector of ECPs from the history
+ */
+void Surrogate::fit(const vector<gaussian> &v)
+{
+	Trace_Span span("surrogate fit","search");
+
+	fitted = false;
+	inputs.clear();
+	outputs.clear();
+
+	if (v.size() == 0)
+	{
+		return;
+	}
+
+	// The most recent ECP sets the shape, and the newest entries are nearest the search
+	const unsigned int dimensions = v.back().values.size();
+	vector<const gaussian*> training;
+
+	for (vector<gaussian>::size_type i = v.size(); i > 0; i--)
+	{
+		if (usable(v[i-1],dimensions))
+		{
+			training.push_back(&v[i-1]);
+
+			if (training.size() == SURROGATE_TRAINING_MAX)
+			{
+				break;
+			}
+		}
+	}
+
+	if ((dimensions == 0) || (training.size() < SURROGATE_TRAINING_MIN))
+	{
+		return;
+	}
+
+	// Scale each parameter to the range covered by the training set
+	lower.assign(dimensions,0.0);
+	range.assign(dimensions,0.0);
+
+	for (unsigned int d = 0; d < dimensions; d++)
+	{
+		double upper = training[0]->values[d].value;
+		lower[d] = upper;
+
+		for (vector<const gaussian*>::size_type i = 1; i < training.size(); i++)
+		{
+			lower[d] = min(lower[d],training[i]->values[d].value);
+			upper = max(upper,training[i]->values[d].value);
+		}
+
+		range[d] = upper - lower[d];
+
+		if (range[d] <= 0.0)
+		{
+			range[d] = 1.0;
+		}
+	}
+
+	// Standardise the functions
+	best = training[0]->function;
+	output_mean = 0.0;
+
+	for (vector<const gaussian*>::size_type i = 0; i < training.size(); i++)
+	{
+		best = min(best,training[i]->function);
+		output_mean += training[i]->function;
+	}
+
+	output_mean /= training.size();
+	output_scale = 0.0;
+
+	for (vector<const gaussian*>::size_type i = 0; i < training.size(); i++)
+	{
+		output_scale += pow(training[i]->function - output_mean,2);
+	}
+
+	output_scale = sqrt(output_scale / training.size());
+
+	if (output_scale <= 0.0)
+	{
+		output_scale = 1.0;
+	}
+
+	inputs.resize(training.size());
+	outputs.resize(training.size());
+
+	for (vector<const gaussian*>::size_type i = 0; i < training.size(); i++)
+	{
+		scale(*training[i],&inputs[i]);
+		outputs[i] = (training[i]->function - output_mean) / output_scale;
+	}
+
+	// Pick the hyperparameters that best explain the history
+	const double length_scales[] = {0.05, 0.1, 0.2, 0.4, 0.8, 1.6};
+	const double noises[] = {1e-6, 1e-4, 1e-2};
+	double likelihood_max = -HUGE_VAL;
+	vector< vector<double> > chol;
+	vector<double> a;
+
+	for (unsigned int i = 0; i < sizeof(length_scales) / sizeof(length_scales[0]); i++)
+	{
+		for (unsigned int j = 0; j < sizeof(noises) / sizeof(noises[0]); j++)
+		{
+			double likelihood = factorise(length_scales[i],noises[j],&chol,&a);
+
+			if (likelihood > likelihood_max)
+			{
+				likelihood_max = likelihood;
+				length_scale = length_scales[i];
+				noise = noises[j];
+				L.swap(chol);
+				alpha.swap(a);
+				fitted = true;
+			}
+		}
+	}
+}
+
+/*
+ Predict the function for an ECP
+
+ @param[in] g ECP to predict
+ @param[out] mean Predicted function
+ @param[out] deviation Standard deviation of the prediction
+ @return True if a prediction could be made
+ */
+bool Surrogate::predict(const gaussian &g, double *mean, double *deviation)
+{
+	if (!fitted || (g.values.size() != lower.size()))
+	{
+		return false;
+	}
+
+	const vector<double>::size_type n = inputs.size();
+	vector<double> x;
+	vector<double> k(n);
+	double mu = 0.0;
+
+	scale(g,&x);
+
+	for (vector<double>::size_type i = 0; i < n; i++)
+	{
+		k[i] = kernel(x,inputs[i],length_scale);
+		mu += k[i] * alpha[i];
+	}
+
+	// Forward substitution gives the reduction in variance from the training set
+	double variance = 1.0;
+
+	for (vector<double>::size_type i = 0; i < n; i++)
+	{
+		double sum = k[i];
+
+		for (vector<double>::size_type j = 0; j < i; j++)
+		{
+			sum -= L[i][j] * k[j];
+		}
+
+		k[i] = sum / L[i][i];
+		variance -= k[i] * k[i];
+	}
+
+	*mean = output_mean + output_scale * mu;
+	*deviation = output_scale * sqrt(max(variance,0.0));
+
+	return true;
+}
+
+/*
+ Check if an ECP is predicted to be clearly worse than the best in the history
+
+ @param[in] g ECP to check
+ @param[out] mean Predicted function
+ @return True if the ECP can be skipped
+ */
+bool Surrogate::screen(const gaussian &g, double *mean)
+{
+	double deviation = 0.0;
+
+	if (!predict(g,mean,&deviation))
+	{
+		return false;
+	}
+
+	return (*mean - kappa * deviation) > best;
+}
+
+/*
+ Add an ECP to the training set as if its function were the predicted mean.
+ The predictions elsewhere keep their mean, but are less uncertain nearby,
+ so a batch can be built up one ECP at a time before any are calculated
+
+ @param[in] g ECP to add
+ */
+void Surrogate::condition(const gaussian &g)
+{
+	if (!fitted || (g.values.size() != lower.size()))
+	{
+		return;
+	}
+
+	const vector<double>::size_type n = inputs.size();
+	vector<double> x;
+	vector<double> row(n + 1,0.0);
+	double mu = 0.0;
+	double diagonal = 1.0 + noise;
+
+	scale(g,&x);
+
+	// The new row of the Cholesky factor comes from forward substitution
+	for (vector<double>::size_type i = 0; i < n; i++)
+	{
+		const double k = kernel(x,inputs[i],length_scale);
+		double sum = k;
+
+		mu += k * alpha[i];
+
+		for (vector<double>::size_type j = 0; j < i; j++)
+		{
+			sum -= L[i][j] * row[j];
+		}
+
+		row[i] = sum / L[i][i];
+		diagonal -= row[i] * row[i];
+	}
+
+	if (diagonal <= 0.0)
+	{
+		return;
+	}
+
+	row[n] = sqrt(diagonal);
+
+	// With the function at the predicted mean, the existing weights still fit and the new one is zero
+	L.push_back(row);
+	inputs.push_back(x);
+	outputs.push_back(mu);
+	alpha.push_back(0.0);
+}
+
+/*
+ Check if an ECP from the history can be used for fitting
+
+ @param[in] g ECP from the history
+ @param[in] dimensions Number of parameters expected
+ @return True if the function is meaningful
+ */
+bool Surrogate::usable(const gaussian &g, unsigned int dimensions)
+{
+	return (!g.failed &&
+		(g.function != 888888) &&
+		(g.values.size() == dimensions));
+}
+
+/*
+ Scale the values of an ECP by the range of the training set
+
+ @param[in] g ECP to scale
+ @param[out] x Scaled values
+ */
+void Surrogate::scale(const gaussian &g, vector<double> *x)
+{
+	x->resize(lower.size());
+
+	for (vector<double>::size_type d = 0; d < lower.size(); d++)
+	{
+		(*x)[d] = (g.values[d].value - lower[d]) / range[d];
+	}
+}
+
+/*
+ Squared exponential kernel, with unit variance as the functions are standardised
+
+ @param[in] a First set of scaled values
+ @param[in] b Second set of scaled values
+ @param[in] l Length scale
+ @return Covariance between the two
+ */
+double Surrogate::kernel(const vector<double> &a, const vector<double> &b, double l)
+{
+	double r2 = 0.0;
+
+	for (vector<double>::size_type d = 0; d < a.size(); d++)
+	{
+		r2 += (a[d] - b[d]) * (a[d] - b[d]);
+	}
+
+	return exp(-0.5 * r2 / (l * l));
+}
+
+/*
+ Cholesky factorise the kernel matrix of the training set, and solve for the weights
+
+ @param[in] l Length scale
+ @param[in] n Noise added to the diagonal
+ @param[out] chol Lower triangular factor
+ @param[out] a Kernel matrix inverse applied to the outputs
+ @return Log marginal likelihood, or -HUGE_VAL if the matrix is not positive definite
+ */
+double Surrogate::factorise(double l, double n, vector< vector<double> > *chol, vector<double> *a)
+{
+	const vector<double>::size_type size = inputs.size();
+	vector< vector<double> > &c = *chol;
+
+	c.resize(size);
+
+	for (vector<double>::size_type i = 0; i < size; i++)
+	{
+		c[i].assign(i + 1,0.0);
+
+		for (vector<double>::size_type j = 0; j <= i; j++)
+		{
+			double sum = kernel(inputs[i],inputs[j],l);
+
+			if (i == j)
+			{
+				sum += n;
+			}
+
+			for (vector<double>::size_type k = 0; k < j; k++)
+			{
+				sum -= c[i][k] * c[j][k];
+			}
+
+			if (i == j)
+			{
+				if (sum <= 0.0)
+				{
+					return -HUGE_VAL;
+				}
+
+				c[i][i] = sqrt(sum);
+			}
+			else
+			{
+				c[i][j] = sum / c[j][j];
+			}
+		}
+	}
+
+	// Solve L z = y, then L^T a = z
+	a->assign(size,0.0);
+	double likelihood = 0.0;
+
+	for (vector<double>::size_type i = 0; i < size; i++)
+	{
+		double sum = outputs[i];
+
+		for (vector<double>::size_type j = 0; j < i; j++)
+		{
+			sum -= c[i][j] * (*a)[j];
+		}
+
+		(*a)[i] = sum / c[i][i];
+		likelihood -= 0.5 * (*a)[i] * (*a)[i] + log(c[i][i]);
+	}
+
+	for (vector<double>::size_type i = size; i > 0; i--)
+	{
+		double sum = (*a)[i-1];
+
+		for (vector<double>::size_type j = i; j < size; j++)
+		{
+			sum -= c[j][i-1] * (*a)[j];
+		}
+
+		(*a)[i-1] = sum / c[i-1][i-1];
+	}
+
+	return likelihood;
+}
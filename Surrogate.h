@@ -0,0 +1,109 @@
+/*
+ *  @Surrogate.h
+ *  fit_my_ecp
+ *
+ *  @brief Gaussian process model of the function over the ECP values, fitted to the history.
+ *  Used to screen out ECPs that are predicted to be clearly worse than the best found so far,
+ *  so that only promising ECPs are sent for a ChemShell calculation
+ *
+ */
+
+#ifndef SURROGATE_H
+#define SURROGATE_H
+
+#include <iostream>
+#include <vector>
+// Personal headers
+#include "Utils.h"
+#include "Structures.h"
+#include "Trace.h"
+
+class Surrogate {
+
+public:
+
+	/*
+	 Constructor
+
+	 No params
+	 */
+	Surrogate() { kappa = 3.0; fitted = false; best = 0.0; }
+
+	Surrogate(double k);
+
+	/*
+	 Deconstructor
+
+	 No params
+	 */
+	~Surrogate(){}
+
+	void fit(const std::vector<gaussian> &v);
+
+	bool predict(const gaussian &g, double *mean, double *deviation);
+
+	bool screen(const gaussian &g, double *mean);
+
+	void condition(const gaussian &g);
+
+	/*
+	 Check if the model could be fitted to the history
+
+	 @return True if there were enough usable ECPs in the history
+	 */
+	bool get_fitted()
+	{
+		return fitted;
+	}
+
+	/*
+	 Return the best function used to fit the model
+
+	 @return Lowest function in the training set
+	 */
+	double get_best()
+	{
+		return best;
+	}
+
+	/*
+	 Return the number of ECPs used to fit the model
+
+	 @return Size of the training set
+	 */
+	int get_training_size()
+	{
+		return inputs.size();
+	}
+
+private:
+
+	// Number of standard deviations an ECP must be above the best to be screened out
+	double kappa;
+	bool fitted;
+	double best;
+	// Training set, with inputs scaled to the unit cube and functions standardised
+	std::vector< std::vector<double> > inputs;
+	std::vector<double> outputs;
+	std::vector<double> lower;
+	std::vector<double> range;
+	double output_mean;
+	double output_scale;
+	// Hyperparameters of the squared exponential kernel
+	double length_scale;
+	double noise;
+	// Cholesky factor of the kernel matrix, and the kernel matrix inverse applied to the outputs
+	std::vector< std::vector<double> > L;
+	std::vector<double> alpha;
+
+	bool usable(const gaussian &g, unsigned int dimensions);
+
+	void scale(const gaussian &g, std::vector<double> *x);
+
+	double kernel(const std::vector<double> &a, const std::vector<double> &b, double l);
+
+	double factorise(double l, double n, std::vector< std::vector<double> > *chol, std::vector<double> *a);
+};
+
+#endif
+
@@ -0,0 +1,392 @@
+/*
+ *  @file Synthetic_Outputs.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdio.h>
+#include <unistd.h>
+#include "Synthetic_Outputs.h"
+
+using namespace std;
+
+/*
+ Write a number as Fortran does, with a D for the exponent
+
+ @param[in] value Number
+ @param[in] precision Digits after the decimal point
+ @return string Formatted number
+ */
+string fortran_d(double value, int precision)
+{
+	char buffer[number_buffer_size];
+	snprintf(buffer,sizeof(buffer),"%.*E",precision,value);
+	string s = buffer;
+	s[s.find('E')] = 'D';
+	return s;
+}
+
+/*
+ Wait for the next SCF cycle, so the output is written at about the rate a real calculation would
+
+ @param[in/out] out Output being written
+ @param[in] seconds Seconds per cycle
+ */
+static void next_cycle(ofstream &out, double seconds)
+{
+	out.flush();
+
+	if (seconds > 0.0)
+	{
+		usleep((useconds_t) (seconds * 1.0e6));
+	}
+}
+
+/*
+ Number of centres in region 1, which make up the QM cluster
+
+ @param[in] o Output being written
+ @return int Centres
+ */
+static int qm_centres(const synthetic_output &o)
+{
+	int n = 0;
+
+	for (vector<int>::size_type i = 0; i < o.regions.size(); i++)
+	{
+		if (o.regions[i] == 1)
+		{
+			n++;
+		}
+	}
+
+	return n;
+}
+
+/*
+ Electrons in each spin. A restricted output has one set of orbitals, each holding two
+
+ @param[in] o Output being written
+ @param[in] spin 0 for alpha, 1 for beta
+ @return int Electrons
+ */
+static int spin_electrons(const synthetic_output &o, int spin)
+{
+	return o.occupied[(o.occupied.size() > 1) ? spin : 0];
+}
+
+/*
+ Write the distributed multipole analysis, as both programs print it through ChemShell.
+ The sites are read from the 16th line after the module banner, and region 1 comes
+ first, as the centres are listed in the punch file, then the sites around them
+
+ @param[in/out] out Output file
+ @param[in] o Output being written
+ */
+static void write_dma(ofstream &out, const synthetic_output &o)
+{
+	out << " distributed multipole analysis module" << endl;
+	out << " " << string(37,'=') << endl;
+	out << endl;
+	out << " multipole moments are referred to the site positions" << endl;
+	out << " maximum rank of multipoles     2" << endl;
+	out << " switch to grid integration     4" << endl;
+	for (int i = 0; i < 10; i++)
+	{
+		out << endl;
+	}
+
+	for (int region = 1; region <= 2; region++)
+	{
+		int site = 0;
+
+		for (vector<string>::size_type i = 0; i < o.labels.size(); i++)
+		{
+			if (o.regions[i] != region)
+			{
+				continue;
+			}
+
+			double q2 = 0.35 + o.dma_spread * fmod(0.618034 * site,1.0);
+
+			out << " site" << setprecision(6) << setw(14) << 0.1 * site << setw(12) << 0.0 << setw(12) << 0.0;
+			out << "    " << o.labels[i] << region << endl;
+			out << "                    Q00  = " << setprecision(6) << setw(12) << -0.1 * q2 << endl;
+			out << " |q1| = " << setw(12) << 0.1 * q2 << endl;
+			out << " |q2| = " << setw(12) << q2 << endl;
+			out << endl;
+			site++;
+		}
+	}
+
+	out << " end of distributed multipole analysis" << endl;
+}
+
+/*
+ Write a Gamess-UK output, as it would appear through a ChemShell QM/MM run,
+ with a table of MOs for each spin if unrestricted
+
+ @param[in] file Filename of the output
+ @param[in] o What to write
+ @return bool True if the calculation got to the end
+ */
+bool write_gamess_uk(string file, const synthetic_output &o)
+{
+	ofstream out(file.c_str());
+
+	if (!out)
+	{
+		cout << "Could not open output file: " << file << endl;
+		return false;
+	}
+
+	const bool unrestricted = (o.mo_energies.size() > 1);
+	const string rule = " " + string(78,'=');
+	const string mo_rule = " " + string(64,'=');
+
+	out << fixed;
+	out << " " << string(78,'*') << endl;
+	out << "                         GAMESS-UK (" << o.title << ")" << endl;
+	out << " " << string(78,'*') << endl;
+	out << endl;
+	out << "          molecular geometry" << endl;
+	out << endl;
+
+	for (vector<string>::size_type i = 0, site = 0; i < o.labels.size(); i++)
+	{
+		if (o.regions[i] == 1)
+		{
+			out << setw(6) << site + 1 << setprecision(7) << setw(16) << 0.1 * site << setw(16) << 0.0 << setw(16) << 0.0;
+			out << "   " << o.labels[i] << 1 << endl;
+			site++;
+		}
+	}
+
+	out << endl;
+	out << " Effective total no. of electrons = " << setw(6) << spin_electrons(o,0) + spin_electrons(o,1) << endl;
+	out << endl;
+	out << rule << endl;
+	out << " cycle           total       energy          electronic        energy" << endl;
+	out << "                 energy      change             energy         convergence" << endl;
+	out << rule << endl;
+
+	const int centres = qm_centres(o);
+	double previous = 0.0;
+
+	for (vector<double>::size_type i = 0; i < o.scf_energies.size(); i++)
+	{
+		double energy = o.scf_energies[i];
+		out << setw(6) << i + 1 << setw(6) << 0 << setw(4) << 0;
+		out << setprecision(8) << setw(18) << energy << setw(17) << energy - previous;
+		out << setw(17) << energy - 9.0 * centres << setw(14) << fabs(energy - previous) << endl;
+		previous = energy;
+		next_cycle(out,o.cycle_seconds);
+
+		if ((int) i + 1 == o.crash_cycle)
+		{
+			return false;
+		}
+	}
+
+	if (!o.converged)
+	{
+		out << endl;
+		out << " excessive number of iterations" << endl;
+		out << " error detected in scf" << endl;
+		return false;
+	}
+
+	out << rule << endl;
+	out << endl;
+	out << "          ----------------" << endl;
+	out << "          energy converged" << endl;
+	out << "          ----------------" << endl;
+	out << endl;
+	out << "          total energy (a.u.)  " << setprecision(10) << setw(20) << o.energy << endl;
+	out << endl;
+
+	for (vector< vector<double> >::size_type spin = 0; spin < o.mo_energies.size(); spin++)
+	{
+		const vector<double> &e = o.mo_energies[spin];
+		const int occupied = spin_electrons(o,spin);
+		const double occupancy = unrestricted ? 1.0 : 2.0;
+
+		if (unrestricted)
+		{
+			out << ((spin == 0) ? "          alpha set" : "          beta set") << endl;
+			out << endl;
+		}
+
+		out << mo_rule << endl;
+		out << "     m.o. irrep        orbital         orbital       orbital" << endl;
+		out << "                       energy (a.u.)   energy (e.v.)     occupancy" << endl;
+		out << mo_rule << endl;
+
+		for (vector<double>::size_type i = 0; i < e.size(); i++)
+		{
+			out << setw(8) << i + 1 << setw(5) << 1 << setprecision(8) << setw(16) << e[i];
+			out << setprecision(4) << setw(14) << e[i] * hartree_to_eV;
+			out << setw(14) << (((int) i < occupied) ? occupancy : 0.0) << endl;
+		}
+
+		out << mo_rule << endl;
+		out << endl;
+	}
+
+	if (o.dma)
+	{
+		write_dma(out,o);
+	}
+
+	out << " end of GAMESS program" << endl;
+
+	return true;
+}
+
+/*
+ Write an NWChem output, as it would appear through a ChemShell QM/MM run,
+ with Alpha and Beta MOs if spin polarised
+
+ @param[in] file Filename of the output
+ @param[in] o What to write
+ @return bool True if the calculation got to the end
+ */
+bool write_nwchem(string file, const synthetic_output &o)
+{
+	ofstream out(file.c_str());
+
+	if (!out)
+	{
+		cout << "Could not open output file: " << file << endl;
+		return false;
+	}
+
+	const bool unrestricted = (o.mo_energies.size() > 1);
+	const int alpha = spin_electrons(o,0);
+	const int beta = spin_electrons(o,1);
+
+	out << fixed;
+	out << "                                 NWChem DFT Module" << endl;
+	out << "                                 -----------------" << endl;
+	out << "                              (" << o.title << ")" << endl;
+	out << endl;
+	out << "          Wavefunction type:  " << (unrestricted ? "spin polarized." : "closed shell.") << endl;
+	out << "          No. of atoms     :" << setw(8) << qm_centres(o) << endl;
+	out << "          No. of electrons :" << setw(8) << alpha + beta << endl;
+	out << "           Alpha electrons :" << setw(8) << alpha << endl;
+	out << "            Beta electrons :" << setw(8) << beta << endl;
+	out << "          Charge           :     0" << endl;
+	out << "          Spin multiplicity:     " << alpha - beta + 1 << endl;
+	out << endl;
+	out << "         convergence    iter        energy       DeltaE   RMS-Dens  Diis-err    time" << endl;
+	out << "       ---------------- ----- ----------------- --------- --------- ---------  ------" << endl;
+
+	double previous = 0.0;
+
+	for (vector<double>::size_type i = 0; i < o.scf_energies.size(); i++)
+	{
+		double energy = o.scf_energies[i];
+		out << " d= 0,ls=0.0,diis" << setw(6) << i + 1 << setprecision(10) << setw(18) << energy;
+		out << "  " << fortran_d(energy - previous,2) << "  " << fortran_d(fabs(energy - previous) * 0.1,2);
+		out << "  " << fortran_d(fabs(energy - previous) * 0.5,2) << setprecision(1) << setw(8) << 0.1 * (i + 1) << endl;
+		previous = energy;
+		next_cycle(out,o.cycle_seconds);
+
+		if ((int) i + 1 == o.crash_cycle)
+		{
+			return false;
+		}
+	}
+
+	if (!o.converged)
+	{
+		const string rule = " " + string(72,'-');
+		out << endl;
+		out << rule << endl;
+		out << " dft_scf: failed to converge         0" << endl;
+		out << rule << endl;
+		out << rule << endl;
+		out << "  current input line : " << endl;
+		out << "     0: " << endl;
+		out << rule << endl;
+		return false;
+	}
+
+	out << endl;
+	out << "         Total DFT energy =" << setprecision(12) << setw(22) << o.energy << endl;
+	out << endl;
+
+	for (vector< vector<double> >::size_type spin = 0; spin < o.mo_energies.size(); spin++)
+	{
+		const vector<double> &e = o.mo_energies[spin];
+		const int occupied = spin_electrons(o,spin);
+		const double occupancy = unrestricted ? 1.0 : 2.0;
+
+		if (unrestricted)
+		{
+			out << "                    DFT Final " << ((spin == 0) ? "Alpha" : "Beta") << " Molecular Orbital Analysis" << endl;
+			out << "                    " << string((spin == 0) ? 42 : 41,'-') << endl;
+		}
+		else
+		{
+			out << "                       DFT Final Molecular Orbital Analysis" << endl;
+			out << "                       ------------------------------------" << endl;
+		}
+		out << endl;
+
+		for (vector<double>::size_type i = 0; i < e.size(); i++)
+		{
+			out << " Vector" << setw(6) << i + 1 << "  Occ=" << fortran_d(((int) i < occupied) ? occupancy : 0.0,6);
+			out << "  E=" << fortran_d(e[i],6) << endl;
+			out << "              MO Center=  0.0D+00,  0.0D+00,  0.0D+00, r^2= 1.0D+00" << endl;
+			out << endl;
+		}
+	}
+
+	if (o.dma)
+	{
+		write_dma(out,o);
+	}
+
+	out << " Task  times  cpu:        " << setprecision(1) << 0.1 * o.scf_energies.size() << "s" << endl;
+
+	return true;
+}
+
+/*
+ Write the gradients in the punch format ChemShell uses, one component to a line.
+ The directions are spread evenly over a sphere, so each centre points its own way
+
+ @param[in] file Filename of the gradients
+ @param[in] sizes Size of the gradient on each centre
+ @return bool True if the file was written
+ */
+bool write_gradients(string file, const vector<double> &sizes)
+{
+	ofstream out(file.c_str());
+
+	if (!out)
+	{
+		cout << "Could not open output file: " << file << endl;
+		return false;
+	}
+
+	out << "block = dense_real_matrix records = " << 3 * sizes.size() << endl;
+	out << setprecision(10);
+
+	for (vector<double>::size_type i = 0; i < sizes.size(); i++)
+	{
+		double z = 1.0 - 2.0 * (i + 0.5) / sizes.size();
+		double rho = sqrt(1.0 - z*z);
+		double phi = 2.399963 * i;
+
+		out << sizes[i] * rho * cos(phi) << endl;
+		out << sizes[i] * rho * sin(phi) << endl;
+		out << sizes[i] * z << endl;
+	}
+
+	return true;
+}
@@ -0,0 +1,56 @@
+/*
+ *  @Synthetic_Outputs.h
+ *  fit_my_ecp
+ *
+ *  @brief Writes made up Gamess-UK and NWChem outputs and gradient punch files,
+ *  laid out as ChemShell leaves them, so the parsers have something to read
+ *  when there is no QM code. Used by mock_chemsh and the parser benchmark
+ *
+ */
+
+#ifndef SYNTHETIC_OUTPUTS_H
+#define SYNTHETIC_OUTPUTS_H
+
+#include <string>
+#include <vector>
+// Personal headers
+#include "Utils.h"
+#include "Structures.h"
+
+/*
+ Everything a synthetic Gamess-UK or NWChem output is written from
+ */
+struct synthetic_output
+{
+	// Put after the program name, so the output can't be taken for a real one
+	std::string title;
+	// Total energy at each SCF cycle, and once converged
+	std::vector<double> scf_energies;
+	double energy;
+	// False if the SCF fails, which ends the output with the error the program gives
+	bool converged;
+	// Cycle after which the output stops, as if the program had died, or 0 to write it all
+	int crash_cycle;
+	// Seconds per SCF cycle, so the output grows about as fast as a real one would
+	double cycle_seconds;
+	// Orbital energies, lowest first, with one set for each spin if unrestricted
+	std::vector< std::vector<double> > mo_energies;
+	// Occupied orbitals in each set
+	std::vector<int> occupied;
+	// Label and region of each centre. The region 1 centres are the QM cluster
+	std::vector<std::string> labels;
+	std::vector<int> regions;
+	// Write a DMA site for each centre in regions 1 and 2, with quadrupoles spread this much
+	bool dma;
+	double dma_spread;
+};
+
+std::string fortran_d(double value, int precision);
+
+bool write_gamess_uk(std::string file, const synthetic_output &o);
+
+bool write_nwchem(std::string file, const synthetic_output &o);
+
+bool write_gradients(std::string file, const std::vector<double> &sizes);
+
+#endif
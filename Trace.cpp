@@ -0,0 +1,251 @@
+/*
+ *  @file Trace.cpp
+ *  fit_my_ecp
+ *
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "Trace.h"
+
+using namespace std;
+
+// The trace is written as it goes, so a run that is stopped still leaves most of it.
+// Viewers accept the event list without its closing bracket
+static ofstream trace_file;
+static bool trace_active = false;
+static bool trace_first_event = true;
+// Times are given from when the trace was opened
+static double trace_origin = 0.0;
+// When each lane of calculations is next free, so calculations run side by side do not overlap
+static vector<double> trace_lanes;
+
+// The driver is drawn on the first thread, and calculations on the ones after
+static const int trace_driver_thread = 0;
+// The trace is finished however the program ends
+static bool trace_close_registered = false;
+
+/*
+ Write one event, with a comma before it if it is not the first
+
+ @param[in] event JSON object for the event
+ */
+static void trace_write(const string &event)
+{
+	if (!trace_first_event)
+	{
+		trace_file << ",\n";
+	}
+
+	trace_file << event;
+	trace_first_event = false;
+}
+
+/*
+ Give a thread its name in the viewer
+
+ @param[in] thread Thread number
+ @param[in] name Name to show
+ */
+static void trace_name_thread(int thread, string name)
+{
+	ostringstream event;
+	event << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread;
+	event << ",\"args\":{\"name\":\"" << name << "\"}}";
+	trace_write(event.str());
+
+	ostringstream order;
+	order << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread;
+	order << ",\"args\":{\"sort_index\":" << thread << "}}";
+	trace_write(order.str());
+}
+
+/*
+ Start recording to a trace file. Anything already being recorded is finished first
+
+ @param[in] output Filename of the trace
+ */
+void trace_open(string output)
+{
+	trace_close();
+
+	if (!trace_close_registered)
+	{
+		atexit(trace_close);
+		trace_close_registered = true;
+	}
+
+	trace_file.open(output.c_str());
+
+	if (!trace_file.is_open())
+	{
+		cout << "Could not open trace file: " << output << endl;
+		cout << "Critical Error" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	trace_file << "[\n";
+	trace_active = true;
+	trace_first_event = true;
+	trace_origin = monotonic_seconds();
+	trace_lanes.clear();
+
+	ostringstream process;
+	process << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << trace_driver_thread;
+	process << ",\"args\":{\"name\":\"fit_my_ecp\"}}";
+	trace_write(process.str());
+	trace_name_thread(trace_driver_thread,"driver");
+}
+
+/*
+ Finish the trace file
+
+ No params
+ */
+void trace_close()
+{
+	if (!trace_active)
+	{
+		return;
+	}
+
+	trace_file << "\n]" << endl;
+	trace_file.close();
+	trace_active = false;
+}
+
+/*
+ Check if a trace is being recorded
+
+ @return bool True if trace_open has been called
+ */
+bool trace_enabled()
+{
+	return trace_active;
+}
+
+/*
+ Write an event which took place over a span of time
+
+ @param[in] name Name of the stage
+ @param[in] category Category of the stage
+ @param[in] thread Thread to draw it on
+ @param[in] start Start, from monotonic_seconds
+ @param[in] duration Seconds it took
+ @param[in] index Index of the ECP, or -1 if not for one ECP
+ @param[in] outcome How it ended, or empty if there is nothing to say
+ */
+static void trace_complete(const char *name, const char *category, int thread, double start, double duration, int index, string outcome)
+{
+	ostringstream event;
+	event << fixed << setprecision(3);
+	event << "{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread;
+	event << ",\"ts\":" << 1.0e6 * (start - trace_origin) << ",\"dur\":" << 1.0e6 * max(duration,0.0);
+
+	if ((index >= 0) || (outcome.length() > 0))
+	{
+		event << ",\"args\":{";
+
+		if (index >= 0)
+		{
+			event << "\"index\":" << index;
+		}
+
+		if (outcome.length() > 0)
+		{
+			// Keep the JSON valid whatever the text holds
+			string escaped = "";
+
+			for (string::size_type i = 0; i < outcome.length(); i++)
+			{
+				if ((outcome[i] == '"') || (outcome[i] == '\\'))
+				{
+					escaped += '\\';
+				}
+
+				if ((unsigned char) outcome[i] >= 0x20)
+				{
+					escaped += outcome[i];
+				}
+			}
+
+			event << ((index >= 0) ? "," : "") << "\"outcome\":\"" << escaped << "\"";
+		}
+
+		event << "}";
+	}
+
+	event << "}";
+	trace_write(event.str());
+}
+
+/*
+ Record a stage of the driver
+
+ @param[in] name Name of the stage
+ @param[in] category Category of the stage
+ @param[in] start Start, from monotonic_seconds
+ @param[in] duration Seconds it took
+ @param[in] index Index of the ECP, or -1 if not for one ECP
+ */
+void trace_span(const char *name, const char *category, double start, double duration, int index)
+{
+	if (!trace_active)
+	{
+		return;
+	}
+
+	trace_complete(name,category,trace_driver_thread,start,duration,index,"");
+}
+
+/*
+ Record a QM calculation. These run side by side, so each goes on the first
+ lane that is free for the whole time it ran
+
+ @param[in] name Name of the stage
+ @param[in] start Start, from monotonic_seconds
+ @param[in] duration Seconds it ran
+ @param[in] index Index of the ECP
+ @param[in] outcome How the calculation ended
+ */
+void trace_calculation(const char *name, double start, double duration, int index, string outcome)
+{
+	if (!trace_active)
+	{
+		return;
+	}
+
+	vector<double>::size_type lane = 0;
+
+	while ((lane < trace_lanes.size()) && (trace_lanes[lane] > start))
+	{
+		lane++;
+	}
+
+	if (lane == trace_lanes.size())
+	{
+		int thread = lane + 1;
+		trace_lanes.push_back(0.0);
+		trace_name_thread(thread,"calculations " + NumberToString(thread));
+	}
+
+	trace_lanes[lane] = start + duration;
+
+	trace_complete(name,"qm",lane + 1,start,duration,index,outcome);
+}
+
+/*
+ Push everything recorded so far out to the file
+
+ No params
+ */
+void trace_flush()
+{
+	if (trace_active)
+	{
+		trace_file.flush();
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ *  @Trace.h
+ *  fit_my_ecp
+ *
+ *  @brief Records how long each stage of the fitting takes, in the Chrome trace
+ *  event format. The file can be opened in chrome://tracing or ui.perfetto.dev,
+ *  where the driver's own work is laid out beside the QM calculations. Nothing is
+ *  recorded unless a trace file has been opened
+ *
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+// Personal headers
+#include "Utils.h"
+
+void trace_open(std::string output);
+
+void trace_close();
+
+bool trace_enabled();
+
+void trace_span(const char *name, const char *category, double start, double duration, int index = -1);
+
+void trace_calculation(const char *name, double start, double duration, int index, std::string outcome);
+
+void trace_flush();
+
+/*
+ Times the stage it is made in, from construction to the end of the scope,
+ and records it once the scope is left
+ */
+class Trace_Span {
+
+public:
+
+	/*
+	 Constructor
+
+	 @param[in] n Name of the stage
+	 @param[in] c Category, used to colour and filter in the viewer
+	 @param[in] i Index of the ECP being calculated, or -1 if not for one ECP
+	 */
+	Trace_Span(const char *n, const char *c, int i = -1)
+	{
+		name = n;
+		category = c;
+		index = i;
+		start = trace_enabled() ? monotonic_seconds() : 0.0;
+	}
+
+	/*
+	 Deconstructor, which records the stage
+
+	 No params
+	 */
+	~Trace_Span()
+	{
+		if (trace_enabled())
+		{
+			trace_span(name,category,start,monotonic_seconds() - start,index);
+		}
+	}
+
+private:
+
+	const char *name;
+	const char *category;
+	int index;
+	double start;
+};
+
+#endif
@@ -1,5 +1,9 @@
 #include "Utils.h"
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
 /**
 Updates:
 15/04/2012
@@ -146,6 +150,132 @@ void find_character_end(const string &s, unsigned int &i)
 		}
 }
 
+/**
+ Skip the leading whitespace and plus sign that >> would accept,
+ but from_chars doesn't
+**/
+static const char *number_start(const char *first, const char *last)
+{
+	while ((first < last) && isspace((unsigned char) *first))
+	{
+		first++;
+	}
+
+	if ((first < last) && (*first == '+'))
+	{
+		first++;
+	}
+
+	return first;
+}
+
+bool parse_number(const char *first, const char *last, double &val)
+// Read a double from text without allocating
+// Inputs: first, last - Range of text
+//         double(val) - Returns the number, or zero if there isn't one
+{
+	first = number_start(first,last);
+	from_chars_result r = from_chars(first,last,val);
+
+	if (r.ec != errc())
+	{
+		val = 0.0;
+		return false;
+	}
+
+	// Fortran writes exponents as 1.0D+00, so swap for an E and read again
+	if ((r.ptr < last) && ((*r.ptr == 'D') || (*r.ptr == 'd')) && (r.ptr-first < number_buffer_size*2))
+	{
+		char text[number_buffer_size*2];
+		size_t length = min((size_t) (last-first),sizeof(text));
+		memcpy(text,first,length);
+		text[r.ptr-first] = 'E';
+		from_chars(text,text+length,val);
+	}
+
+	return true;
+}
+
+bool parse_number(const char *first, const char *last, int &val)
+// Read an int from text without allocating
+// Inputs: first, last - Range of text
+//         int(val) - Returns the number, or zero if there isn't one
+{
+	first = number_start(first,last);
+
+	if (from_chars(first,last,val).ec != errc())
+	{
+		val = 0;
+		return false;
+	}
+
+	return true;
+}
+
+bool parse_number(const char *first, const char *last, long &val)
+// Read a long from text without allocating
+// Inputs: first, last - Range of text
+//         long(val) - Returns the number, or zero if there isn't one
+{
+	first = number_start(first,last);
+
+	if (from_chars(first,last,val).ec != errc())
+	{
+		val = 0;
+		return false;
+	}
+
+	return true;
+}
+
+size_t format_number(char *buffer, double val, int precision)
+// Write a double as text without allocating
+// Inputs: char(buffer) - At least number_buffer_size long
+//         double(val) - Number
+//         int(precision) - Significant figures, or round_trip_precision for an exact copy
+// Output: size_t - Length written
+{
+	to_chars_result r;
+
+	if (precision == round_trip_precision)
+	{
+		r = to_chars(buffer,buffer+number_buffer_size,val);
+	}
+	else
+	{
+		r = to_chars(buffer,buffer+number_buffer_size,val,chars_format::general,precision);
+	}
+
+	return r.ptr - buffer;
+}
+
+size_t format_number(char *buffer, int val, int precision)
+// Write an int as text without allocating
+// Inputs: char(buffer) - At least number_buffer_size long
+//         int(val) - Number
+// Output: size_t - Length written
+{
+	return to_chars(buffer,buffer+number_buffer_size,val).ptr - buffer;
+}
+
+size_t format_number(char *buffer, long val, int precision)
+// Write a long as text without allocating
+// Inputs: char(buffer) - At least number_buffer_size long
+//         long(val) - Number
+// Output: size_t - Length written
+{
+	return to_chars(buffer,buffer+number_buffer_size,val).ptr - buffer;
+}
+
+size_t format_number(char *buffer, unsigned long val, int precision)
+// Write an unsigned long as text without allocating
+// Inputs: char(buffer) - At least number_buffer_size long
+//         long(val) - Number
+// Output: size_t - Length written
+{
+	return to_chars(buffer,buffer+number_buffer_size,val).ptr - buffer;
+}
+
 bool cmpStr(const string &s1, const string &s2)
 // Compares two strings and returns true or false
 // Inputs: s1 - String 1
@@ -170,22 +300,33 @@ double diffclock(clock_t clock1,clock_t clock2)
 	return diffms;
 } 
 
-int randomNumber(int hi, int *idum)
+double monotonic_seconds()
+// Wall clock time which never goes backwards, for timing calculations, trace events and benchmarks.
+// Every timer uses this one, so times from each can be set side by side
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec;
+}
+
+int randomNumber(int hi, int *idum, random_stream *stream)
 // Scales random number to max possible
 // Input: int (hi) - max possible
+//        random_stream(stream) - Stream to draw from, or NULL for the shared one
 // Output: int - answer
 {	
 	// return range [0..hi-1]
-	return int(randomNumber(idum)*hi); // implicit cast and truncation in return
+	return int(randomNumber(idum,stream)*hi); // implicit cast and truncation in return
 }
 
-double randomNumberF(double hi, int *idum)
+double randomNumberF(double hi, int *idum, random_stream *stream)
 // Scales random number to max possible
 // Input: int (hi) - max possible
+//        random_stream(stream) - Stream to draw from, or NULL for the shared one
 // Output: int - answer
 {	
 	// return range [0..hi-1]
-	return double(randomNumber(idum)*hi); // implicit cast and truncation in return
+	return double(randomNumber(idum,stream)*hi); // implicit cast and truncation in return
 }
 
 // This has been copied from Numerical Recipes in C
@@ -194,46 +335,46 @@ double randomNumberF(double hi, int *idum)
 #define MZ 0
 #define FAC (1.0/MBIG)
 
-double randomNumber(int *idum)
+double randomNumber(int *idum, random_stream *stream)
 // Get random number between 0 and 1. 
 // As implemented in Numerical Recipes in C
 // Inputs:  int seed value (must be negative)
+//          random_stream(stream) - Stream to draw from, or NULL for the shared one
 // Returns: double
 // int *idum;
 {
-	static int inext,inextp;
-	static long ma[56];
-	static int iff=0;
+	static random_stream shared = {0,0,{0},false};
+	random_stream &r = (stream != NULL) ? *stream : shared;
 	long mj,mk;
 	int i,ii,k;
 	
-	if (*idum < 0 || iff == 0) {
-		iff=1;
+	if (*idum < 0 || !r.seeded) {
+		r.seeded=true;
 		mj=MSEED-(*idum < 0 ? -*idum : *idum);
 		mj %= MBIG;
-		ma[55]=mj;
+		r.ma[55]=mj;
 		mk=1;
 		for (i=1;i<=54;i++) {
 			ii=(21*i) % 55;
-			ma[ii]=mk;
+			r.ma[ii]=mk;
 			mk=mj-mk;
 			if (mk < MZ) mk += MBIG;
-				mj=ma[ii];
+				mj=r.ma[ii];
 				}
 		for (k=1;k<=4;k++)
 			for (i=1;i<=55;i++) {
-				ma[i] -= ma[1+(i+30) % 55];
-				if (ma[i] < MZ) ma[i] += MBIG;
+				r.ma[i] -= r.ma[1+(i+30) % 55];
+				if (r.ma[i] < MZ) r.ma[i] += MBIG;
 					}
-		inext=0;
-		inextp=31;
+		r.inext=0;
+		r.inextp=31;
 		*idum=1;
 	}
-	if (++inext == 56) inext=1;
-	if (++inextp == 56) inextp=1;
-	mj=ma[inext]-ma[inextp];
+	if (++r.inext == 56) r.inext=1;
+	if (++r.inextp == 56) r.inextp=1;
+	mj=r.ma[r.inext]-r.ma[r.inextp];
 	if (mj < MZ) mj += MBIG;
-	ma[inext]=mj;
+	r.ma[r.inext]=mj;
 	// cout << "Random Number Generated: " << mj*FAC << endl;
 	return mj*FAC;
 }
@@ -13,38 +13,48 @@
 #define tab '\t'
 #define newline '\n'
 
+// Allocation free conversions between numbers and text, which don't depend on the locale.
+// Parsing skips leading whitespace and stops at the end of the number, like >> does,
+// and Fortran D exponents are accepted. Failures leave zero behind.
+bool parse_number(const char *first, const char *last, double &val);
+bool parse_number(const char *first, const char *last, int &val);
+bool parse_number(const char *first, const char *last, long &val);
+// Formatting writes at most number_buffer_size characters and returns the length used.
+// Precision is as for printf %g; round_trip_precision gives the shortest text
+// that reads back to exactly the same double. Precision is ignored for integers.
+const int number_buffer_size = 32;
+const int round_trip_precision = -1;
+size_t format_number(char *buffer, double val, int precision = 6);
+size_t format_number(char *buffer, int val, int precision = 6);
+size_t format_number(char *buffer, long val, int precision = 6);
+size_t format_number(char *buffer, unsigned long val, int precision = 6);
+
 template<class T>
 void StringToNumber(const std::string &s, T &val)
 {
-	std::stringstream os;
-	os << s;
-	os >> val;
+	parse_number(s.data(),s.data()+s.size(),val);
 }
 
 template<class T>
 void NumberToString(const T &val, std::string &s)
 {
-	std::stringstream os;
-	os << val;
-	os >> s;
+	char buffer[number_buffer_size];
+	s.assign(buffer,format_number(buffer,val));
 }
 
 template<class T>
 void NumberToString(const T &val, std::string &s, int precision)
 {
-        std::stringstream os;
-        os << std::setprecision(precision) << val;
-        os >> s;
+	char buffer[number_buffer_size];
+	s.assign(buffer,format_number(buffer,val,precision));
 }
 
 template<class T>
 T StringToNumber(const std::string &s)
 {
 	T val;
-	std::stringstream os;
 	
-	os << s;
-	os >> val;
+	parse_number(s.data(),s.data()+s.size(),val);
 	
 	return val;
 }
@@ -52,25 +62,17 @@ T StringToNumber(const std::string &s)
 template<class T>
 std::string NumberToString(T &val)
 {
-	std::string s;
-	std::stringstream os;
-	
-	os << val;
-	os >> s;
+	char buffer[number_buffer_size];
 	
-	return s;
+	return std::string(buffer,format_number(buffer,val));
 }
 
 template<class T>
 std::string NumberToString(T &val, int precision)
 {
-        std::string s;
-        std::stringstream os;
-
-        os << std::setprecision(precision) << val;
-        os >> s;
+	char buffer[number_buffer_size];
 
-        return s;
+	return std::string(buffer,format_number(buffer,val,precision));
 }
 
 //struct vec3d
@@ -95,10 +97,21 @@ bool cmpStr(const std::string &s1, const std::string &s2);
 
 double diffclock(clock_t clock1,clock_t clock2);
 
-int randomNumber(int hi, int *idum);
+double monotonic_seconds();
+
+// State of one stream of random numbers. Searches share one stream unless given their own
+struct random_stream
+{
+	int inext;
+	int inextp;
+	long ma[56];
+	bool seeded;
+};
+
+int randomNumber(int hi, int *idum, random_stream *stream = NULL);
 
-double randomNumberF(double hi, int *idum);
+double randomNumberF(double hi, int *idum, random_stream *stream = NULL);
 
-double randomNumber(int *idum);
+double randomNumber(int *idum, random_stream *stream = NULL);
 
 #endif